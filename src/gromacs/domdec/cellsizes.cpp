@@ -47,6 +47,8 @@
 
 #include "config.h"
 
+#include <algorithm>
+
 #include "gromacs/gmxlib/network.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdtypes/commrec.h"
@@ -566,9 +568,13 @@ static void set_dd_cell_sizes_dlb_root(gmx_domdec_t*      dd,
                                        int64_t            step)
 {
     gmx_domdec_comm_t* comm    = dd->comm;
-    constexpr real     c_relax = 0.5;
     int                range[] = { 0, 0 };
 
+    /* The limits and scaling factors for the adaptive under-relaxation */
+    constexpr real c_minRelaxation      = 0.125;
+    constexpr real c_relaxationDecrease = 0.5;
+    constexpr real c_relaxationIncrease = 1.25;
+
     /* Convert the maximum change from the input percentage to a fraction */
     const real change_limit = comm->ddSettings.dlb_scale_lim * 0.01;
 
@@ -589,38 +595,93 @@ static void set_dd_cell_sizes_dlb_root(gmx_domdec_t*      dd,
         {
             cell_size[i] = 1.0 / ncd;
         }
+        rowMaster->relaxation = c_dlbMaxRelaxation;
+        std::fill(rowMaster->previousChange.begin(), rowMaster->previousChange.end(), 0);
     }
     else if (dd_load_count(comm) > 0)
     {
-        real load_aver  = comm->load[d].sum_m / ncd;
-        real change_max = 0;
-        real load_i;
-        real change;
+        const float* load  = comm->load[d].load;
+        const int    nload = comm->load[d].nload;
+
+        real loadSum = 0;
         for (int i = 0; i < ncd; i++)
         {
-            /* Determine the relative imbalance of cell i */
-            load_i         = comm->load[d].load[i * comm->load[d].nload + 2];
-            real imbalance = (load_i - load_aver) / (load_aver > 0 ? load_aver : 1);
-            /* Determine the change of the cell size using underrelaxation */
-            change     = -c_relax * imbalance;
-            change_max = std::max(change_max, std::max(change, -change));
+            loadSum += load[i * nload + 2];
         }
+
+        /* Predict the cell boundaries that balance the load, assuming
+         * that the load is distributed homogeneously within each cell.
+         * We store the relative change of the size of each cell in cell_size.
+         */
+        int  cell          = 0;
+        real cellLoadBegin = 0;
+        real boundaryPrev  = 0;
+        for (int i = 0; i < ncd; i++)
+        {
+            real boundary = 1;
+            if (i < ncd - 1 && loadSum > 0)
+            {
+                const real targetLoad = ((i + 1) * loadSum) / ncd;
+                while (cell < ncd - 1 && cellLoadBegin + load[cell * nload + 2] <= targetLoad)
+                {
+                    cellLoadBegin += load[cell * nload + 2];
+                    cell++;
+                }
+                const real cellLoad = load[cell * nload + 2];
+                real       fraction = 0;
+                if (cellLoad > 0)
+                {
+                    fraction = std::clamp<real>((targetLoad - cellLoadBegin) / cellLoad, 0, 1);
+                }
+                boundary = rowMaster->cellFrac[cell]
+                           + fraction * (rowMaster->cellFrac[cell + 1] - rowMaster->cellFrac[cell]);
+            }
+            else if (i < ncd - 1)
+            {
+                boundary = rowMaster->cellFrac[i + 1];
+            }
+            cell_size[i] = (boundary - boundaryPrev)
+                                   / (rowMaster->cellFrac[i + 1] - rowMaster->cellFrac[i])
+                           - 1;
+            boundaryPrev = boundary;
+        }
+
+        /* When the predicted changes reverse the changes of the previous
+         * step, the load measurements are dominated by noise or the load
+         * is not homogeneous within cells, so we increase the damping.
+         * Otherwise we gradually decrease the damping again.
+         */
+        real changeProduct = 0;
+        real change_max    = 0;
+        for (int i = 0; i < ncd; i++)
+        {
+            changeProduct += cell_size[i] * rowMaster->previousChange[i];
+            change_max = std::max(change_max, std::abs(cell_size[i]));
+        }
+        if (changeProduct < 0)
+        {
+            rowMaster->relaxation =
+                    std::max(rowMaster->relaxation * c_relaxationDecrease, c_minRelaxation);
+        }
+        else
+        {
+            rowMaster->relaxation =
+                    std::min(rowMaster->relaxation * c_relaxationIncrease, c_dlbMaxRelaxation);
+        }
+
         /* Limit the amount of scaling.
          * We need to use the same rescaling for all cells in one row,
          * otherwise the load balancing might not converge.
          */
-        real sc = c_relax;
-        if (change_max > change_limit)
+        real sc = rowMaster->relaxation;
+        if (sc * change_max > change_limit)
         {
-            sc *= change_limit / change_max;
+            sc = change_limit / change_max;
         }
         for (int i = 0; i < ncd; i++)
         {
-            /* Determine the relative imbalance of cell i */
-            load_i         = comm->load[d].load[i * comm->load[d].nload + 2];
-            real imbalance = (load_i - load_aver) / (load_aver > 0 ? load_aver : 1);
-            /* Determine the change of the cell size using underrelaxation */
-            change       = -sc * imbalance;
+            const real change            = sc * cell_size[i];
+            rowMaster->previousChange[i] = change;
             cell_size[i] = (rowMaster->cellFrac[i + 1] - rowMaster->cellFrac[i]) * (1 + change);
         }
     }
@@ -46,8 +46,11 @@
 
 #include "config.h"
 
+#include <vector>
+
 #include "gromacs/domdec/domdec_network.h"
 #include "gromacs/math/vec.h"
+#include "gromacs/mdlib/gmx_omp_nthreads.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/utility/fatalerror.h"
 
@@ -139,6 +142,18 @@ static void dd_collect_cg(gmx_domdec_t* dd, const t_state* state_local)
     dd->comm->master_cg_ddp_count = state_local->ddp_count;
 }
 
+/*! \brief Copies the home atom vector \p buffer of a domain to the global vector \p v */
+static void copyToGlobalOrder(gmx::ArrayRef<const int>       globalAtoms,
+                              gmx::ArrayRef<const gmx::RVec> buffer,
+                              gmx::ArrayRef<gmx::RVec>       v)
+{
+    int localAtom = 0;
+    for (const int& globalAtom : globalAtoms)
+    {
+        copy_rvec(buffer[localAtom++], v[globalAtom]);
+    }
+}
+
 static void dd_collect_vec_sendrecv(gmx_domdec_t*                  dd,
                                     gmx::ArrayRef<const gmx::RVec> lv,
                                     gmx::ArrayRef<gmx::RVec>       v)
@@ -155,39 +170,50 @@ static void dd_collect_vec_sendrecv(gmx_domdec_t*                  dd,
     {
         AtomDistribution& ma = *dd->ma;
 
-        int rank      = dd->masterrank;
-        int localAtom = 0;
-        for (const int& globalAtom : ma.domainGroups[rank].atomGroups)
+        GMX_RELEASE_ASSERT(v.data() != ma.rvecBuffer.data(),
+                           "We need different communication and return buffers");
+
+        /* We receive from all ranks at once into consecutive parts of
+         * the communication buffer, so we might need to increase its size.
+         */
+        std::vector<int> bufferOffset(dd->nnodes + 1, 0);
+        for (int rank = 0; rank < dd->nnodes; rank++)
         {
-            copy_rvec(lv[localAtom++], v[globalAtom]);
+            const int numAtoms = (rank != dd->rank ? ma.domainGroups[rank].numAtoms : 0);
+            bufferOffset[rank + 1] = bufferOffset[rank] + numAtoms;
+        }
+        if (static_cast<size_t>(bufferOffset[dd->nnodes]) > ma.rvecBuffer.size())
+        {
+            ma.rvecBuffer.resize(bufferOffset[dd->nnodes]);
         }
 
+#if GMX_MPI
+        std::vector<MPI_Request> requests(dd->nnodes, MPI_REQUEST_NULL);
         for (int rank = 0; rank < dd->nnodes; rank++)
         {
             if (rank != dd->rank)
             {
-                const auto& domainGroups = ma.domainGroups[rank];
-
-                GMX_RELEASE_ASSERT(v.data() != ma.rvecBuffer.data(),
-                                   "We need different communication and return buffers");
+                MPI_Irecv(ma.rvecBuffer.data() + bufferOffset[rank],
+                          ma.domainGroups[rank].numAtoms * sizeof(rvec), MPI_BYTE, rank, rank,
+                          dd->mpi_comm_all, &requests[rank]);
+            }
+        }
+#endif
 
-                /* When we send/recv instead of scatter/gather, we might need
-                 * to increase the communication buffer size here.
-                 */
-                if (static_cast<size_t>(domainGroups.numAtoms) > ma.rvecBuffer.size())
-                {
-                    ma.rvecBuffer.resize(domainGroups.numAtoms);
-                }
+        /* Reorder our own atoms while the other ranks send theirs */
+        copyToGlobalOrder(ma.domainGroups[dd->rank].atomGroups, lv, v);
 
+        for (int rank = 0; rank < dd->nnodes; rank++)
+        {
+            if (rank != dd->rank)
+            {
 #if GMX_MPI
-                MPI_Recv(ma.rvecBuffer.data(), domainGroups.numAtoms * sizeof(rvec), MPI_BYTE, rank,
-                         rank, dd->mpi_comm_all, MPI_STATUS_IGNORE);
+                MPI_Wait(&requests[rank], MPI_STATUS_IGNORE);
 #endif
-                int localAtom = 0;
-                for (const int& globalAtom : domainGroups.atomGroups)
-                {
-                    copy_rvec(ma.rvecBuffer[localAtom++], v[globalAtom]);
-                }
+                const auto& domainGroups = ma.domainGroups[rank];
+                const auto  buffer       = gmx::constArrayRefFromArray(
+                        ma.rvecBuffer.data() + bufferOffset[rank], domainGroups.numAtoms);
+                copyToGlobalOrder(domainGroups.atomGroups, buffer, v);
             }
         }
     }
@@ -213,14 +239,16 @@ static void dd_collect_vec_gatherv(gmx_domdec_t*                  dd,
     {
         const AtomDistribution& ma = *dd->ma;
 
-        int bufferAtom = 0;
+        /* The domains are independent, so we can reorder them in parallel */
+        const int numThreads = gmx_omp_nthreads_get(emntDomdec);
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
         for (int rank = 0; rank < dd->nnodes; rank++)
         {
             const auto& domainGroups = ma.domainGroups[rank];
-            for (const int& globalAtom : domainGroups.atomGroups)
-            {
-                copy_rvec(ma.rvecBuffer[bufferAtom++], v[globalAtom]);
-            }
+            const auto  buffer       = gmx::constArrayRefFromArray(
+                    ma.rvecBuffer.data() + displacements[rank] / sizeof(rvec),
+                    domainGroups.numAtoms);
+            copyToGlobalOrder(domainGroups.atomGroups, buffer, v);
         }
     }
 }
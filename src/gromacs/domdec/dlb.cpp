@@ -145,6 +145,11 @@ gmx_bool dd_dlb_is_locked(const gmx_domdec_t* dd)
     return (dd->comm->dlbState == DlbState::offTemporarilyLocked);
 }
 
+bool dd_dlb_is_comparing_cycles(const gmx_domdec_t* dd)
+{
+    return (dd->comm->dlbState == DlbState::onCanTurnOff || dd->comm->haveTurnedOffDlb);
+}
+
 void dd_dlb_lock(gmx_domdec_t* dd)
 {
     /* We can only lock the DLB when it is set to auto, otherwise don't do anything */
@@ -106,6 +106,14 @@ bool dd_dlb_is_on(const gmx_domdec_t* dd);
 /*! \brief Return if the DLB lock is set */
 bool dd_dlb_is_locked(const gmx_domdec_t* dd);
 
+/*! \brief Return if DLB=auto compares the cycles per step with and without DLB
+ *
+ * This is the case while DLB is on and can be turned off, and after
+ * turning DLB off until the cycles without DLB have been compared.
+ * Changes in the cost per step during this time bias the decision.
+ */
+bool dd_dlb_is_comparing_cycles(const gmx_domdec_t* dd);
+
 /*! \brief Set a lock such that with DLB=auto DLB cannot get turned on */
 void dd_dlb_lock(struct gmx_domdec_t* dd);
 
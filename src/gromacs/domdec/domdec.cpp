@@ -257,70 +257,117 @@ void dd_get_constraint_range(const gmx_domdec_t* dd, int* at_start, int* at_end)
     *at_end   = dd->comm->atomRanges.end(DDAtomRanges::Type::Constraints);
 }
 
-void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+/*! \brief Copies the coordinates to send with pulse \p ind along DD dimension index \p ddDimIndex
+ * to \p sendBuffer, applying the periodic shift when needed
+ */
+static void packCoordinatesToSend(const gmx_domdec_t&            dd,
+                                  int                            ddDimIndex,
+                                  const gmx_domdec_ind_t&        ind,
+                                  const matrix                   box,
+                                  gmx::ArrayRef<const gmx::RVec> x,
+                                  gmx::ArrayRef<gmx::RVec>       sendBuffer)
 {
-    wallcycle_start(wcycle, ewcMOVEX);
-
-    int                    nzone, nat_tot;
-    gmx_domdec_comm_t*     comm;
-    gmx_domdec_comm_dim_t* cd;
-    rvec                   shift = { 0, 0, 0 };
-    gmx_bool               bPBC, bScrew;
+    rvec shift = { 0, 0, 0 };
 
-    comm = dd->comm;
+    const int  dim    = dd.dim[ddDimIndex];
+    const bool bPBC   = (dd.ci[dim] == 0);
+    const bool bScrew = (bPBC && dd.unitCellInfo.haveScrewPBC && dim == XX);
+    if (bPBC)
+    {
+        copy_rvec(box[dim], shift);
+    }
 
-    nzone   = 1;
-    nat_tot = comm->atomRanges.numHomeAtoms();
-    for (int d = 0; d < dd->ndim; d++)
+    int n = 0;
+    if (!bPBC)
     {
-        bPBC   = (dd->ci[dd->dim[d]] == 0);
-        bScrew = (bPBC && dd->unitCellInfo.haveScrewPBC && dd->dim[d] == XX);
-        if (bPBC)
+        for (int j : ind.index)
         {
-            copy_rvec(box[dd->dim[d]], shift);
+            sendBuffer[n] = x[j];
+            n++;
         }
-        cd = &comm->cd[d];
-        for (const gmx_domdec_ind_t& ind : cd->ind)
+    }
+    else if (!bScrew)
+    {
+        for (int j : ind.index)
         {
-            DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
-            gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
-            int                       n          = 0;
-            if (!bPBC)
+            /* We need to shift the coordinates */
+            for (int d = 0; d < DIM; d++)
             {
-                for (int j : ind.index)
-                {
-                    sendBuffer[n] = x[j];
-                    n++;
-                }
+                sendBuffer[n][d] = x[j][d] + shift[d];
             }
-            else if (!bScrew)
-            {
-                for (int j : ind.index)
-                {
-                    /* We need to shift the coordinates */
-                    for (int d = 0; d < DIM; d++)
-                    {
-                        sendBuffer[n][d] = x[j][d] + shift[d];
-                    }
-                    n++;
-                }
-            }
-            else
+            n++;
+        }
+    }
+    else
+    {
+        for (int j : ind.index)
+        {
+            /* Shift x */
+            sendBuffer[n][XX] = x[j][XX] + shift[XX];
+            /* Rotate y and z.
+             * This operation requires a special shift force
+             * treatment, which is performed in calc_vir.
+             */
+            sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
+            sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
+            n++;
+        }
+    }
+}
+
+/*! \brief Copies the coordinates received with pulse \p ind from \p receiveBuffer
+ * to the locations of the atoms of the \p nzone zones in \p x
+ */
+static void unpackReceivedCoordinates(const gmx_domdec_ind_t&        ind,
+                                      int                            nzone,
+                                      gmx::ArrayRef<const gmx::RVec> receiveBuffer,
+                                      gmx::ArrayRef<gmx::RVec>       x)
+{
+    int j = 0;
+    for (int zone = 0; zone < nzone; zone++)
+    {
+        for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
+        {
+            x[i] = receiveBuffer[j++];
+        }
+    }
+}
+
+/*! \brief Communicates the coordinates of all pulses in all dimensions
+ *
+ * When the first pulse was started by dd_move_x_start(), that pulse
+ * is completed instead of communicated.
+ */
+static void moveCoordinates(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x)
+{
+    gmx_domdec_comm_t*          comm      = dd->comm;
+    DDFirstPulseCoordinateComm& firstComm = comm->firstPulseCoordinateComm;
+
+    int nzone   = 1;
+    int nat_tot = comm->atomRanges.numHomeAtoms();
+    for (int d = 0; d < dd->ndim; d++)
+    {
+        gmx_domdec_comm_dim_t* cd = &comm->cd[d];
+        for (const gmx_domdec_ind_t& ind : cd->ind)
+        {
+            if (firstComm.inFlight)
             {
-                for (int j : ind.index)
+                /* This is the first pulse, which is already in flight */
+                ddWaitForRequests(gmx::arrayRefFromArray(firstComm.requests.data(),
+                                                         firstComm.numRequests));
+                if (!cd->receiveInPlace)
                 {
-                    /* Shift x */
-                    sendBuffer[n][XX] = x[j][XX] + shift[XX];
-                    /* Rotate y and z.
-                     * This operation requires a special shift force
-                     * treatment, which is performed in calc_vir.
-                     */
-                    sendBuffer[n][YY] = box[YY][YY] - x[j][YY];
-                    sendBuffer[n][ZZ] = box[ZZ][ZZ] - x[j][ZZ];
-                    n++;
+                    unpackReceivedCoordinates(ind, nzone, firstComm.receiveBuffer, x);
                 }
+                firstComm.inFlight = false;
+                nat_tot += ind.nrecv[nzone + 1];
+                continue;
             }
 
+            DDBufferAccess<gmx::RVec> sendBufferAccess(comm->rvecBuffer, ind.nsend[nzone + 1]);
+            gmx::ArrayRef<gmx::RVec>& sendBuffer = sendBufferAccess.buffer;
+            packCoordinatesToSend(*dd, d, ind, box, x, sendBuffer);
+
             DDBufferAccess<gmx::RVec> receiveBufferAccess(
                     comm->rvecBuffer2, cd->receiveInPlace ? 0 : ind.nrecv[nzone + 1]);
 
@@ -338,19 +385,88 @@ void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, g
 
             if (!cd->receiveInPlace)
             {
-                int j = 0;
-                for (int zone = 0; zone < nzone; zone++)
-                {
-                    for (int i = ind.cell2at0[zone]; i < ind.cell2at1[zone]; i++)
-                    {
-                        x[i] = receiveBuffer[j++];
-                    }
-                }
+                unpackReceivedCoordinates(ind, nzone, receiveBuffer, x);
             }
             nat_tot += ind.nrecv[nzone + 1];
         }
         nzone += nzone;
     }
+}
+
+void dd_move_x(gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle)
+{
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    GMX_ASSERT(!dd->comm->firstPulseCoordinateComm.inFlight,
+               "dd_move_x_finish() should be called after dd_move_x_start()");
+
+    moveCoordinates(dd, box, x);
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+void dd_move_x_start(gmx_domdec_t*            dd,
+                     const matrix             box,
+                     gmx::ArrayRef<gmx::RVec> x,
+                     gmx_wallcycle*           wcycle)
+{
+    gmx_domdec_comm_t*          comm      = dd->comm;
+    DDFirstPulseCoordinateComm& firstComm = comm->firstPulseCoordinateComm;
+
+    GMX_ASSERT(!firstComm.inFlight, "Can not start coordinate communication twice");
+
+    if (!comm->ddSettings.overlapCoordinateCommunication || dd->ndim == 0)
+    {
+        return;
+    }
+
+    wallcycle_start(wcycle, ewcMOVEX);
+
+    /* The first pulse only sends home atoms, so it does not depend
+     * on other pulses and can be started right away.
+     */
+    const gmx_domdec_comm_dim_t& cd    = comm->cd[0];
+    const gmx_domdec_ind_t&      ind   = cd.ind[0];
+    const int                    nzone = 1;
+
+    firstComm.sendBuffer.resize(ind.nsend[nzone + 1]);
+    packCoordinatesToSend(*dd, 0, ind, box, x, firstComm.sendBuffer);
+
+    gmx::ArrayRef<gmx::RVec> receiveBuffer;
+    if (cd.receiveInPlace)
+    {
+        receiveBuffer = gmx::arrayRefFromArray(x.data() + comm->atomRanges.numHomeAtoms(),
+                                               ind.nrecv[nzone + 1]);
+    }
+    else
+    {
+        firstComm.receiveBuffer.resize(ind.nrecv[nzone + 1]);
+        receiveBuffer = firstComm.receiveBuffer;
+    }
+
+    firstComm.numRequests = ddIsendrecv(dd, 0, dddirBackward, firstComm.sendBuffer, receiveBuffer,
+                                        firstComm.requests);
+    firstComm.inFlight    = true;
+
+    wallcycle_stop(wcycle, ewcMOVEX);
+}
+
+void dd_move_x_finish(gmx_domdec_t*            dd,
+                      const matrix             box,
+                      gmx::ArrayRef<gmx::RVec> x,
+                      gmx_wallcycle*           wcycle)
+{
+    if (dd->comm->firstPulseCoordinateComm.inFlight)
+    {
+        /* The call count was already incremented by dd_move_x_start() */
+        wallcycle_start_nocount(wcycle, ewcMOVEX);
+    }
+    else
+    {
+        wallcycle_start(wcycle, ewcMOVEX);
+    }
+
+    moveCoordinates(dd, box, x);
 
     wallcycle_stop(wcycle, ewcMOVEX);
 }
@@ -1076,6 +1192,7 @@ static void make_load_communicator(gmx_domdec_t* dd, int dim_ind, ivec loc)
                     rowMaster.bounds.resize(dd->numCells[dim]);
                 }
                 rowMaster.buf_ncd.resize(dd->numCells[dim]);
+                rowMaster.previousChange.resize(dd->numCells[dim]);
             }
             else
             {
@@ -2874,6 +2991,9 @@ static DDSettings getDDSettings(const gmx::MDLogger&     mdlog,
     ddSettings.nstDDDumpGrid       = dd_getenv(mdlog, "GMX_DD_NST_DUMP_GRID", 0);
     ddSettings.DD_debug            = dd_getenv(mdlog, "GMX_DD_DEBUG", 0);
 
+    ddSettings.overlapCoordinateCommunication =
+            (dd_getenv(mdlog, "GMX_DD_NO_X_OVERLAP", 0) == 0);
+
     if (ddSettings.useSendRecv2)
     {
         GMX_LOG(mdlog.info)
@@ -75,7 +75,6 @@ struct gmx_domdec_zones_t;
 struct gmx_localtop_t;
 struct gmx_mtop_t;
 struct t_block;
-struct t_blocka;
 struct t_commrec;
 struct t_forcerec;
 struct t_inputrec;
@@ -216,6 +215,28 @@ void dd_cycles_add(const gmx_domdec_t* dd, float cycles, int ddCycl);
 /*! \brief Communicate the coordinates to the neighboring cells and do pbc. */
 void dd_move_x(struct gmx_domdec_t* dd, const matrix box, gmx::ArrayRef<gmx::RVec> x, gmx_wallcycle* wcycle);
 
+/*! \brief Start communicating the coordinates to the neighboring cells
+ *
+ * Starts non-blocking communication of the first pulse, which only
+ * involves home atoms. The home atom coordinates in \p x should not be
+ * changed and the halo atom coordinates should not be accessed until
+ * dd_move_x_finish() has been called with the same arguments.
+ */
+void dd_move_x_start(struct gmx_domdec_t*     dd,
+                     const matrix             box,
+                     gmx::ArrayRef<gmx::RVec> x,
+                     gmx_wallcycle*           wcycle);
+
+/*! \brief Complete the communication of the coordinates started by dd_move_x_start()
+ *
+ * Also communicates the remaining pulses. When dd_move_x_start() was not
+ * called or did not start communication, this does the same as dd_move_x().
+ */
+void dd_move_x_finish(struct gmx_domdec_t*     dd,
+                      const matrix             box,
+                      gmx::ArrayRef<gmx::RVec> x,
+                      gmx_wallcycle*           wcycle);
+
 /*! \brief Sum the forces over the neighboring cells.
  *
  * When fshift!=NULL the shift forces are updated to obtain
@@ -297,12 +318,6 @@ void dd_sort_local_top(gmx_domdec_t* dd, const t_mdatoms* mdatoms, gmx_localtop_
 /*! \brief Construct local state */
 void dd_init_local_state(struct gmx_domdec_t* dd, const t_state* state_global, t_state* local_state);
 
-/*! \brief Generate a list of links between atoms that are linked by bonded interactions
- *
- * Also stores whether atoms are linked in \p cginfo_mb.
- */
-t_blocka* makeBondedLinks(const gmx_mtop_t& mtop, gmx::ArrayRef<cginfo_mb_t> cginfo_mb);
-
 /*! \brief Calculate the maximum distance involved in 2-body and multi-body bonded interactions */
 void dd_bonded_cg_distance(const gmx::MDLogger&           mdlog,
                            const gmx_mtop_t*              mtop,
@@ -46,11 +46,18 @@
 
 #include "config.h"
 
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <vector>
+
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/mdlib/updategroupscog.h"
 #include "gromacs/timing/cyclecounter.h"
 #include "gromacs/topology/block.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/listoflists.h"
 
 struct t_commrec;
 
@@ -94,6 +101,9 @@ struct gmx_domdec_comm_dim_t
     bool receiveInPlace = false;
 };
 
+//! The maximum, and initial, under-relaxation factor for the DLB cell size changes
+constexpr real c_dlbMaxRelaxation = 0.5;
+
 /*! \brief Load balancing data along a dim used on the master rank of that dim */
 struct RowMaster
 {
@@ -119,6 +129,10 @@ struct RowMaster
     std::vector<Bounds> bounds;
     /**< State var.: is DLB limited in this row */
     bool dlbIsLimited = false;
+    /**< State var.: under-relaxation factor for the cell size changes */
+    real relaxation = c_dlbMaxRelaxation;
+    /**< State var.: relative cell size changes applied at the previous DLB step */
+    std::vector<real> previousChange;
     /**< Temp. var.  */
     std::vector<real> buf_ncd;
 };
@@ -402,6 +416,86 @@ public:
     gmx::ArrayRef<T> buffer; /**< The access to the memory buffer */
 };
 
+/*! \brief Links between atoms through bonded interactions
+ *
+ * Used for filtering the communication of atoms for bonded interactions.
+ * The links within molecules are stored per molecule type, with atom
+ * indices relative to the molecule, and only atoms with intermolecular
+ * bonded interactions have intermolecular link entries. This avoids
+ * memory usage on every rank that is proportional to the system size.
+ */
+struct BondedLinks
+{
+    //! The atom range and molecule type of a molecule block
+    struct MoleculeBlock
+    {
+        //! The global index of the first atom in the block
+        int globalAtomStart;
+        //! The number of atoms per molecule
+        int numAtomsPerMolecule;
+        //! The molecule type
+        int moleculeType;
+    };
+
+    /*! \brief Returns whether \p predicate returns true for any atom linked to \p globalAtom
+     *
+     * \p predicate is called with global atom indices.
+     */
+    template<typename Predicate>
+    bool anyLinkedAtom(int globalAtom, Predicate predicate) const
+    {
+        /* Find the molecule block, the blocks are sorted on atom index */
+        const auto blockIt = std::upper_bound(
+                moleculeBlocks.begin(), moleculeBlocks.end(), globalAtom,
+                [](int atom, const MoleculeBlock& block) { return atom < block.globalAtomStart; });
+        GMX_ASSERT(blockIt != moleculeBlocks.begin(), "We should have found a block");
+        const MoleculeBlock& block = *(blockIt - 1);
+
+        const int atomInBlock    = globalAtom - block.globalAtomStart;
+        const int atomInMolecule = atomInBlock % block.numAtomsPerMolecule;
+        const int moleculeStart  = globalAtom - atomInMolecule;
+        for (const int linkedAtom : moleculeTypeLinks[block.moleculeType][atomInMolecule])
+        {
+            if (predicate(moleculeStart + linkedAtom))
+            {
+                return true;
+            }
+        }
+
+        const auto atomIt = std::lower_bound(intermolecularLinkAtoms.begin(),
+                                             intermolecularLinkAtoms.end(), globalAtom);
+        if (atomIt != intermolecularLinkAtoms.end() && *atomIt == globalAtom)
+        {
+            const int index = atomIt - intermolecularLinkAtoms.begin();
+            for (const int linkedAtom : intermolecularLinks[index])
+            {
+                if (predicate(linkedAtom))
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    //! The non-empty molecule blocks, in order
+    std::vector<MoleculeBlock> moleculeBlocks;
+    //! For each molecule type, for each atom the atoms linked in the same molecule
+    std::vector<gmx::ListOfLists<int>> moleculeTypeLinks;
+    //! Sorted list of global atoms that have intermolecular links
+    std::vector<int> intermolecularLinkAtoms;
+    //! The global atoms linked to each atom in \p intermolecularLinkAtoms
+    gmx::ListOfLists<int> intermolecularLinks;
+};
+
+/*! \brief Generate the links between atoms that are linked by bonded interactions
+ *
+ * Also stores whether atoms are linked in \p cginfo_mb.
+ */
+std::unique_ptr<BondedLinks> makeBondedLinks(const gmx_mtop_t&          mtop,
+                                             gmx::ArrayRef<cginfo_mb_t> cginfo_mb);
+
 /*! \brief Temporary buffer for setting up communiation over one pulse and all zones in the halo */
 struct dd_comm_setup_work_t
 {
@@ -417,6 +511,26 @@ struct dd_comm_setup_work_t
     int nsend_zone = 0;
 };
 
+/*! \brief Communication of the coordinates of the first halo pulse
+ *
+ * The first pulse only sends home atoms, so it can be started with
+ * dd_move_x_start() before the computation on the home atoms and
+ * completed with dd_move_x_finish() after.
+ */
+struct DDFirstPulseCoordinateComm
+{
+    /**< Whether the communication is started and not yet completed */
+    bool inFlight = false;
+    /**< The coordinates to send */
+    std::vector<gmx::RVec> sendBuffer;
+    /**< The received coordinates, not used when receiving in place */
+    std::vector<gmx::RVec> receiveBuffer;
+    /**< The non-blocking communication requests */
+    std::array<MPI_Request, 2> requests;
+    /**< The number of requests in use */
+    int numRequests = 0;
+};
+
 /*! \brief Information about the simulated system */
 struct DDSystemInfo
 {
@@ -466,6 +580,8 @@ struct DDSettings
 {
     //! Use MPI_Sendrecv communication instead of non-blocking calls
     bool useSendRecv2 = false;
+    //! Overlap the coordinate communication of the first pulse with computation
+    bool overlapCoordinateCommunication = true;
 
     /* Information for managing the dynamic load balancing */
     //! Maximum DLB scaling per load balancing step in percent
@@ -567,7 +683,7 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
 
     /* Data for the optional filtering of communication of atoms for bonded interactions */
     /**< Links between atoms through bonded interactions */
-    t_blocka* bondedLinks = nullptr;
+    std::unique_ptr<BondedLinks> bondedLinks;
 
     /* The DLB state, possible values are defined above */
     DlbState dlbState;
@@ -664,6 +780,9 @@ struct gmx_domdec_comm_t // NOLINT (clang-analyzer-optin.performance.Padding)
     /**< Another rvec comm. buffer */
     DDBuffer<gmx::RVec> rvecBuffer2;
 
+    /**< Coordinate communication for the first pulse, can overlap with computation */
+    DDFirstPulseCoordinateComm firstPulseCoordinateComm;
+
     /* Communication buffers for local redistribution */
     /**< Charge group flag comm. buffers */
     std::array<std::vector<int>, DIM * 2> cggl_flag;
@@ -51,6 +51,8 @@
 #include <cstring>
 
 #include "gromacs/domdec/domdec_struct.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/gmxmpi.h"
 
 #include "domdec_internal.h"
@@ -132,6 +134,49 @@ template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<real>, gmx
 //! Specialization of extern template for gmx::RVec
 template void ddSendrecv(const gmx_domdec_t*, int, int, gmx::ArrayRef<gmx::RVec>, gmx::ArrayRef<gmx::RVec>);
 
+int ddIsendrecv(const gmx_domdec_t gmx_unused* dd,
+                int gmx_unused ddDimensionIndex,
+                int gmx_unused direction,
+                gmx::ArrayRef<gmx::RVec> gmx_unused sendBuffer,
+                gmx::ArrayRef<gmx::RVec> gmx_unused receiveBuffer,
+                gmx::ArrayRef<MPI_Request> gmx_unused requests)
+{
+    int numRequests = 0;
+#if GMX_MPI
+    GMX_ASSERT(requests.size() >= 2, "We need space for two requests");
+
+    int sendRank    = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 0 : 1];
+    int receiveRank = dd->neighbor[ddDimensionIndex][direction == dddirForward ? 1 : 0];
+
+    /* Use a different tag than ddSendrecv, since other communication
+     * can take place while these requests are in flight.
+     */
+    constexpr int mpiTag = 1;
+    if (!receiveBuffer.empty())
+    {
+        MPI_Irecv(receiveBuffer.data(), receiveBuffer.size() * sizeof(gmx::RVec), MPI_BYTE,
+                  receiveRank, mpiTag, dd->mpi_comm_all, &requests[numRequests++]);
+    }
+    if (!sendBuffer.empty())
+    {
+        MPI_Isend(sendBuffer.data(), sendBuffer.size() * sizeof(gmx::RVec), MPI_BYTE, sendRank,
+                  mpiTag, dd->mpi_comm_all, &requests[numRequests++]);
+    }
+#endif
+    return numRequests;
+}
+
+void ddWaitForRequests(gmx::ArrayRef<MPI_Request> gmx_unused requests)
+{
+#if GMX_MPI
+    if (!requests.empty())
+    {
+        // NOLINTNEXTLINE(clang-analyzer-optin.mpi.MPI-Checker)
+        MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    }
+#endif
+}
+
 void dd_sendrecv2_rvec(const struct gmx_domdec_t gmx_unused* dd,
                        int gmx_unused ddimind,
                        rvec gmx_unused* buf_s_fw,
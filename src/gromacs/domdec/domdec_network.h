@@ -50,6 +50,7 @@
 #define GMX_DOMDEC_DOMDEC_NETWORK_H
 
 #include "gromacs/math/vectypes.h"
+#include "gromacs/utility/gmxmpi.h"
 
 struct gmx_domdec_t;
 
@@ -145,6 +146,26 @@ extern template void ddSendrecv<gmx::RVec>(const gmx_domdec_t*      dd,
                                            gmx::ArrayRef<gmx::RVec> sendBuffer,
                                            gmx::ArrayRef<gmx::RVec> receiveBuffer);
 
+/*! \brief Starts moving a view of rvec values in the communication region
+ * one cell along the domain decomposition, without waiting for completion
+ *
+ * Moves in the dimension indexed by ddDimensionIndex, either forward
+ * (direction=dddirFoward) or backward (direction=dddirBackward).
+ * The buffers should not be accessed before ddWaitForRequests()
+ * has been called with the requests stored in \p requests.
+ *
+ * \returns The number of requests stored in \p requests, at most 2
+ */
+int ddIsendrecv(const gmx_domdec_t*        dd,
+                int                        ddDimensionIndex,
+                int                        direction,
+                gmx::ArrayRef<gmx::RVec>   sendBuffer,
+                gmx::ArrayRef<gmx::RVec>   receiveBuffer,
+                gmx::ArrayRef<MPI_Request> requests);
+
+//! Waits for the completion of the communication \p requests started by ddIsendrecv()
+void ddWaitForRequests(gmx::ArrayRef<MPI_Request> requests);
+
 /*! \brief Move revc's in the comm. region one cell along the domain decomposition
  *
  * Moves in dimension indexed by ddimind, simultaneously in the forward
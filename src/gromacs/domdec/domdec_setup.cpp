@@ -53,6 +53,10 @@
 #include <cmath>
 #include <cstdio>
 
+#include <algorithm>
+#include <array>
+#include <vector>
+
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/domdec/options.h"
@@ -267,6 +271,37 @@ static int guess_npme(const gmx::MDLogger& mdlog,
     return npme;
 }
 
+int suggestNumPmeOnlyRanks(int numRanks, int numPmeOnlyRanks, float pmeForceRatio)
+{
+    GMX_RELEASE_ASSERT(numPmeOnlyRanks > 0 && numPmeOnlyRanks < numRanks,
+                       "Can only make a suggestion based on a run with separate PME ranks");
+
+    /* Convert the measured time ratio to the fraction of the total work
+     * that is PME work, assuming both scale linearly with the rank count.
+     */
+    const float pmeWork = pmeForceRatio * numPmeOnlyRanks;
+    const float ratio   = pmeWork / (pmeWork + (numRanks - numPmeOnlyRanks));
+
+    if (!fits_pme_ratio(numRanks, numRanks / 2, ratio))
+    {
+        /* As in guess_npme(), with such a high PME load all ranks should do PME */
+        return 0;
+    }
+
+    /* Return the smallest count with enough PME ranks and a reasonable
+     * division over PP and PME ranks.
+     */
+    for (int npme = 1; npme <= numRanks / 2; npme++)
+    {
+        if (fits_pp_pme_perf(numRanks, npme, ratio))
+        {
+            return npme;
+        }
+    }
+
+    return numPmeOnlyRanks;
+}
+
 /*! \brief Return \p n divided by \p f rounded up to the next integer. */
 static int div_up(int n, int f)
 {
@@ -311,6 +346,143 @@ real comm_box_frac(const gmx::IVec& dd_nc, real cutoff, const gmx_ddbox_t& ddbox
     return comm_vol;
 }
 
+/*! \brief Histogram of the atom distribution over the unit cell
+ *
+ * Used for estimating the load imbalance of a DD grid with equally sized
+ * cells in systems with an inhomogeneous atom distribution.
+ */
+struct AtomDensityHistogram
+{
+    //! The number of bins along each dimension
+    gmx::IVec numBins = { 1, 1, 1 };
+    //! The atom count per bin, x is the major index
+    std::vector<int> count;
+    //! The total number of atoms
+    int numAtoms = 0;
+};
+
+/*! \brief The maximum number of histogram bins along a dimension */
+static constexpr int c_maxAtomDensityHistogramBins = 64;
+
+/*! \brief Returns the histogram of the fractional coordinates of \p x over the unit cell
+ *
+ * Along each dimension we use 4 bins for each of the maximum number of
+ * DD cells that fit, as given by \p cellSizeLimit.
+ */
+static AtomDensityHistogram makeAtomDensityHistogram(gmx::ArrayRef<const gmx::RVec> x,
+                                                     const matrix                   box,
+                                                     const gmx_ddbox_t&             ddbox,
+                                                     const real                     cellSizeLimit)
+{
+    AtomDensityHistogram histogram;
+
+    for (int d = 0; d < DIM; d++)
+    {
+        int maxNumCells = 1;
+        if (cellSizeLimit > 0)
+        {
+            maxNumCells = std::max(
+                    static_cast<int>(ddbox.box_size[d] * ddbox.skew_fac[d] / cellSizeLimit), 1);
+        }
+        histogram.numBins[d] = std::min(4 * maxNumCells, c_maxAtomDensityHistogramBins);
+    }
+    histogram.count.resize(
+            histogram.numBins[XX] * histogram.numBins[YY] * histogram.numBins[ZZ], 0);
+    histogram.numAtoms = x.ssize();
+
+    for (const gmx::RVec& xAtom : x)
+    {
+        /* Convert to fractional coordinates, the box is lower triangular */
+        rvec s;
+        for (int d = DIM - 1; d >= 0; d--)
+        {
+            if (d < ddbox.npbcdim)
+            {
+                real xd = xAtom[d];
+                for (int e = d + 1; e < DIM; e++)
+                {
+                    xd -= s[e] * box[e][d];
+                }
+                s[d] = xd / box[d][d];
+                s[d] -= std::floor(s[d]);
+            }
+            else
+            {
+                s[d] = (xAtom[d] - ddbox.box0[d]) / ddbox.box_size[d];
+            }
+        }
+
+        int bin = 0;
+        for (int d = 0; d < DIM; d++)
+        {
+            const int binD = static_cast<int>(s[d] * histogram.numBins[d]);
+            bin = bin * histogram.numBins[d] + std::clamp(binD, 0, histogram.numBins[d] - 1);
+        }
+        histogram.count[bin]++;
+    }
+
+    return histogram;
+}
+
+/*! \brief Returns the estimated load imbalance for the DD grid \p nc
+ *
+ * The imbalance is the maximum number of atoms in a cell divided by the
+ * average, minus 1. Bins are assigned to cells based on their centers.
+ */
+static float estimateLoadImbalance(const AtomDensityHistogram& histogram, const gmx::IVec& nc)
+{
+    std::vector<int> cellCount(nc[XX] * nc[YY] * nc[ZZ], 0);
+
+    std::array<std::vector<int>, DIM> binToCell;
+    for (int d = 0; d < DIM; d++)
+    {
+        binToCell[d].resize(histogram.numBins[d]);
+        for (int b = 0; b < histogram.numBins[d]; b++)
+        {
+            binToCell[d][b] = static_cast<int>(((b + 0.5) * nc[d]) / histogram.numBins[d]);
+        }
+    }
+
+    int bin = 0;
+    for (int bx = 0; bx < histogram.numBins[XX]; bx++)
+    {
+        for (int by = 0; by < histogram.numBins[YY]; by++)
+        {
+            for (int bz = 0; bz < histogram.numBins[ZZ]; bz++)
+            {
+                const int cell = (binToCell[XX][bx] * nc[YY] + binToCell[YY][by]) * nc[ZZ]
+                                 + binToCell[ZZ][bz];
+                cellCount[cell] += histogram.count[bin++];
+            }
+        }
+    }
+
+    const int   maxCount     = *std::max_element(cellCount.begin(), cellCount.end());
+    const float averageCount = histogram.numAtoms / static_cast<float>(cellCount.size());
+
+    return maxCount / averageCount - 1;
+}
+
+/*! \brief Returns the part of the estimated load imbalance of grid \p nc that
+ * is not expected to be resolved by statistical fluctuations and dynamic load balancing
+ */
+static float significantLoadImbalance(const AtomDensityHistogram& histogram, const gmx::IVec& nc)
+{
+    /* Dynamic load balancing can easily compensate this imbalance */
+    constexpr float c_dlbCompensatableImbalance = 0.2F;
+
+    const float numAtomsPerCell =
+            histogram.numAtoms / static_cast<float>(nc[XX] * nc[YY] * nc[ZZ]);
+    /* With few atoms per cell, the maximum count has large statistical
+     * fluctuations also for homogeneous systems, ignore three standard
+     * deviations of those.
+     */
+    const float tolerance =
+            c_dlbCompensatableImbalance + 3 / std::sqrt(std::max(numAtomsPerCell, 1.0F));
+
+    return std::max(estimateLoadImbalance(histogram, nc) - tolerance, 0.0F);
+}
+
 /*! \brief Return whether the DD inhomogeneous in the z direction */
 static gmx_bool inhomogeneous_z(const t_inputrec& ir)
 {
@@ -340,15 +512,16 @@ static float comm_pme_cost_vol(int npme, int a, int b, int c)
 }
 
 /*! \brief Estimate cost of communication for a possible domain decomposition. */
-static float comm_cost_est(real               limit,
-                           real               cutoff,
-                           const matrix       box,
-                           const gmx_ddbox_t& ddbox,
-                           int                natoms,
-                           const t_inputrec&  ir,
-                           float              pbcdxr,
-                           int                npme_tot,
-                           const gmx::IVec&   nc)
+static float comm_cost_est(real                        limit,
+                           real                        cutoff,
+                           const matrix                box,
+                           const gmx_ddbox_t&          ddbox,
+                           int                         natoms,
+                           const t_inputrec&           ir,
+                           float                       pbcdxr,
+                           int                         npme_tot,
+                           const AtomDensityHistogram* densityHistogram,
+                           const gmx::IVec&            nc)
 {
     gmx::IVec npme = { 1, 1, 1 };
     int       i, j, nk, overlap;
@@ -526,6 +699,16 @@ static float comm_cost_est(real               limit,
     comm_pme += comm_pme_cost_vol(npme[YY], ir.nky, ir.nkz, ir.nkx);
     comm_pme += comm_pme_cost_vol(npme[XX], ir.nkx, ir.nky, ir.nkz);
 
+    /* Add the cost of the load imbalance with an inhomogeneous atom distribution.
+     * We assume that computing the forces of an atom costs about as much
+     * as communicating its coordinate and force, which is an underestimate.
+     */
+    float cost_imbalance = 0;
+    if (densityHistogram != nullptr)
+    {
+        cost_imbalance = significantLoadImbalance(*densityHistogram, nc);
+    }
+
     /* Add cost of pbc_dx for bondeds */
     cost_pbcdx = 0;
     if ((nc[XX] == 1 || nc[YY] == 1) || (nc[ZZ] == 1 && ir.pbcType != PbcType::XY))
@@ -542,30 +725,33 @@ static float comm_cost_est(real               limit,
 
     if (debug)
     {
-        fprintf(debug, "nc %2d %2d %2d %2d %2d vol pp %6.4f pbcdx %6.4f pme %9.3e tot %9.3e\n",
-                nc[XX], nc[YY], nc[ZZ], npme[XX], npme[YY], comm_vol, cost_pbcdx,
-                comm_pme / (3 * natoms), comm_vol + cost_pbcdx + comm_pme / (3 * natoms));
+        fprintf(debug,
+                "nc %2d %2d %2d %2d %2d vol pp %6.4f pbcdx %6.4f imb %6.4f pme %9.3e tot %9.3e\n",
+                nc[XX], nc[YY], nc[ZZ], npme[XX], npme[YY], comm_vol, cost_pbcdx, cost_imbalance,
+                comm_pme / (3 * natoms),
+                comm_vol + cost_pbcdx + cost_imbalance + comm_pme / (3 * natoms));
     }
 
-    return 3 * natoms * (comm_vol + cost_pbcdx) + comm_pme;
+    return 3 * natoms * (comm_vol + cost_pbcdx + cost_imbalance) + comm_pme;
 }
 
 /*! \brief Assign penalty factors to possible domain decompositions,
  * based on the estimated communication costs. */
-static void assign_factors(const real         limit,
-                           const bool         request1D,
-                           const real         cutoff,
-                           const matrix       box,
-                           const gmx_ddbox_t& ddbox,
-                           int                natoms,
-                           const t_inputrec&  ir,
-                           float              pbcdxr,
-                           int                npme,
-                           int                ndiv,
-                           const int*         div,
-                           const int*         mdiv,
-                           gmx::IVec*         irTryPtr,
-                           gmx::IVec*         opt)
+static void assign_factors(const real                  limit,
+                           const bool                  request1D,
+                           const real                  cutoff,
+                           const matrix                box,
+                           const gmx_ddbox_t&          ddbox,
+                           int                         natoms,
+                           const t_inputrec&           ir,
+                           float                       pbcdxr,
+                           int                         npme,
+                           const AtomDensityHistogram* densityHistogram,
+                           int                         ndiv,
+                           const int*                  div,
+                           const int*                  mdiv,
+                           gmx::IVec*                  irTryPtr,
+                           gmx::IVec*                  opt)
 {
     int        x, y, i;
     float      ce;
@@ -582,10 +768,12 @@ static void assign_factors(const real         limit,
             return;
         }
 
-        ce = comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, ir_try);
+        ce = comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, densityHistogram,
+                           ir_try);
         if (ce >= 0
             && ((*opt)[XX] == 0
-                || ce < comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, *opt)))
+                || ce < comm_cost_est(limit, cutoff, box, ddbox, natoms, ir, pbcdxr, npme,
+                                      densityHistogram, *opt)))
         {
             *opt = ir_try;
         }
@@ -611,8 +799,8 @@ static void assign_factors(const real         limit,
             }
 
             /* recurse */
-            assign_factors(limit, request1D, cutoff, box, ddbox, natoms, ir, pbcdxr, npme, ndiv - 1,
-                           div + 1, mdiv + 1, irTryPtr, opt);
+            assign_factors(limit, request1D, cutoff, box, ddbox, natoms, ir, pbcdxr, npme,
+                           densityHistogram, ndiv - 1, div + 1, mdiv + 1, irTryPtr, opt);
 
             for (i = 0; i < mdiv[0] - x - y; i++)
             {
@@ -635,16 +823,17 @@ static void assign_factors(const real         limit,
  *
  * \returns The optimal grid cell choice. The latter will contain all
  *          zeros if no valid cell choice exists. */
-static gmx::IVec optimizeDDCells(const gmx::MDLogger& mdlog,
-                                 const int            numRanksRequested,
-                                 const int            numPmeOnlyRanks,
-                                 const real           cellSizeLimit,
-                                 const bool           request1D,
-                                 const gmx_mtop_t&    mtop,
-                                 const matrix         box,
-                                 const gmx_ddbox_t&   ddbox,
-                                 const t_inputrec&    ir,
-                                 const DDSystemInfo&  systemInfo)
+static gmx::IVec optimizeDDCells(const gmx::MDLogger&           mdlog,
+                                 const int                      numRanksRequested,
+                                 const int                      numPmeOnlyRanks,
+                                 const real                     cellSizeLimit,
+                                 const bool                     request1D,
+                                 const gmx_mtop_t&              mtop,
+                                 const matrix                   box,
+                                 const gmx_ddbox_t&             ddbox,
+                                 const t_inputrec&              ir,
+                                 const DDSystemInfo&            systemInfo,
+                                 gmx::ArrayRef<const gmx::RVec> xGlobal)
 {
     double pbcdxr;
 
@@ -714,10 +903,32 @@ static gmx::IVec optimizeDDCells(const gmx::MDLogger& mdlog,
     std::vector<int> mdiv;
     factorize(numPPRanks, &div, &mdiv);
 
+    /* Take the atom distribution into account, when available,
+     * so we avoid grids where many cells have (almost) no atoms.
+     */
+    AtomDensityHistogram densityHistogram;
+    if (!xGlobal.empty())
+    {
+        densityHistogram = makeAtomDensityHistogram(xGlobal, box, ddbox, cellSizeLimit);
+    }
+    const AtomDensityHistogram* densityHistogramPtr =
+            (xGlobal.empty() ? nullptr : &densityHistogram);
+
     gmx::IVec itry       = { 1, 1, 1 };
     gmx::IVec numDomains = { 0, 0, 0 };
     assign_factors(cellSizeLimit, request1D, systemInfo.cutoff, box, ddbox, mtop.natoms, ir, pbcdxr,
-                   numRanksDoingPmeWork, div.size(), div.data(), mdiv.data(), &itry, &numDomains);
+                   numRanksDoingPmeWork, densityHistogramPtr, div.size(), div.data(), mdiv.data(),
+                   &itry, &numDomains);
+
+    if (densityHistogramPtr != nullptr && numDomains[XX] > 0
+        && significantLoadImbalance(densityHistogram, numDomains) > 0)
+    {
+        GMX_LOG(mdlog.info)
+                .appendTextFormatted(
+                        "The atom distribution is inhomogeneous, with the chosen DD grid the "
+                        "estimated initial load imbalance is %.0f%%",
+                        100 * estimateLoadImbalance(densityHistogram, numDomains));
+    }
 
     return numDomains;
 }
@@ -936,7 +1147,8 @@ DDGridSetup getDDGridSetup(const gmx::MDLogger&           mdlog,
         if (ddRole == DDRole::Master)
         {
             numDomains = optimizeDDCells(mdlog, numRanksRequested, numPmeOnlyRanks, cellSizeLimit,
-                                         ddSettings.request1D, mtop, box, *ddbox, ir, systemInfo);
+                                         ddSettings.request1D, mtop, box, *ddbox, ir, systemInfo,
+                                         xGlobal);
         }
     }
 
@@ -92,6 +92,15 @@ void checkForValidRankCountRequests(int  numRanksRequested,
                                     int  numPmeRanksRequested,
                                     bool checkForLargePrimeFactors);
 
+/*! \brief Returns a suggestion for the number of separate PME ranks
+ *
+ * Uses the ratio \p pmeForceRatio of the measured PME mesh time on
+ * the \p numPmeOnlyRanks PME ranks and the force time on the PP ranks
+ * of a run with \p numRanks ranks in total. Returns 0 when all ranks
+ * should do PME, returns \p numPmeOnlyRanks when no better count was found.
+ */
+int suggestNumPmeOnlyRanks(int numRanks, int numPmeOnlyRanks, float pmeForceRatio);
+
 /*! \brief Return the minimum cell size (in nm) required for DD */
 real getDDGridSetupCellSizeLimit(const gmx::MDLogger& mdlog,
                                  bool                 bDynLoadBal,
@@ -153,6 +153,8 @@ struct gmx_reverse_top_t
     bool bIntermolecularInteractions = false;
     //! \brief Intermolecular reverse ilist
     reverse_ilist_t ril_intermol;
+    //! \brief Sorted copy of the intermolecular exclusion group, for fast membership checks
+    std::vector<int> sortedIntermolecularExclusionGroup;
 
     /* Work data structures for multi-threading */
     //! \brief Thread work array for local topology generation
@@ -1325,6 +1327,10 @@ static void make_exclusions_zone(gmx_domdec_t*                     dd,
                                  int                               at_end,
                                  const gmx::ArrayRef<const int>    intermolecularExclusionGroup)
 {
+    GMX_ASSERT(std::is_sorted(intermolecularExclusionGroup.begin(),
+                              intermolecularExclusionGroup.end()),
+               "The intermolecular exclusion group should be sorted");
+
     const gmx_ga2la_t& ga2la = *dd->ga2la;
 
     const auto& jAtomRange = zones->iZones[iz].jAtomRange;
@@ -1361,9 +1367,9 @@ static void make_exclusions_zone(gmx_domdec_t*                     dd,
         }
 
         bool isExcludedAtom = !intermolecularExclusionGroup.empty()
-                              && std::find(intermolecularExclusionGroup.begin(),
-                                           intermolecularExclusionGroup.end(), dd->globalAtomIndices[at])
-                                         != intermolecularExclusionGroup.end();
+                              && std::binary_search(intermolecularExclusionGroup.begin(),
+                                                    intermolecularExclusionGroup.end(),
+                                                    dd->globalAtomIndices[at]);
 
         if (isExcludedAtom)
         {
@@ -1480,7 +1486,7 @@ static int make_local_bondeds_excls(gmx_domdec_t*           dd,
 
                     /* No charge groups and no distance check required */
                     make_exclusions_zone(dd, zones, mtop->moltype, cginfo, excl_t, izone, cg0t,
-                                         cg1t, mtop->intermolecularExclusionGroup);
+                                         cg1t, rt->sortedIntermolecularExclusionGroup);
                 }
             }
             GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
@@ -1591,6 +1597,16 @@ void dd_make_local_top(gmx_domdec_t*       dd,
         }
     }
 
+    /* The MiMiC and rerun integrators set the intermolecular exclusion group
+     * after the reverse topology has been made, so we update our copy here.
+     * The group is small, so sorting it at every partitioning is cheap.
+     */
+    gmx_reverse_top_t* rt = dd->reverse_top;
+    rt->sortedIntermolecularExclusionGroup.assign(mtop.intermolecularExclusionGroup.begin(),
+                                                  mtop.intermolecularExclusionGroup.end());
+    std::sort(rt->sortedIntermolecularExclusionGroup.begin(),
+              rt->sortedIntermolecularExclusionGroup.end());
+
     dd->nbonded_local = make_local_bondeds_excls(dd, zones, &mtop, fr->cginfo.data(), bRCheckMB,
                                                  rcheck, bRCheck2B, rc, pbc_null, cgcm_or_x,
                                                  &ltop->idef, &ltop->excls, &nexcl);
@@ -1632,68 +1648,46 @@ void dd_init_local_state(gmx_domdec_t* dd, const t_state* state_global, t_state*
     state_local->flags = buf[0];
 }
 
-/*! \brief Check if a link is stored in \p link between charge groups \p cg_gl and \p cg_gl_j and if not so, store a link */
-static void check_link(t_blocka* link, int cg_gl, int cg_gl_j)
+/*! \brief Appends the atoms linked to atom \p a through the interactions in \p ril to \p links
+ *
+ * Atom \p a itself and atoms already present in \p links are not added.
+ */
+static void appendAtomLinks(const reverse_ilist_t& ril, int a, std::vector<int>* links)
 {
-    int      k;
-    gmx_bool bFound;
-
-    bFound = FALSE;
-    for (k = link->index[cg_gl]; k < link->index[cg_gl + 1]; k++)
+    int i = ril.index[a];
+    while (i < ril.index[a + 1])
     {
-        GMX_RELEASE_ASSERT(link->a, "Inconsistent NULL pointer while making charge-group links");
-        if (link->a[k] == cg_gl_j)
+        int ftype = ril.il[i++];
+        int nral  = NRAL(ftype);
+        /* Skip the ifunc index */
+        i++;
+        for (int j = 0; j < nral; j++)
         {
-            bFound = TRUE;
-        }
-    }
-    if (!bFound)
-    {
-        GMX_RELEASE_ASSERT(link->a || link->index[cg_gl + 1] + 1 > link->nalloc_a,
-                           "Inconsistent allocation of link");
-        /* Add this charge group link */
-        if (link->index[cg_gl + 1] + 1 > link->nalloc_a)
-        {
-            link->nalloc_a = over_alloc_large(link->index[cg_gl + 1] + 1);
-            srenew(link->a, link->nalloc_a);
+            int aj = ril.il[i + j];
+            if (aj != a && std::find(links->begin(), links->end(), aj) == links->end())
+            {
+                links->push_back(aj);
+            }
         }
-        link->a[link->index[cg_gl + 1]] = cg_gl_j;
-        link->index[cg_gl + 1]++;
+        i += nral_rt(ftype);
     }
 }
 
-t_blocka* makeBondedLinks(const gmx_mtop_t& mtop, gmx::ArrayRef<cginfo_mb_t> cginfo_mb)
+std::unique_ptr<BondedLinks> makeBondedLinks(const gmx_mtop_t&          mtop,
+                                             gmx::ArrayRef<cginfo_mb_t> cginfo_mb)
 {
-    t_blocka*    link;
-    cginfo_mb_t* cgi_mb;
-
     /* For each atom make a list of other atoms in the system
      * that a linked to it via bonded interactions
      * which are also stored in reverse_top.
+     * The links within molecules are stored per molecule type.
      */
+    auto links = std::make_unique<BondedLinks>();
 
-    reverse_ilist_t ril_intermol;
-    if (mtop.bIntermolecularInteractions)
-    {
-        t_atoms atoms;
-
-        atoms.nr   = mtop.natoms;
-        atoms.atom = nullptr;
-
-        GMX_RELEASE_ASSERT(mtop.intermolecular_ilist,
-                           "We should have an ilist when intermolecular interactions are on");
-
-        make_reverse_ilist(*mtop.intermolecular_ilist, &atoms, FALSE, FALSE, FALSE, TRUE, &ril_intermol);
-    }
-
-    snew(link, 1);
-    snew(link->index, mtop.natoms + 1);
-    link->nalloc_a = 0;
-    link->a        = nullptr;
+    links->moleculeTypeLinks.resize(mtop.moltype.size());
+    std::vector<bool> haveMoleculeTypeLinks(mtop.moltype.size(), false);
+    std::vector<int>  atomLinks;
 
-    link->index[0] = 0;
-    int cg_offset  = 0;
-    int ncgi       = 0;
+    int globalAtomStart = 0;
     for (size_t mb = 0; mb < mtop.molblock.size(); mb++)
     {
         const gmx_molblock_t& molb = mtop.molblock[mb];
@@ -1702,6 +1696,15 @@ t_blocka* makeBondedLinks(const gmx_mtop_t& mtop, gmx::ArrayRef<cginfo_mb_t> cgi
             continue;
         }
         const gmx_moltype_t& molt = mtop.moltype[molb.type];
+        links->moleculeBlocks.push_back({ globalAtomStart, molt.atoms.nr, molb.type });
+        globalAtomStart += molb.nmol * molt.atoms.nr;
+
+        if (haveMoleculeTypeLinks[molb.type])
+        {
+            continue;
+        }
+        haveMoleculeTypeLinks[molb.type] = true;
+
         /* Make a reverse ilist in which the interactions are linked
          * to all atoms, not only the first atom as in gmx_reverse_top.
          * The constraints are discarded here.
@@ -1709,103 +1712,88 @@ t_blocka* makeBondedLinks(const gmx_mtop_t& mtop, gmx::ArrayRef<cginfo_mb_t> cgi
         reverse_ilist_t ril;
         make_reverse_ilist(molt.ilist, &molt.atoms, FALSE, FALSE, FALSE, TRUE, &ril);
 
-        cgi_mb = &cginfo_mb[mb];
-
-        int mol;
-        for (mol = 0; mol < (mtop.bIntermolecularInteractions ? molb.nmol : 1); mol++)
+        gmx::ListOfLists<int>& moleculeLinks = links->moleculeTypeLinks[molb.type];
+        for (int a = 0; a < molt.atoms.nr; a++)
         {
-            for (int a = 0; a < molt.atoms.nr; a++)
-            {
-                int cg_gl              = cg_offset + a;
-                link->index[cg_gl + 1] = link->index[cg_gl];
-                int i                  = ril.index[a];
-                while (i < ril.index[a + 1])
-                {
-                    int ftype = ril.il[i++];
-                    int nral  = NRAL(ftype);
-                    /* Skip the ifunc index */
-                    i++;
-                    for (int j = 0; j < nral; j++)
-                    {
-                        int aj = ril.il[i + j];
-                        if (aj != a)
-                        {
-                            check_link(link, cg_gl, cg_offset + aj);
-                        }
-                    }
-                    i += nral_rt(ftype);
-                }
-
-                if (mtop.bIntermolecularInteractions)
-                {
-                    int i = ril_intermol.index[cg_gl];
-                    while (i < ril_intermol.index[cg_gl + 1])
-                    {
-                        int ftype = ril_intermol.il[i++];
-                        int nral  = NRAL(ftype);
-                        /* Skip the ifunc index */
-                        i++;
-                        for (int j = 0; j < nral; j++)
-                        {
-                            /* Here we assume we have no charge groups;
-                             * this has been checked above.
-                             */
-                            int aj = ril_intermol.il[i + j];
-                            check_link(link, cg_gl, aj);
-                        }
-                        i += nral_rt(ftype);
-                    }
-                }
-                if (link->index[cg_gl + 1] - link->index[cg_gl] > 0)
-                {
-                    SET_CGINFO_BOND_INTER(cgi_mb->cginfo[a]);
-                    ncgi++;
-                }
-            }
-
-            cg_offset += molt.atoms.nr;
+            atomLinks.clear();
+            appendAtomLinks(ril, a, &atomLinks);
+            moleculeLinks.pushBack(atomLinks);
         }
-        int nlink_mol = link->index[cg_offset] - link->index[cg_offset - molt.atoms.nr];
 
         if (debug)
         {
             fprintf(debug, "molecule type '%s' %d atoms has %d atom links through bonded interac.\n",
-                    *molt.name, molt.atoms.nr, nlink_mol);
+                    *molt.name, molt.atoms.nr, moleculeLinks.numElements());
         }
+    }
+
+    if (mtop.bIntermolecularInteractions)
+    {
+        t_atoms atoms;
+
+        atoms.nr   = mtop.natoms;
+        atoms.atom = nullptr;
+
+        GMX_RELEASE_ASSERT(mtop.intermolecular_ilist,
+                           "We should have an ilist when intermolecular interactions are on");
+
+        reverse_ilist_t ril_intermol;
+        make_reverse_ilist(*mtop.intermolecular_ilist, &atoms, FALSE, FALSE, FALSE, TRUE,
+                           &ril_intermol);
 
-        if (molb.nmol > mol)
+        /* Only store entries for atoms involved in intermolecular interactions */
+        for (int a = 0; a < mtop.natoms; a++)
         {
-            /* Copy the data for the rest of the molecules in this block */
-            link->nalloc_a += (molb.nmol - mol) * nlink_mol;
-            srenew(link->a, link->nalloc_a);
-            for (; mol < molb.nmol; mol++)
+            if (ril_intermol.index[a + 1] > ril_intermol.index[a])
             {
-                for (int a = 0; a < molt.atoms.nr; a++)
+                atomLinks.clear();
+                appendAtomLinks(ril_intermol, a, &atomLinks);
+                if (!atomLinks.empty())
                 {
-                    int cg_gl              = cg_offset + a;
-                    link->index[cg_gl + 1] = link->index[cg_gl + 1 - molt.atoms.nr] + nlink_mol;
-                    for (int j = link->index[cg_gl]; j < link->index[cg_gl + 1]; j++)
-                    {
-                        link->a[j] = link->a[j - nlink_mol] + molt.atoms.nr;
-                    }
-                    if (link->index[cg_gl + 1] - link->index[cg_gl] > 0
-                        && cg_gl - cgi_mb->cg_start < cgi_mb->cg_mod)
-                    {
-                        SET_CGINFO_BOND_INTER(cgi_mb->cginfo[cg_gl - cgi_mb->cg_start]);
-                        ncgi++;
-                    }
+                    links->intermolecularLinkAtoms.push_back(a);
+                    links->intermolecularLinks.pushBack(atomLinks);
                 }
-                cg_offset += molt.atoms.nr;
             }
         }
     }
 
+    /* Flag the atoms that have links in cginfo */
+    for (size_t mb = 0; mb < mtop.molblock.size(); mb++)
+    {
+        const gmx_molblock_t& molb = mtop.molblock[mb];
+        if (molb.nmol == 0)
+        {
+            continue;
+        }
+        const gmx::ListOfLists<int>& moleculeLinks = links->moleculeTypeLinks[molb.type];
+        const int                    numAtomsMol   = mtop.moltype[molb.type].atoms.nr;
+        cginfo_mb_t&                 cgi_mb        = cginfo_mb[mb];
+        for (int i = 0; i < cgi_mb.cg_mod; i++)
+        {
+            if (!moleculeLinks[i % numAtomsMol].empty())
+            {
+                SET_CGINFO_BOND_INTER(cgi_mb.cginfo[i]);
+            }
+        }
+    }
+    size_t mb = 0;
+    for (const int a : links->intermolecularLinkAtoms)
+    {
+        while (a >= cginfo_mb[mb].cg_end)
+        {
+            mb++;
+        }
+        cginfo_mb_t& cgi_mb = cginfo_mb[mb];
+        SET_CGINFO_BOND_INTER(cgi_mb.cginfo[(a - cgi_mb.cg_start) % cgi_mb.cg_mod]);
+    }
+
     if (debug)
     {
-        fprintf(debug, "Of the %d atoms %d are linked via bonded interactions\n", mtop.natoms, ncgi);
+        fprintf(debug, "Of the %d atoms %zu have intermolecular links via bonded interactions\n",
+                mtop.natoms, links->intermolecularLinkAtoms.size());
     }
 
-    return link;
+    return links;
 }
 
 typedef struct
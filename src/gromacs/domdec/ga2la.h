@@ -97,6 +97,13 @@ public:
         }
     }
 
+    /*! \brief Returns whether insert() and erase() can be called concurrently
+     *
+     * This is the case with the direct list, where entries for different
+     * global atoms do not share data.
+     */
+    bool supportsConcurrentUpdates() const { return usingDirect_; }
+
     //! Delete the entry for global atom a_gl
     void erase(int a_gl)
     {
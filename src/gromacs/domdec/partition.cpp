@@ -98,6 +98,7 @@
 #include "distribute.h"
 #include "domdec_constraints.h"
 #include "domdec_internal.h"
+#include "domdec_setup.h"
 #include "domdec_vsite.h"
 #include "dump.h"
 #include "redistribute.h"
@@ -466,6 +467,8 @@ static void dd_set_cginfo(gmx::ArrayRef<const int> index_gl, int cg0, int cg1, t
         gmx::ArrayRef<cginfo_mb_t> cginfo_mb = fr->cginfo_mb;
         gmx::ArrayRef<int>         cginfo    = fr->cginfo;
 
+        const int numThreads = gmx_omp_nthreads_get(emntDomdec);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
         for (int cg = cg0; cg < cg1; cg++)
         {
             cginfo[cg] = ddcginfo(cginfo_mb, index_gl[cg]);
@@ -489,9 +492,14 @@ static void make_dd_indices(gmx_domdec_t* dd, const int atomStart)
         gmx_incons("dd->ncg_zone is not up to date");
     }
 
-    /* Make the local to global and global to local atom index */
-    int a = atomStart;
-    globalAtomIndices.resize(a);
+    /* Make the local to global and global to local atom index,
+     * the local atom index is equal to the atom group index.
+     * We can only fill the global to local index in parallel when
+     * the entries for different atoms are independent.
+     */
+    const int numThreads =
+            (ga2la.supportsConcurrentUpdates() ? gmx_omp_nthreads_get(emntDomdec) : 1);
+    globalAtomIndices.resize(zone2cg[numZones]);
     for (int zone = 0; zone < numZones; zone++)
     {
         int cg0;
@@ -506,6 +514,7 @@ static void make_dd_indices(gmx_domdec_t* dd, const int atomStart)
         int cg1    = zone2cg[zone + 1];
         int cg1_p1 = cg0 + zone_ncg1[zone];
 
+#pragma omp parallel for num_threads(numThreads) schedule(static)
         for (int cg = cg0; cg < cg1; cg++)
         {
             int zone1 = zone;
@@ -514,10 +523,9 @@ static void make_dd_indices(gmx_domdec_t* dd, const int atomStart)
                 /* Signal that this cg is from more than one pulse away */
                 zone1 += numZones;
             }
-            int cg_gl = globalAtomGroupIndices[cg];
-            globalAtomIndices.push_back(cg_gl);
-            ga2la.insert(cg_gl, { a, zone1 });
-            a++;
+            int cg_gl             = globalAtomGroupIndices[cg];
+            globalAtomIndices[cg] = cg_gl;
+            ga2la.insert(cg_gl, { cg, zone1 });
         }
     }
 }
@@ -1114,7 +1122,7 @@ static void print_dd_load_av(FILE* fplog, gmx_domdec_t* dd)
     }
     if (numPmeRanks > 0 && std::fabs(lossFractionPme) >= DD_PERF_LOSS_WARN)
     {
-        sprintf(buf,
+        std::string message = gmx::formatString(
                 "NOTE: %.1f %% performance was lost because the PME ranks\n"
                 "      had %s work to do than the PP ranks.\n"
                 "      You might want to %s the number of PME ranks\n"
@@ -1122,8 +1130,23 @@ static void print_dd_load_av(FILE* fplog, gmx_domdec_t* dd)
                 std::fabs(lossFractionPme * 100), (lossFractionPme < 0) ? "less" : "more",
                 (lossFractionPme < 0) ? "decrease" : "increase",
                 (lossFractionPme < 0) ? "decrease" : "increase");
-        fprintf(fplog, "%s\n", buf);
-        fprintf(stderr, "%s\n", buf);
+        const int numPmeRanksSuggested =
+                suggestNumPmeOnlyRanks(numRanks, numPmeRanks, comm->load_pme / comm->load_mdf);
+        if (numPmeRanksSuggested == 0)
+        {
+            message +=
+                    "      Based on the measured loads, the PME work should be done\n"
+                    "      by all ranks (option -npme 0).\n";
+        }
+        else if (numPmeRanksSuggested != numPmeRanks)
+        {
+            message += gmx::formatString(
+                    "      Based on the measured loads, the suggested number of PME ranks\n"
+                    "      for %d ranks in total is %d (option -npme).\n",
+                    numRanks, numPmeRanksSuggested);
+        }
+        fprintf(fplog, "%s\n", message.c_str());
+        fprintf(stderr, "%s\n", message.c_str());
     }
 }
 
@@ -1411,17 +1434,12 @@ static void make_cell2at_index(gmx_domdec_comm_dim_t* cd, int nzone, int atomGro
 }
 
 //! Returns whether a link is missing.
-static gmx_bool missing_link(const t_blocka& link, const int globalAtomIndex, const gmx_ga2la_t& ga2la)
+static gmx_bool missing_link(const BondedLinks& links,
+                             const int          globalAtomIndex,
+                             const gmx_ga2la_t& ga2la)
 {
-    for (int i = link.index[globalAtomIndex]; i < link.index[globalAtomIndex + 1]; i++)
-    {
-        if (!ga2la.findHome(link.a[i]))
-        {
-            return true;
-        }
-    }
-
-    return false;
+    return links.anyLinkedAtom(globalAtomIndex,
+                               [&ga2la](int linkedAtom) { return !ga2la.findHome(linkedAtom); });
 }
 
 //! Domain corners for communication, a maximum of 4 i-zones see a j domain
@@ -2450,15 +2468,24 @@ static void orderVector(gmx::ArrayRef<const gmx_cgsort_t> sort,
     GMX_ASSERT(sortBuffer.size() >= sort.size(),
                "The sorting buffer needs to be sufficiently large");
 
-    /* Order the data into the temporary buffer */
-    size_t i = 0;
-    for (const gmx_cgsort_t& entry : sort)
+    const int numThreads = gmx_omp_nthreads_get(emntDomdec);
+    const int numEntries = sort.ssize();
+#pragma omp parallel num_threads(numThreads)
     {
-        sortBuffer[i++] = dataToSort[entry.ind];
-    }
+        /* Order the data into the temporary buffer */
+#pragma omp for schedule(static)
+        for (int i = 0; i < numEntries; i++)
+        {
+            sortBuffer[i] = dataToSort[sort[i].ind];
+        }
 
-    /* Copy back to the original array */
-    std::copy(sortBuffer.begin(), sortBuffer.begin() + sort.size(), dataToSort.begin());
+        /* Copy back to the original array */
+#pragma omp for schedule(static)
+        for (int i = 0; i < numEntries; i++)
+        {
+            dataToSort[i] = sortBuffer[i];
+        }
+    }
 }
 
 /*! \brief Order data in \p dataToSort according to \p sort
@@ -54,6 +54,7 @@
 #include "gromacs/domdec/dlb.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_network.h"
+#include "gromacs/domdec/domdec_setup.h"
 #include "gromacs/domdec/domdec_struct.h"
 #include "gromacs/domdec/partition.h"
 #include "gromacs/ewald/ewald_utils.h"
@@ -81,6 +82,7 @@
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "pme_internal.h"
 #include "pme_pp.h"
@@ -898,6 +900,53 @@ static void continue_pme_loadbal(pme_load_balancing_t* pme_lb, gmx_bool bDlbUnlo
     pme_lb->start = pme_lb->lower_limit;
 }
 
+/*! \brief Print a suggestion for the number of PME-only ranks when tuning is done
+ *
+ * The tuning can only shift work from the PME ranks to the PP ranks.
+ * When the PME mesh/force ratio of the final setup still shows imbalance,
+ * the PP/PME rank split needs to change, which is only possible at startup.
+ */
+static void printPmeRankSuggestion(const t_commrec* cr, const gmx::MDLogger& mdlog)
+{
+    if (!DDMASTER(cr->dd))
+    {
+        return;
+    }
+
+    const float pmeForceRatio = dd_pme_f_ratio(cr->dd);
+    const bool  isBalanced    = (pmeForceRatio < loadBalanceTriggerFactor
+                             && pmeForceRatio * loadBalanceTriggerFactor > 1);
+    if (pmeForceRatio <= 0 || isBalanced)
+    {
+        return;
+    }
+
+    const int numRanks             = cr->nnodes;
+    const int numPmeRanks          = cr->npmenodes;
+    const int numPmeRanksSuggested = suggestNumPmeOnlyRanks(numRanks, numPmeRanks, pmeForceRatio);
+    if (numPmeRanksSuggested == numPmeRanks)
+    {
+        return;
+    }
+
+    std::string message = gmx::formatString(
+            "NOTE: After PME tuning the PME ranks have %s work to do than the PP ranks,\n"
+            "      the PME mesh/force ratio is %.2f.\n",
+            pmeForceRatio < 1 ? "less" : "more", pmeForceRatio);
+    if (numPmeRanksSuggested == 0)
+    {
+        message += "      The PME work should be done by all ranks (option -npme 0).";
+    }
+    else
+    {
+        message += gmx::formatString(
+                "      The suggested number of PME ranks for %d ranks in total is %d\n"
+                "      (option -npme).",
+                numRanks, numPmeRanksSuggested);
+    }
+    GMX_LOG(mdlog.warning).asParagraph().appendText(message);
+}
+
 void pme_loadbal_do(pme_load_balancing_t*          pme_lb,
                     t_commrec*                     cr,
                     FILE*                          fp_err,
@@ -923,6 +972,9 @@ void pme_loadbal_do(pme_load_balancing_t*          pme_lb,
         return;
     }
 
+    /* Avoid interference of pair-list pruning tuning with our timings */
+    fr->nbv->lockDynamicPruningTuning();
+
     n_prev      = pme_lb->cycles_n;
     cycles_prev = pme_lb->cycles_c;
     wallcycle_get(wcycle, ewcSTEP, &pme_lb->cycles_n, &pme_lb->cycles_c);
@@ -1057,6 +1109,12 @@ void pme_loadbal_do(pme_load_balancing_t*          pme_lb,
         pme_lb->bActive = FALSE;
     }
 
+    if (!pme_lb->bActive && pme_lb->bSepPMERanks && !useGpuPmePpCommunication)
+    {
+        /* We just finished tuning, the PP/PME balance of the final setup is known */
+        printPmeRankSuggestion(cr, mdlog);
+    }
+
     if (!(pme_lb->bActive) && DOMAINDECOMP(cr) && dd_dlb_is_locked(cr->dd))
     {
         /* Make sure DLB is allowed when we deactivate PME tuning */
@@ -1066,6 +1124,12 @@ void pme_loadbal_do(pme_load_balancing_t*          pme_lb,
                 .appendText("NOTE: DLB can now turn on, when beneficial");
     }
 
+    if (!pme_lb->bActive)
+    {
+        /* The pair-list pruning interval can now be tuned for the final cut-off */
+        fr->nbv->unlockDynamicPruningTuning();
+    }
+
     *bPrinting = pme_lb->bBalance;
 }
 
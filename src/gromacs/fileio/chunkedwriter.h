@@ -0,0 +1,106 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares a helper for formatting text lines in parallel and writing them in order.
+ *
+ * \ingroup module_fileio
+ */
+#ifndef GMX_FILEIO_CHUNKEDWRITER_H
+#define GMX_FILEIO_CHUNKEDWRITER_H
+
+#include <cstdio>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace gmx
+{
+
+/*! \brief Formats the lines for \p numItems items in parallel and writes them to \p fp in order
+ *
+ * The items are divided over chunks of consecutive items, which are formatted
+ * into memory buffers by OpenMP threads. The buffers are written with a single
+ * fwrite call each, in order, so the output is identical to formatting
+ * and writing the items one by one. Memory usage is limited to a few chunks
+ * per thread, independently of \p numItems.
+ *
+ * \param[in] fp           The file to write to
+ * \param[in] numItems     The number of items to format
+ * \param[in] formatItems  Function that is called with (begin, end, std::string* buffer)
+ *                         and appends the lines of items begin to end to buffer.
+ *                         Is called concurrently for different ranges.
+ */
+template<typename FormatItems>
+void formatAndWriteInChunks(FILE* fp, int numItems, FormatItems&& formatItems)
+{
+    constexpr int c_numItemsPerChunk = 16384;
+
+    const int numThreads =
+            std::max(1, std::min(gmx_omp_get_max_threads(),
+                                 (numItems + c_numItemsPerChunk - 1) / c_numItemsPerChunk));
+    std::vector<std::string> buffers(numThreads);
+    for (int blockStart = 0; blockStart < numItems; blockStart += numThreads * c_numItemsPerChunk)
+    {
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+        for (int thread = 0; thread < numThreads; thread++)
+        {
+            try
+            {
+                const int begin = std::min(numItems, blockStart + thread * c_numItemsPerChunk);
+                const int end   = std::min(numItems, begin + c_numItemsPerChunk);
+                buffers[thread].clear();
+                formatItems(begin, end, &buffers[thread]);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+        for (const std::string& buffer : buffers)
+        {
+            if (fwrite(buffer.data(), 1, buffer.size(), fp) != buffer.size())
+            {
+                gmx_file("Cannot write formatted lines to file");
+            }
+        }
+    }
+}
+
+} // namespace gmx
+
+#endif
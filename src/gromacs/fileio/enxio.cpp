@@ -94,6 +94,9 @@ struct ener_file
     t_fileio*  fio;
     int        framenr;
     real       frametime;
+    gmx_bool*  bTermSelected; /* When != NULL, only decode these energy terms */
+    int        nTermSelected; /* The number of entries in bTermSelected */
+    gmx_bool   bSkipBlocks;   /* Whether to skip the data blocks when reading */
 };
 
 static void enxsubblock_init(t_enxsubblock* sb)
@@ -757,6 +760,9 @@ void close_enx(ener_file_t ef)
         // Nothing to do
         return;
     }
+    sfree(ef->bTermSelected);
+    ef->bTermSelected = nullptr;
+    ef->nTermSelected = 0;
     if (gmx_fio_close(ef->fio) != 0)
     {
         gmx_file(
@@ -950,6 +956,69 @@ static void convert_full_sums(ener_old_t* ener_old, t_enxframe* fr)
     ener_old->step_prev = fr->step;
 }
 
+/* Return whether energy term i should be decoded */
+static gmx_bool enx_term_selected(const ener_file* ef, int i)
+{
+    return (i < ef->nTermSelected && ef->bTermSelected[i]);
+}
+
+/* Return the size in bytes of the data stored for one energy term */
+static gmx_off_t enx_term_size(ener_file_t ef, int file_version, int nsum)
+{
+    gmx_off_t realSize = gmx_fio_is_double(ef->fio) ? sizeof(double) : sizeof(float);
+    int       nreal    = 1;
+
+    if (file_version == 1)
+    {
+        nreal = 4;
+    }
+    else if (nsum > 0)
+    {
+        nreal = 3;
+    }
+    return nreal * realSize;
+}
+
+/* Return the size in bytes of the block data in frame fr,
+ * or -1 when the size can not be determined without reading the data.
+ */
+static gmx_off_t enx_block_data_size(const t_enxframe* fr)
+{
+    gmx_off_t nbytes = 0;
+
+    for (int b = 0; b < fr->nblock; b++)
+    {
+        for (int i = 0; i < fr->block[b].nsub; i++)
+        {
+            const t_enxsubblock* sub = &(fr->block[b].sub[i]);
+            gmx_off_t            itemSize;
+
+            switch (sub->type)
+            {
+                case xdr_datatype_float: itemSize = sizeof(float); break;
+                case xdr_datatype_double: itemSize = sizeof(double); break;
+                case xdr_datatype_int: itemSize = sizeof(int32_t); break;
+                case xdr_datatype_int64: itemSize = sizeof(int64_t); break;
+                /* XDR stores each char in 4 bytes */
+                case xdr_datatype_char: itemSize = 4; break;
+                default: return -1;
+            }
+            nbytes += sub->nr * itemSize;
+        }
+    }
+    return nbytes;
+}
+
+/* Move the file position of ef forward by nbytes */
+static gmx_bool enx_skip(ener_file_t ef, gmx_off_t nbytes)
+{
+    if (nbytes == 0)
+    {
+        return TRUE;
+    }
+    return (gmx_fio_seek(ef->fio, gmx_fio_ftell(ef->fio) + nbytes) == 0);
+}
+
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
 {
     int      file_version = -1;
@@ -1021,8 +1090,28 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
         fr->e_alloc = fr->nre;
     }
 
+    /* With a term selection we only decode the selected terms */
+    const gmx_bool bProject = (bRead && ef->bTermSelected != nullptr && file_version > 1);
     for (i = 0; i < fr->nre; i++)
     {
+        if (bProject && !enx_term_selected(ef, i))
+        {
+            /* Skip all consecutive unselected terms with a single seek */
+            int iStart = i;
+            while (i + 1 < fr->nre && !enx_term_selected(ef, i + 1))
+            {
+                i++;
+            }
+            for (int j = iStart; j <= i; j++)
+            {
+                fr->ener[j].e    = 0;
+                fr->ener[j].eav  = 0;
+                fr->ener[j].esum = 0;
+            }
+            bOK = bOK && enx_skip(ef, (i - iStart + 1) * enx_term_size(ef, file_version, fr->nsum));
+            continue;
+        }
+
         bOK = bOK && gmx_fio_do_real(ef->fio, fr->ener[i].e);
 
         /* Do not store sums of length 1,
@@ -1062,6 +1151,18 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
         /* Convert old full simulation sums to sums between energy frames */
         convert_full_sums(&(ef->eo), fr);
     }
+    if (bRead && ef->bSkipBlocks && file_version > 1)
+    {
+        /* Skip the data of all blocks, we can not skip string data
+         * without reading it, so we need to check for that.
+         */
+        gmx_off_t nbytes = enx_block_data_size(fr);
+        if (nbytes >= 0)
+        {
+            bOK        = bOK && enx_skip(ef, nbytes);
+            fr->nblock = 0;
+        }
+    }
     /* read the blocks */
     for (b = 0; b < fr->nblock; b++)
     {
@@ -1131,6 +1232,112 @@ gmx_bool do_enx(ener_file_t ef, t_enxframe* fr)
     return TRUE;
 }
 
+void enx_select_terms(ener_file_t ef, int nsel, const int* sel, gmx_bool bReadBlocks)
+{
+    sfree(ef->bTermSelected);
+    ef->bTermSelected = nullptr;
+    ef->nTermSelected = 0;
+    if (nsel > 0)
+    {
+        ef->nTermSelected = *std::max_element(sel, sel + nsel) + 1;
+        snew(ef->bTermSelected, ef->nTermSelected);
+        for (int i = 0; i < nsel; i++)
+        {
+            ef->bTermSelected[sel[i]] = TRUE;
+        }
+    }
+    ef->bSkipBlocks = !bReadBlocks;
+}
+
+std::vector<t_enxindexentry> enx_build_frame_index(ener_file_t ef)
+{
+    std::vector<t_enxindexentry> index;
+    t_enxframe                   fr;
+    int                          file_version = -1;
+    gmx_bool                     bOK          = TRUE;
+    gmx_off_t                    fileSize;
+    gmx_off_t                    firstFrame;
+
+    GMX_RELEASE_ASSERT(gmx_fio_getread(ef->fio), "Can only index energy files opened for reading");
+
+    firstFrame = gmx_fio_ftell(ef->fio);
+    gmx_fseek(gmx_fio_getfp(ef->fio), 0, SEEK_END);
+    fileSize = gmx_fio_ftell(ef->fio);
+    gmx_fio_seek(ef->fio, firstFrame);
+
+    init_enxframe(&fr);
+    while (TRUE)
+    {
+        t_enxindexentry entry;
+        gmx_off_t       nbytes;
+
+        entry.offset = gmx_fio_ftell(ef->fio);
+        if (!do_eheader(ef, &file_version, &fr, -1, nullptr, &bOK) || !bOK)
+        {
+            break;
+        }
+        if (file_version == 1)
+        {
+            /* Old files need to be read sequentially to convert the sums */
+            index.clear();
+            break;
+        }
+        entry.t      = fr.t;
+        entry.step   = fr.step;
+        entry.nre    = fr.nre;
+        entry.nblock = fr.nblock;
+
+        nbytes = enx_block_data_size(&fr);
+        if (nbytes < 0)
+        {
+            /* We have string data, read the whole frame instead */
+            gmx_fio_seek(ef->fio, entry.offset);
+            if (!do_enx(ef, &fr))
+            {
+                break;
+            }
+        }
+        else if (!enx_skip(ef, fr.nre * enx_term_size(ef, file_version, fr.nsum) + nbytes)
+                 || gmx_fio_ftell(ef->fio) > fileSize)
+        {
+            break;
+        }
+        index.push_back(entry);
+    }
+    free_enxframe(&fr);
+
+    gmx_fio_seek(ef->fio, firstFrame);
+    ef->framenr   = 0;
+    ef->frametime = 0;
+
+    return index;
+}
+
+int enx_find_frame_time(const std::vector<t_enxindexentry>& index, double t)
+{
+    auto it = std::lower_bound(index.begin(), index.end(), t,
+                               [](const t_enxindexentry& e, double time) { return e.t < time; });
+
+    return it - index.begin();
+}
+
+void enx_seek_frame(ener_file_t ef, const std::vector<t_enxindexentry>& index, int frame)
+{
+    GMX_RELEASE_ASSERT(frame >= 0 && frame <= static_cast<int>(index.size()),
+                       "Can only seek to frames in the index");
+
+    if (frame < static_cast<int>(index.size()))
+    {
+        gmx_fio_seek(ef->fio, index[frame].offset);
+        ef->frametime = index[frame].t;
+    }
+    else
+    {
+        gmx_fseek(gmx_fio_getfp(ef->fio), 0, SEEK_END);
+    }
+    ef->framenr = frame;
+}
+
 static real find_energy(const char* name, int nre, gmx_enxnm_t* enm, t_enxframe* fr)
 {
     int i;
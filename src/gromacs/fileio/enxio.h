@@ -38,8 +38,11 @@
 #ifndef GMX_FILEIO_ENXIO_H
 #define GMX_FILEIO_ENXIO_H
 
+#include <vector>
+
 #include "gromacs/fileio/xdr_datatype.h"
 #include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/futil.h"
 #include "gromacs/utility/real.h"
 
 struct SimulationGroups;
@@ -136,6 +139,16 @@ struct t_enxblock
 /* file handle */
 typedef struct ener_file* ener_file_t;
 
+/* An entry in the frame index of an energy file, see enx_build_frame_index() */
+struct t_enxindexentry
+{
+    gmx_off_t offset; /* the file offset of the frame header */
+    double    t;      /* the time of the frame */
+    int64_t   step;   /* the step of the frame */
+    int       nre;    /* the number of energy terms in the frame */
+    int       nblock; /* the number of blocks in the frame */
+};
+
 /*
  * An energy file is read like this:
  *
@@ -178,6 +191,35 @@ void free_enxnms(int n, gmx_enxnm_t* nms);
 gmx_bool do_enx(ener_file_t ef, t_enxframe* fr);
 /* Reads enx_frames, memory in fr is (re)allocated if necessary */
 
+void enx_select_terms(ener_file_t ef, int nsel, const int* sel, gmx_bool bReadBlocks);
+/* Restricts reading with do_enx to the nsel energy terms with indices sel,
+ * the other terms are skipped over in the file and set to zero in the frame.
+ * When bReadBlocks is FALSE, the data blocks of the frames are also skipped
+ * and frames are returned with nblock=0. Passing nsel=0 and sel=NULL
+ * with bReadBlocks=TRUE restores reading of complete frames.
+ * Has no effect on files in the pre 4.1 format.
+ */
+
+std::vector<t_enxindexentry> enx_build_frame_index(ener_file_t ef);
+/* Scans the energy file opened for reading and returns the offsets, times
+ * and steps of all complete frames. Only the frame headers are decoded,
+ * the frame data is skipped over. The file is rewound to the first frame
+ * afterwards. The index can be used to seek with enx_seek_frame(),
+ * also with other handles opened on the same file, e.g. to read
+ * different parts of a file in parallel with one handle per thread.
+ * Returns an empty index for files in the pre 4.1 format.
+ */
+
+int enx_find_frame_time(const std::vector<t_enxindexentry>& index, double t);
+/* Returns the index of the first frame with time >= t, or index.size()
+ * when there is no such frame. The times in the index should be ordered.
+ */
+
+void enx_seek_frame(ener_file_t ef, const std::vector<t_enxindexentry>& index, int frame);
+/* Positions ef such that the next call to do_enx reads frame number frame
+ * of index, index.size() positions ef at the end of the file.
+ */
+
 void get_enx_state(const char* fn, real t, const SimulationGroups& groups, t_inputrec* ir, t_state* state);
 /*
  * Reads state variables from enx file fn at time t.
@@ -40,14 +40,16 @@
 #include "groio.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 
 #include <algorithm>
 #include <string>
 
+#include "gromacs/fileio/chunkedwriter.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/topology/atoms.h"
-#include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/mtop_lookup.h"
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/trajectory/trajectoryframe.h"
@@ -55,6 +57,7 @@
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 
 static void get_coordnum_fp(FILE* in, char* title, int* natoms)
@@ -79,6 +82,27 @@ void get_coordnum(const char* infile, int* natoms)
     gmx_fio_fclose(in);
 }
 
+/*! \brief Parses a single number from a fixed-width field of a gro file
+ *
+ * This is equivalent to, but much faster than, sscanf with a single %lf,
+ * with the extra check that the field does not contain a second number.
+ *
+ * \returns whether exactly one number was found in \p field.
+ */
+static bool parseFixedWidthReal(const char* field, double* value)
+{
+    char* end;
+    *value = std::strtod(field, &end);
+    if (end == field)
+    {
+        return false;
+    }
+    /* Check that there is no second number in the field */
+    char* secondEnd;
+    std::strtod(end, &secondEnd);
+    return secondEnd == end;
+}
+
 /* Note that the .gro reading routine still support variable precision
  * for backward compatibility with old .gro files.
  * We have removed writing of variable precision to avoid compatibility
@@ -225,7 +249,7 @@ static gmx_bool get_w_conf(FILE*       in,
                 ptr++;
             }
             buf[c] = '\0';
-            if (sscanf(buf, "%lf %lf", &x1, &x2) != 1)
+            if (!parseFixedWidthReal(buf, &x1))
             {
                 gmx_fatal(FARGS,
                           "Something is wrong in the coordinate formatting of file %s. Note that "
@@ -250,7 +274,7 @@ static gmx_bool get_w_conf(FILE*       in,
                     ptr++;
                 }
                 buf[c] = '\0';
-                if (sscanf(buf, "%lf", &x1) != 1)
+                if (!parseFixedWidthReal(buf, &x1))
                 {
                     v[i][m] = 0;
                 }
@@ -433,16 +457,35 @@ int gro_first_x_or_v(FILE* status, t_trxframe* fr)
     return fr->natoms;
 }
 
-static const char* get_hconf_format(bool haveVelocities)
+/*! \brief Appends a line for one atom in gro format to \p buffer
+ *
+ * \p v can be nullptr, then no velocities are written.
+ */
+static void appendGroAtomLine(std::string* buffer,
+                              int          residueNumber,
+                              const char*  residueName,
+                              const char*  atomName,
+                              int          atomNumber,
+                              const rvec   x,
+                              const rvec*  v)
 {
-    if (haveVelocities)
+    char line[256];
+    int  length;
+    if (v)
     {
-        return "%8.3f%8.3f%8.3f%8.4f%8.4f%8.4f\n";
+        length = snprintf(line, sizeof(line), "%5d%-5.5s%5.5s%5d%8.3f%8.3f%8.3f%8.4f%8.4f%8.4f\n",
+                          residueNumber % 100000, residueName, atomName, atomNumber % 100000,
+                          x[XX], x[YY], x[ZZ], (*v)[XX], (*v)[YY], (*v)[ZZ]);
     }
     else
     {
-        return "%8.3f%8.3f%8.3f\n";
+        length = snprintf(line, sizeof(line), "%5d%-5.5s%5.5s%5d%8.3f%8.3f%8.3f\n",
+                          residueNumber % 100000, residueName, atomName, atomNumber % 100000,
+                          x[XX], x[YY], x[ZZ]);
     }
+    GMX_RELEASE_ASSERT(length > 0 && length < static_cast<int>(sizeof(line)),
+                       "The gro line buffer is too small");
+    buffer->append(line, length);
 }
 
 static void write_hconf_box(FILE* out, const matrix box)
@@ -469,51 +512,29 @@ void write_hconf_indexed_p(FILE*          out,
                            const rvec*    v,
                            const matrix   box)
 {
-    int ai, i, resind, resnr;
-
     fprintf(out, "%s\n", (title && title[0]) ? title : gmx::bromacs().c_str());
     fprintf(out, "%5d\n", nx);
 
-    const char* format = get_hconf_format(v != nullptr);
-
-    for (i = 0; (i < nx); i++)
-    {
-        ai = index[i];
-
-        resind = atoms->atom[ai].resind;
-        std::string resnm;
-        if (resind < atoms->nres)
-        {
-            resnm = *atoms->resinfo[resind].name;
-            resnr = atoms->resinfo[resind].nr;
-        }
-        else
+    /* Format the atom lines in parallel, this can take long for large systems */
+    gmx::formatAndWriteInChunks(out, nx, [=](int begin, int end, std::string* buffer) {
+        for (int i = begin; i < end; i++)
         {
-            resnm = " ??? ";
-            resnr = resind + 1;
-        }
+            const int ai = index[i];
 
-        std::string nm;
-        if (atoms->atom)
-        {
-            nm = *atoms->atomname[ai];
-        }
-        else
-        {
-            nm = " ??? ";
-        }
+            const int   resind = atoms->atom[ai].resind;
+            const char* resnm  = " ??? ";
+            int         resnr  = resind + 1;
+            if (resind < atoms->nres)
+            {
+                resnm = *atoms->resinfo[resind].name;
+                resnr = atoms->resinfo[resind].nr;
+            }
 
-        fprintf(out, "%5d%-5.5s%5.5s%5d", resnr % 100000, resnm.c_str(), nm.c_str(), (ai + 1) % 100000);
-        /* next fprintf uses built format string */
-        if (v)
-        {
-            fprintf(out, format, x[ai][XX], x[ai][YY], x[ai][ZZ], v[ai][XX], v[ai][YY], v[ai][ZZ]);
-        }
-        else
-        {
-            fprintf(out, format, x[ai][XX], x[ai][YY], x[ai][ZZ]);
+            const char* nm = atoms->atom ? *atoms->atomname[ai] : " ??? ";
+
+            appendGroAtomLine(buffer, resnr, resnm, nm, ai + 1, x[ai], v ? &v[ai] : nullptr);
         }
-    }
+    });
 
     write_hconf_box(out, box);
 
@@ -525,26 +546,21 @@ void write_hconf_mtop(FILE* out, const char* title, const gmx_mtop_t* mtop, cons
     fprintf(out, "%s\n", (title && title[0]) ? title : gmx::bromacs().c_str());
     fprintf(out, "%5d\n", mtop->natoms);
 
-    const char* format = get_hconf_format(v != nullptr);
-
-    for (const AtomProxy atomP : AtomRange(*mtop))
-    {
-        int         i             = atomP.globalAtomNumber();
-        int         residueNumber = atomP.residueNumber();
-        const char* atomName      = atomP.atomName();
-        const char* residueName   = atomP.residueName();
-
-        fprintf(out, "%5d%-5.5s%5.5s%5d", residueNumber % 100000, residueName, atomName, (i + 1) % 100000);
-        /* next fprintf uses built format string */
-        if (v)
+    /* Format the atom lines in parallel, this can take long for large systems */
+    gmx::formatAndWriteInChunks(out, mtop->natoms, [=](int begin, int end, std::string* buffer) {
+        int moleculeBlock = 0;
+        for (int i = begin; i < end; i++)
         {
-            fprintf(out, format, x[i][XX], x[i][YY], x[i][ZZ], v[i][XX], v[i][YY], v[i][ZZ]);
+            const char* atomName;
+            int         residueNumber;
+            const char* residueName;
+            mtopGetAtomAndResidueName(mtop, i, &moleculeBlock, &atomName, &residueNumber,
+                                      &residueName, nullptr);
+
+            appendGroAtomLine(buffer, residueNumber, residueName, atomName, i + 1, x[i],
+                              v ? &v[i] : nullptr);
         }
-        else
-        {
-            fprintf(out, format, x[i][XX], x[i][YY], x[i][ZZ]);
-        }
-    }
+    });
 
     write_hconf_box(out, box);
 
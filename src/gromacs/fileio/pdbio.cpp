@@ -46,19 +46,20 @@
 
 #include <string>
 
+#include "gromacs/fileio/chunkedwriter.h"
 #include "gromacs/fileio/gmxfio.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/topology/atomprop.h"
 #include "gromacs/topology/ifunc.h"
-#include "gromacs/topology/residuetypes.h"
 #include "gromacs/topology/symtab.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/coolstuff.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/snprintf.h"
 
@@ -253,18 +254,25 @@ static void read_cryst1(char* line, PbcType* pbcType, matrix box)
     }
 }
 
-static int gmx_fprintf_pqr_atomline(FILE*           fp,
-                                    enum PDB_record record,
-                                    int             atom_seq_number,
-                                    const char*     atom_name,
-                                    const char*     res_name,
-                                    char            chain_id,
-                                    int             res_seq_number,
-                                    real            x,
-                                    real            y,
-                                    real            z,
-                                    real            occupancy,
-                                    real            b_factor)
+//! The size of the buffers for formatting a single line of a PDB file
+static constexpr int c_pdbLineBufferSize = 256;
+
+/*! \brief Formats an atom line in PQR format into \p line
+ *
+ * \returns The number of characters written.
+ */
+static int formatPqrAtomLine(char*           line,
+                             enum PDB_record record,
+                             int             atom_seq_number,
+                             const char*     atom_name,
+                             const char*     res_name,
+                             char            chain_id,
+                             int             res_seq_number,
+                             real            x,
+                             real            y,
+                             real            z,
+                             real            occupancy,
+                             real            b_factor)
 {
     GMX_RELEASE_ASSERT(record == epdbATOM || record == epdbHETATM,
                        "Can only print PQR atom lines as ATOM or HETATM records");
@@ -279,13 +287,31 @@ static int gmx_fprintf_pqr_atomline(FILE*           fp,
     atom_seq_number = atom_seq_number % 100000;
     res_seq_number  = res_seq_number % 10000;
 
-    int n = fprintf(fp, "%-6s%5d %-4.4s%4.4s%c%4d %8.3f %8.3f %8.3f %6.2f %6.2f\n", pdbtp[record],
-                    atom_seq_number, atom_name, res_name, chain_id, res_seq_number, x, y, z,
-                    occupancy, b_factor);
+    int n = snprintf(line, c_pdbLineBufferSize,
+                     "%-6s%5d %-4.4s%4.4s%c%4d %8.3f %8.3f %8.3f %6.2f %6.2f\n", pdbtp[record],
+                     atom_seq_number, atom_name, res_name, chain_id, res_seq_number, x, y, z,
+                     occupancy, b_factor);
+    GMX_RELEASE_ASSERT(n > 0 && n < c_pdbLineBufferSize, "The PQR line buffer is too small");
 
     return n;
 }
 
+static int formatPdbAtomLine(char*           line,
+                             enum PDB_record record,
+                             int             atom_seq_number,
+                             const char*     atom_name,
+                             char            alternate_location,
+                             const char*     res_name,
+                             char            chain_id,
+                             int             res_seq_number,
+                             char            res_insertion_code,
+                             real            x,
+                             real            y,
+                             real            z,
+                             real            occupancy,
+                             real            b_factor,
+                             const char*     element);
+
 void write_pdbfile_indexed(FILE*          out,
                            const char*    title,
                            const t_atoms* atoms,
@@ -299,12 +325,8 @@ void write_pdbfile_indexed(FILE*          out,
                            gmx_conect     conect,
                            bool           usePqrFormat)
 {
-    gmx_conect_t*   gc = static_cast<gmx_conect_t*>(conect);
-    enum PDB_record type;
-    char            altloc;
-    real            occup, bfac;
-    gmx_bool        bOccup;
-
+    gmx_conect_t* gc = static_cast<gmx_conect_t*>(conect);
+    gmx_bool      bOccup;
 
     fprintf(out, "TITLE     %s\n", (title && title[0]) ? title : gmx::bromacs().c_str());
     if (box && ((norm2(box[XX]) != 0.0F) || (norm2(box[YY]) != 0.0F) || (norm2(box[ZZ]) != 0.0F)))
@@ -330,73 +352,83 @@ void write_pdbfile_indexed(FILE*          out,
 
     fprintf(out, "MODEL %8d\n", model_nr > 0 ? model_nr : 1);
 
-    ResidueType rt;
-    for (int ii = 0; ii < nindex; ii++)
-    {
-        int         i      = index[ii];
-        int         resind = atoms->atom[i].resind;
-        std::string resnm  = *atoms->resinfo[resind].name;
-        std::string nm     = *atoms->atomname[i];
-
-        /* rename HG12 to 2HG1, etc. */
-        nm                  = xlate_atomname_gmx2pdb(nm);
-        int           resnr = atoms->resinfo[resind].nr;
-        unsigned char resic = atoms->resinfo[resind].ic;
-        unsigned char ch;
-        if (chainid != ' ')
+    /* Format the atom lines in parallel, this can take long for large systems */
+    gmx::formatAndWriteInChunks(out, nindex, [=](int begin, int end, std::string* buffer) {
+        char line[c_pdbLineBufferSize];
+        for (int ii = begin; ii < end; ii++)
         {
-            ch = chainid;
-        }
-        else
-        {
-            ch = atoms->resinfo[resind].chainid;
+            int         i      = index[ii];
+            int         resind = atoms->atom[i].resind;
+            const char* resnm  = *atoms->resinfo[resind].name;
+
+            /* rename HG12 to 2HG1, etc. */
+            std::string   nm    = xlate_atomname_gmx2pdb(*atoms->atomname[i]);
+            int           resnr = atoms->resinfo[resind].nr;
+            unsigned char resic = atoms->resinfo[resind].ic;
+            unsigned char ch;
+            if (chainid != ' ')
+            {
+                ch = chainid;
+            }
+            else
+            {
+                ch = atoms->resinfo[resind].chainid;
 
-            if (ch == 0)
+                if (ch == 0)
+                {
+                    ch = ' ';
+                }
+            }
+            if (resnr >= 10000)
             {
-                ch = ' ';
+                resnr = resnr % 10000;
             }
-        }
-        if (resnr >= 10000)
-        {
-            resnr = resnr % 10000;
-        }
-        t_pdbinfo pdbinfo;
-        if (atoms->pdbinfo != nullptr)
-        {
-            pdbinfo = atoms->pdbinfo[i];
-        }
-        else
-        {
-            gmx_pdbinfo_init_default(&pdbinfo);
-        }
-        type   = static_cast<enum PDB_record>(pdbinfo.type);
-        altloc = pdbinfo.altloc;
-        if (!isalnum(altloc))
-        {
-            altloc = ' ';
-        }
-        occup = bOccup ? 1.0 : pdbinfo.occup;
-        bfac  = pdbinfo.bfac;
-        if (!usePqrFormat)
-        {
-            gmx_fprintf_pdb_atomline(out, type, i + 1, nm.c_str(), altloc, resnm.c_str(), ch, resnr,
-                                     resic, 10 * x[i][XX], 10 * x[i][YY], 10 * x[i][ZZ], occup,
-                                     bfac, atoms->atom[i].elem);
+            t_pdbinfo pdbinfo;
+            if (atoms->pdbinfo != nullptr)
+            {
+                pdbinfo = atoms->pdbinfo[i];
+            }
+            else
+            {
+                gmx_pdbinfo_init_default(&pdbinfo);
+            }
+            enum PDB_record type   = static_cast<enum PDB_record>(pdbinfo.type);
+            char            altloc = pdbinfo.altloc;
+            if (!isalnum(altloc))
+            {
+                altloc = ' ';
+            }
+            real occup = bOccup ? 1.0 : pdbinfo.occup;
+            real bfac  = pdbinfo.bfac;
+            if (!usePqrFormat)
+            {
+                int n = formatPdbAtomLine(line, type, i + 1, nm.c_str(), altloc, resnm, ch, resnr,
+                                          resic, 10 * x[i][XX], 10 * x[i][YY], 10 * x[i][ZZ],
+                                          occup, bfac, atoms->atom[i].elem);
+                buffer->append(line, n);
 
-            if (atoms->pdbinfo && atoms->pdbinfo[i].bAnisotropic)
+                if (atoms->pdbinfo && atoms->pdbinfo[i].bAnisotropic)
+                {
+                    n = snprintf(line, sizeof(line),
+                                 "ANISOU%5d  %-4.4s%4.4s%c%4d%c %7d%7d%7d%7d%7d%7d\n",
+                                 (i + 1) % 100000, nm.c_str(), resnm, ch, resnr,
+                                 (resic == '\0') ? ' ' : resic, atoms->pdbinfo[i].uij[0],
+                                 atoms->pdbinfo[i].uij[1], atoms->pdbinfo[i].uij[2],
+                                 atoms->pdbinfo[i].uij[3], atoms->pdbinfo[i].uij[4],
+                                 atoms->pdbinfo[i].uij[5]);
+                    GMX_RELEASE_ASSERT(n > 0 && n < c_pdbLineBufferSize,
+                                       "The PDB line buffer is too small");
+                    buffer->append(line, n);
+                }
+            }
+            else
             {
-                fprintf(out, "ANISOU%5d  %-4.4s%4.4s%c%4d%c %7d%7d%7d%7d%7d%7d\n", (i + 1) % 100000,
-                        nm.c_str(), resnm.c_str(), ch, resnr, (resic == '\0') ? ' ' : resic,
-                        atoms->pdbinfo[i].uij[0], atoms->pdbinfo[i].uij[1], atoms->pdbinfo[i].uij[2],
-                        atoms->pdbinfo[i].uij[3], atoms->pdbinfo[i].uij[4], atoms->pdbinfo[i].uij[5]);
+                int n = formatPqrAtomLine(line, type, i + 1, nm.c_str(), resnm, ch, resnr,
+                                          10 * x[i][XX], 10 * x[i][YY], 10 * x[i][ZZ], occup, bfac);
+                buffer->append(line, n);
             }
         }
-        else
-        {
-            gmx_fprintf_pqr_atomline(out, type, i + 1, nm.c_str(), resnm.c_str(), ch, resnr,
-                                     10 * x[i][XX], 10 * x[i][YY], 10 * x[i][ZZ], occup, bfac);
-        }
-    }
+    });
 
     fprintf(out, "TER\n");
     fprintf(out, "ENDMDL\n");
@@ -1034,7 +1066,11 @@ gmx_conect gmx_conect_generate(const t_topology* top)
     return gc;
 }
 
-int gmx_fprintf_pdb_atomline(FILE*           fp,
+/*! \brief Formats an atom line in PDB format into \p line
+ *
+ * \returns The number of characters written.
+ */
+static int formatPdbAtomLine(char*           line,
                              enum PDB_record record,
                              int             atom_seq_number,
                              const char*     atom_name,
@@ -1097,10 +1133,37 @@ int gmx_fprintf_pdb_atomline(FILE*           fp,
     atom_seq_number = atom_seq_number % 100000;
     res_seq_number  = res_seq_number % 10000;
 
-    n = fprintf(fp, "%-6s%5d %-4.4s%c%4.4s%c%4d%c   %8.3f%8.3f%8.3f%6.2f%6.2f          %2s\n",
-                pdbtp[record], atom_seq_number, tmp_atomname, alternate_location, tmp_resname,
-                chain_id, res_seq_number, res_insertion_code, x, y, z, occupancy, b_factor,
-                (element != nullptr) ? element : "");
+    n = snprintf(line, c_pdbLineBufferSize,
+                 "%-6s%5d %-4.4s%c%4.4s%c%4d%c   %8.3f%8.3f%8.3f%6.2f%6.2f          %2s\n",
+                 pdbtp[record], atom_seq_number, tmp_atomname, alternate_location, tmp_resname,
+                 chain_id, res_seq_number, res_insertion_code, x, y, z, occupancy, b_factor,
+                 (element != nullptr) ? element : "");
+    GMX_RELEASE_ASSERT(n > 0 && n < c_pdbLineBufferSize, "The PDB line buffer is too small");
+
+    return n;
+}
+
+int gmx_fprintf_pdb_atomline(FILE*           fp,
+                             enum PDB_record record,
+                             int             atom_seq_number,
+                             const char*     atom_name,
+                             char            alternate_location,
+                             const char*     res_name,
+                             char            chain_id,
+                             int             res_seq_number,
+                             char            res_insertion_code,
+                             real            x,
+                             real            y,
+                             real            z,
+                             real            occupancy,
+                             real            b_factor,
+                             const char*     element)
+{
+    char line[c_pdbLineBufferSize];
+    int  n = formatPdbAtomLine(line, record, atom_seq_number, atom_name, alternate_location,
+                              res_name, chain_id, res_seq_number, res_insertion_code, x, y, z,
+                              occupancy, b_factor, element);
+    fputs(line, fp);
 
     return n;
 }
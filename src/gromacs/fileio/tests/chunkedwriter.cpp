@@ -0,0 +1,113 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for formatting and writing lines in parallel chunks.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/chunkedwriter.h"
+
+#include <cstdio>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/stringutil.h"
+#include "gromacs/utility/textreader.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Writes \p numItems lines with formatAndWriteInChunks and returns the file contents
+std::string writeLinesInChunks(int numItems)
+{
+    TestFileManager   fileManager;
+    const std::string filename = fileManager.getTemporaryFilePath("chunks.txt");
+    FILE*             fp       = gmx_ffopen(filename, "w");
+    fprintf(fp, "header\n");
+    formatAndWriteInChunks(fp, numItems, [](int begin, int end, std::string* buffer) {
+        for (int i = begin; i < end; i++)
+        {
+            buffer->append(formatString("%8d%8.3f\n", i, 0.5 * i));
+        }
+    });
+    fprintf(fp, "footer\n");
+    gmx_ffclose(fp);
+    return TextReader::readFileToString(filename);
+}
+
+//! Returns the lines that writeLinesInChunks should produce for \p numItems items
+std::string referenceLines(int numItems)
+{
+    std::string reference = "header\n";
+    for (int i = 0; i < numItems; i++)
+    {
+        reference.append(formatString("%8d%8.3f\n", i, 0.5 * i));
+    }
+    reference.append("footer\n");
+    return reference;
+}
+
+TEST(ChunkedWriterTest, WritesNothingWithoutItems)
+{
+    EXPECT_EQ(writeLinesInChunks(0), referenceLines(0));
+}
+
+TEST(ChunkedWriterTest, WritesFewItemsInOrder)
+{
+    EXPECT_EQ(writeLinesInChunks(10), referenceLines(10));
+}
+
+TEST(ChunkedWriterTest, WritesManyChunksInOrder)
+{
+    // Enough items for several chunks per thread and a partial last chunk
+    const int numItems = 250001;
+    EXPECT_EQ(writeLinesInChunks(numItems), referenceLines(numItems));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
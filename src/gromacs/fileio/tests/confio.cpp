@@ -58,6 +58,7 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/smalloc.h"
+#include "gromacs/utility/stringutil.h"
 
 #include "testutils/stringtest.h"
 #include "testutils/testfilemanager.h"
@@ -205,4 +206,72 @@ INSTANTIATE_TEST_CASE_P(WithDifferentFormats,
                         StructureIORoundtripTest,
                         ::testing::Values(efGRO, efG96, efPDB, efESP));
 
+/*! \brief
+ * Tests that structures with more atoms than fit in one chunk of
+ * the parallel formatting are written completely and in order.
+ */
+class LargeStructureIORoundtripTest : public ::testing::TestWithParam<GromacsFileType>
+{
+};
+
+TEST_P(LargeStructureIORoundtripTest, ReadWriteTpsConf)
+{
+    gmx::test::TestFileManager fileManager;
+    const std::string          filename =
+            fileManager.getTemporaryFilePath(std::string("large.") + ftp2ext(GetParam()));
+
+    // Residue numbers stay below the 10000 limit of the PDB format
+    const int atomCount       = 30000;
+    const int atomsPerResidue = 4;
+    t_symtab  symtab;
+    t_atoms   atoms;
+    open_symtab(&symtab);
+    init_t_atoms(&atoms, atomCount, FALSE);
+    std::vector<gmx::RVec> x;
+    for (int i = 0; i < atomCount; ++i)
+    {
+        const std::string name = gmx::formatString("C%d", i % atomsPerResidue);
+        atoms.atomname[i]      = put_symtab(&symtab, name.c_str());
+        atoms.atom[i].resind   = i / atomsPerResidue;
+        if (i % atomsPerResidue == 0)
+        {
+            t_atoms_set_resinfo(&atoms, i, &symtab, "RES", i / atomsPerResidue + 1, ' ', 0, ' ');
+        }
+        x.emplace_back(0.1 * (i % 97), 0.01 * (i % 1013), 0.001 * i);
+    }
+    atoms.nres = atomCount / atomsPerResidue;
+    matrix box = { { 10, 0, 0 }, { 0, 11, 0 }, { 0, 0, 31 } };
+    write_sto_conf(filename.c_str(), "Large system", &atoms, as_rvec_array(x.data()), nullptr,
+                   PbcType::Unset, box);
+
+    t_topology* top;
+    snew(top, 1);
+    rvec*   testX   = nullptr;
+    PbcType pbcType = PbcType::Unset;
+    matrix  testBox;
+    read_tps_conf(filename.c_str(), top, &pbcType, &testX, nullptr, testBox, FALSE);
+    ASSERT_EQ(top->atoms.nr, atomCount);
+    ASSERT_EQ(top->atoms.nres, atoms.nres);
+    for (int i = 0; i < atomCount; ++i)
+    {
+        SCOPED_TRACE(gmx::formatString("Checking atom %d", i));
+        EXPECT_STREQ(*top->atoms.atomname[i], *atoms.atomname[i]);
+        EXPECT_EQ(top->atoms.resinfo[top->atoms.atom[i].resind].nr, i / atomsPerResidue + 1);
+        for (int d = 0; d < DIM; d++)
+        {
+            EXPECT_NEAR(testX[i][d], x[i][d], 0.0006);
+        }
+    }
+
+    sfree(testX);
+    done_top(top);
+    sfree(top);
+    done_atom(&atoms);
+    done_symtab(&symtab);
+}
+
+INSTANTIATE_TEST_CASE_P(WithDifferentFormats,
+                        LargeStructureIORoundtripTest,
+                        ::testing::Values(efGRO, efPDB));
+
 } // namespace
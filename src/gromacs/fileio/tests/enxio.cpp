@@ -0,0 +1,225 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the frame index and term selection of energy file reading.
+ *
+ * \ingroup module_fileio
+ */
+#include "gmxpre.h"
+
+#include "gromacs/fileio/enxio.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/trajectory/energyframe.h"
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/smalloc.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! The number of energy terms in the test file
+constexpr int c_numTerms = 4;
+//! The number of frames in the test file
+constexpr int c_numFrames = 10;
+//! The number of values in the data block of each frame
+constexpr int c_blockSize = 3;
+
+class EnxioTest : public ::testing::Test
+{
+public:
+    //! Write a test energy file with a data block in every frame
+    void writeFile()
+    {
+        ener_file_t  ef = open_enx(filename_.c_str(), "w");
+        gmx_enxnm_t* nms;
+        int          nre = c_numTerms;
+
+        snew(nms, c_numTerms);
+        for (int i = 0; i < c_numTerms; i++)
+        {
+            std::string name = "Term" + std::to_string(i);
+            nms[i].name      = gmx_strdup(name.c_str());
+            nms[i].unit      = gmx_strdup("kJ/mol");
+        }
+        do_enxnms(ef, &nre, &nms);
+        free_enxnms(c_numTerms, nms);
+
+        t_enxframe fr;
+        init_enxframe(&fr);
+        fr.nre = c_numTerms;
+        snew(fr.ener, c_numTerms);
+        fr.e_alloc = c_numTerms;
+        add_blocks_enxframe(&fr, 1);
+        fr.nblock = 1;
+        add_subblocks_enxblock(&fr.block[0], 1);
+        fr.block[0].id = enxDH;
+        std::vector<double> blockData(c_blockSize);
+        fr.block[0].sub[0].type = xdr_datatype_double;
+        fr.block[0].sub[0].nr   = c_blockSize;
+        fr.block[0].sub[0].dval = blockData.data();
+        for (int f = 0; f < c_numFrames; f++)
+        {
+            fr.t      = 0.5 * f;
+            fr.step   = 10 * f;
+            fr.nsteps = 10;
+            fr.nsum   = 1;
+            for (int i = 0; i < c_numTerms; i++)
+            {
+                fr.ener[i].e = termValue(f, i);
+            }
+            for (int i = 0; i < c_blockSize; i++)
+            {
+                blockData[i] = -termValue(f, i);
+            }
+            do_enx(ef, &fr);
+        }
+        fr.block[0].sub[0].dval = nullptr;
+        free_enxframe(&fr);
+        done_ener_file(ef);
+    }
+    //! Open the test file for reading and read the energy names
+    ener_file_t openForReading()
+    {
+        ener_file_t  ef  = open_enx(filename_.c_str(), "r");
+        gmx_enxnm_t* nms = nullptr;
+        int          nre;
+        do_enxnms(ef, &nre, &nms);
+        free_enxnms(nre, nms);
+        return ef;
+    }
+    //! The value of term \p i in frame \p f
+    static real termValue(int f, int i) { return 100 * f + i; }
+
+    TestFileManager fileManager_;
+    std::string     filename_ = fileManager_.getTemporaryFilePath("test.edr");
+};
+
+TEST_F(EnxioTest, FrameIndexContainsAllFrames)
+{
+    writeFile();
+    ener_file_t ef = openForReading();
+
+    std::vector<t_enxindexentry> index = enx_build_frame_index(ef);
+    ASSERT_EQ(c_numFrames, index.size());
+    for (int f = 0; f < c_numFrames; f++)
+    {
+        EXPECT_EQ(0.5 * f, index[f].t);
+        EXPECT_EQ(10 * f, index[f].step);
+        EXPECT_EQ(c_numTerms, index[f].nre);
+        EXPECT_EQ(1, index[f].nblock);
+    }
+    EXPECT_EQ(4, enx_find_frame_time(index, 1.75));
+    EXPECT_EQ(4, enx_find_frame_time(index, 2.0));
+    EXPECT_EQ(c_numFrames, enx_find_frame_time(index, 100.0));
+
+    // Building the index rewinds the file to the first frame
+    t_enxframe fr;
+    init_enxframe(&fr);
+    ASSERT_TRUE(do_enx(ef, &fr));
+    EXPECT_EQ(0, fr.step);
+
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+TEST_F(EnxioTest, CanSeekToFrame)
+{
+    writeFile();
+    ener_file_t ef = openForReading();
+
+    std::vector<t_enxindexentry> index = enx_build_frame_index(ef);
+    t_enxframe                   fr;
+    init_enxframe(&fr);
+    for (int f : { 7, 2, 9 })
+    {
+        enx_seek_frame(ef, index, f);
+        ASSERT_TRUE(do_enx(ef, &fr));
+        EXPECT_EQ(10 * f, fr.step);
+        ASSERT_EQ(c_numTerms, fr.nre);
+        for (int i = 0; i < c_numTerms; i++)
+        {
+            EXPECT_EQ(termValue(f, i), fr.ener[i].e);
+        }
+        ASSERT_EQ(1, fr.nblock);
+        EXPECT_EQ(-termValue(f, 1), fr.block[0].sub[0].dval[1]);
+    }
+    enx_seek_frame(ef, index, c_numFrames);
+    EXPECT_FALSE(do_enx(ef, &fr));
+
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+TEST_F(EnxioTest, ReadsOnlySelectedTerms)
+{
+    writeFile();
+    ener_file_t ef = openForReading();
+
+    const std::vector<int> selection = { 1, 3 };
+    enx_select_terms(ef, selection.size(), selection.data(), FALSE);
+
+    t_enxframe fr;
+    init_enxframe(&fr);
+    for (int f = 0; f < c_numFrames; f++)
+    {
+        ASSERT_TRUE(do_enx(ef, &fr));
+        EXPECT_EQ(10 * f, fr.step);
+        ASSERT_EQ(c_numTerms, fr.nre);
+        EXPECT_EQ(0, fr.ener[0].e);
+        EXPECT_EQ(termValue(f, 1), fr.ener[1].e);
+        EXPECT_EQ(0, fr.ener[2].e);
+        EXPECT_EQ(termValue(f, 3), fr.ener[3].e);
+        EXPECT_EQ(0, fr.nblock);
+    }
+    EXPECT_FALSE(do_enx(ef, &fr));
+
+    free_enxframe(&fr);
+    done_ener_file(ef);
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
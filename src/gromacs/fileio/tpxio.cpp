@@ -70,9 +70,11 @@
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/baseversion.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/inmemoryserializer.h"
 #include "gromacs/utility/keyvaluetreebuilder.h"
 #include "gromacs/utility/keyvaluetreeserializer.h"
@@ -132,6 +134,7 @@ enum tpxv
     tpxv_AddSizeField, /**< Added field with information about the size of the serialized tpr file in bytes, excluding the header */
     tpxv_StoreNonBondedInteractionExclusionGroup, /**< Store the non bonded interaction exclusion group in the topology */
     tpxv_VSite1,                                  /**< Added 1 type virtual site */
+    tpxv_MultipleTimeStepping, /**< Added multiple time stepping for long-range nonbonded forces */
     tpxv_Count                                    /**< the total number of tpxv versions */
 };
 
@@ -1082,6 +1085,17 @@ static void do_inputrec(gmx::ISerializer* serializer, t_inputrec* ir, int file_v
 
     serializer->doInt(&ir->simulation_part);
 
+    if (file_version >= tpxv_MultipleTimeStepping)
+    {
+        serializer->doBool(&ir->useMts);
+        serializer->doInt(&ir->mtsFactor);
+    }
+    else
+    {
+        ir->useMts    = false;
+        ir->mtsFactor = 1;
+    }
+
     if (file_version >= 67)
     {
         serializer->doInt(&ir->nstcalcenergy);
@@ -2452,6 +2466,46 @@ static void do_moltype(gmx::ISerializer* serializer, gmx_moltype_t* molt, t_symt
     doListOfLists(serializer, &molt->excls);
 }
 
+/*! \brief Serializes all molecule types of \p mtop
+ *
+ * When writing to memory, each molecule type is serialized into its own
+ * buffer in parallel and the buffers are appended in order, which gives
+ * output identical to serial writing. Writing only reads the topology,
+ * and the symbol table lookup was already set up when serializing the
+ * topology name, so concurrent symbol lookups are safe.
+ */
+static void do_moltypes(gmx::ISerializer* serializer, gmx_mtop_t* mtop, int file_version)
+{
+    auto*     memorySerializer = dynamic_cast<gmx::InMemorySerializer*>(serializer);
+    const int numThreads       = std::min(gmx_omp_get_max_threads(), int(mtop->moltype.size()));
+    if (memorySerializer == nullptr || numThreads <= 1)
+    {
+        for (gmx_moltype_t& moltype : mtop->moltype)
+        {
+            do_moltype(serializer, &moltype, &mtop->symtab, file_version);
+        }
+        return;
+    }
+
+    const gmx::EndianSwapBehavior  endianSwapBehavior = memorySerializer->endianSwapBehavior();
+    std::vector<std::vector<char>> buffers(mtop->moltype.size());
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (gmx::index mt = 0; mt < gmx::ssize(mtop->moltype); mt++)
+    {
+        try
+        {
+            gmx::InMemorySerializer moltypeSerializer(endianSwapBehavior);
+            do_moltype(&moltypeSerializer, &mtop->moltype[mt], &mtop->symtab, file_version);
+            buffers[mt] = moltypeSerializer.finishAndGetBuffer();
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    for (std::vector<char>& buffer : buffers)
+    {
+        serializer->doOpaque(buffer.data(), buffer.size());
+    }
+}
+
 static void do_molblock(gmx::ISerializer* serializer, gmx_molblock_t* molb, int numAtomsPerMolecule)
 {
     serializer->doInt(&molb->type);
@@ -2527,10 +2581,7 @@ static void do_mtop(gmx::ISerializer* serializer, gmx_mtop_t* mtop, int file_ver
     {
         mtop->moltype.resize(nmoltype);
     }
-    for (gmx_moltype_t& moltype : mtop->moltype)
-    {
-        do_moltype(serializer, &moltype, &mtop->symtab, file_version);
-    }
+    do_moltypes(serializer, mtop, file_version);
 
     int nmolblock = mtop->molblock.size();
     serializer->doInt(&nmolblock);
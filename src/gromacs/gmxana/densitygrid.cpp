@@ -0,0 +1,264 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the grid for accumulating densities of positions.
+ */
+#include "gmxpre.h"
+
+#include "densitygrid.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+
+#include "gromacs/fileio/mrcdensitymap.h"
+#include "gromacs/fileio/mrcdensitymapheader.h"
+#include "gromacs/math/gausstransform.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/futil.h"
+#include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
+#include "gromacs/utility/inmemoryserializer.h"
+
+namespace gmx
+{
+
+//! The range of the spread Gaussians in multiples of sigma
+static constexpr double c_spreadWidthMultiplesOfSigma = 4.0;
+
+class DensityGrid::Impl
+{
+public:
+    Impl(const IVec& numBins, real sigma);
+
+    //! Adds positions \p begin to \p end to the grid of thread \p thread
+    void addRange(int                  thread,
+                  ArrayRef<const RVec> x,
+                  ArrayRef<const real> weights,
+                  real                 weight,
+                  int                  begin,
+                  int                  end);
+
+    //! The number of bins along each dimension
+    IVec numBins_;
+    //! The number of threads that accumulate into their own grid
+    int numThreads_;
+    //! Thread-local grids, used without Gaussian spreading
+    std::vector<std::vector<double>> binnedGrids_;
+    //! Thread-local Gauss transforms, used with Gaussian spreading
+    std::vector<GaussTransform3D> gaussTransforms_;
+};
+
+DensityGrid::Impl::Impl(const IVec& numBins, real sigma) :
+    numBins_(numBins),
+    numThreads_(gmx_omp_get_max_threads())
+{
+    GMX_RELEASE_ASSERT(numBins[XX] > 0 && numBins[YY] > 0 && numBins[ZZ] > 0,
+                       "Need at least one bin along each dimension");
+    if (sigma > 0)
+    {
+        const dynamicExtents3D                      extents(numBins[ZZ], numBins[YY], numBins[XX]);
+        const GaussianSpreadKernelParameters::Shape shape = { DVec(sigma, sigma, sigma),
+                                                              c_spreadWidthMultiplesOfSigma };
+        gaussTransforms_.assign(numThreads_, GaussTransform3D(extents, shape));
+    }
+    else
+    {
+        binnedGrids_.resize(numThreads_);
+        for (auto& grid : binnedGrids_)
+        {
+            grid.resize(static_cast<size_t>(numBins[XX]) * numBins[YY] * numBins[ZZ]);
+        }
+    }
+}
+
+void DensityGrid::Impl::addRange(int                  thread,
+                                 ArrayRef<const RVec> x,
+                                 ArrayRef<const real> weights,
+                                 real                 weight,
+                                 int                  begin,
+                                 int                  end)
+{
+    if (!gaussTransforms_.empty())
+    {
+        GaussTransform3D& gaussTransform = gaussTransforms_[thread];
+        for (int i = begin; i < end; i++)
+        {
+            // Lattice point i of the Gauss transform is the center of bin i
+            const RVec coordinate = x[i] - RVec(0.5, 0.5, 0.5);
+            gaussTransform.add({ coordinate, weights.empty() ? weight : weights[i] });
+        }
+    }
+    else
+    {
+        std::vector<double>& grid = binnedGrids_[thread];
+        for (int i = begin; i < end; i++)
+        {
+            const int ix = static_cast<int>(std::floor(x[i][XX]));
+            const int iy = static_cast<int>(std::floor(x[i][YY]));
+            const int iz = static_cast<int>(std::floor(x[i][ZZ]));
+            if (ix >= 0 && ix < numBins_[XX] && iy >= 0 && iy < numBins_[YY] && iz >= 0
+                && iz < numBins_[ZZ])
+            {
+                grid[(static_cast<size_t>(iz) * numBins_[YY] + iy) * numBins_[XX] + ix] +=
+                        (weights.empty() ? weight : weights[i]);
+            }
+        }
+    }
+}
+
+DensityGrid::DensityGrid(const IVec& numBins, real sigma) : impl_(new Impl(numBins, sigma)) {}
+
+DensityGrid::~DensityGrid() = default;
+
+const IVec& DensityGrid::numBins() const
+{
+    return impl_->numBins_;
+}
+
+void DensityGrid::add(ArrayRef<const RVec> x, real weight)
+{
+    const int numThreads   = impl_->numThreads_;
+    const int numPositions = x.ssize();
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            impl_->addRange(thread, x, {}, weight, (numPositions * thread) / numThreads,
+                            (numPositions * (thread + 1)) / numThreads);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+void DensityGrid::add(ArrayRef<const RVec> x, ArrayRef<const real> weights)
+{
+    GMX_RELEASE_ASSERT(weights.size() == x.size(), "Need one weight for each position");
+
+    const int numThreads   = impl_->numThreads_;
+    const int numPositions = x.ssize();
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            impl_->addRange(thread, x, weights, 0, (numPositions * thread) / numThreads,
+                            (numPositions * (thread + 1)) / numThreads);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+std::vector<double> DensityGrid::sum() const
+{
+    const int numThreads = impl_->numThreads_;
+    const int numBins    = impl_->numBins_[XX] * impl_->numBins_[YY] * impl_->numBins_[ZZ];
+
+    std::vector<double> result(numBins);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < numBins; i++)
+    {
+        double sum = 0;
+        for (int thread = 0; thread < numThreads; thread++)
+        {
+            if (!impl_->gaussTransforms_.empty())
+            {
+                sum += impl_->gaussTransforms_[thread].constView().data()[i];
+            }
+            else
+            {
+                sum += impl_->binnedGrids_[thread][i];
+            }
+        }
+        result[i] = sum;
+    }
+
+    return result;
+}
+
+void writeDensityGridAsMrc(const std::string&     filename,
+                           const IVec&            numBins,
+                           ArrayRef<const double> data,
+                           const RVec&            origin,
+                           real                   binWidth)
+{
+    constexpr real c_nmToAngstrom = 10;
+
+    MrcDensityMapHeader header;
+    for (int d = 0; d < DIM; d++)
+    {
+        header.numColumnRowSection_[d] = numBins[d];
+        header.extent_[d]              = numBins[d];
+        header.cellLength_[d]          = numBins[d] * binWidth * c_nmToAngstrom;
+        // The MRC data points are at the centers of the bins
+        header.userDefinedFloat_[12 + d] = (origin[d] + 0.5 * binWidth) * c_nmToAngstrom;
+    }
+
+    std::vector<float> floatData(data.begin(), data.end());
+    if (!floatData.empty())
+    {
+        double sum   = 0;
+        double sumSq = 0;
+        for (const float value : floatData)
+        {
+            sum += value;
+            sumSq += value * value;
+        }
+        const auto minMax            = std::minmax_element(floatData.begin(), floatData.end());
+        header.dataStatistics_.min_  = *minMax.first;
+        header.dataStatistics_.max_  = *minMax.second;
+        header.dataStatistics_.mean_ = sum / floatData.size();
+        header.dataStatistics_.rms_  = std::sqrt(sumSq / floatData.size());
+    }
+
+    MrcDensityMapOfFloatWriter writer(header, floatData);
+    InMemorySerializer         serializer;
+    writer.write(&serializer);
+    const std::vector<char> buffer = serializer.finishAndGetBuffer();
+
+    FILE* fp = gmx_ffopen(filename, "wb");
+    if (fwrite(buffer.data(), sizeof(char), buffer.size(), fp) != buffer.size())
+    {
+        gmx_fatal(FARGS, "Error writing the density map to %s", filename.c_str());
+    }
+    gmx_ffclose(fp);
+}
+
+} // namespace gmx
@@ -0,0 +1,126 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares a grid for accumulating (weighted) densities of positions
+ * using thread-local grids, shared by the density analysis tools.
+ */
+#ifndef GMXANA_DENSITYGRID_H
+#define GMXANA_DENSITYGRID_H
+
+#include <string>
+#include <vector>
+
+#include "gromacs/math/vectypes.h"
+#include "gromacs/utility/classhelpers.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+template<typename>
+class ArrayRef;
+
+/*! \internal \brief
+ * Accumulates positions with weights on a three-dimensional grid.
+ *
+ * Positions are given in lattice coordinates, i.e. in units of bins,
+ * with the lower corner of bin (0,0,0) at the origin. A position is either
+ * added to the bin that contains it, in which case positions outside
+ * the grid are ignored, or it is spread with a Gaussian, which is truncated
+ * at the edges of the grid.
+ *
+ * Each OpenMP thread accumulates into its own copy of the grid, so adding
+ * positions requires no synchronization. The copies are only summed when
+ * the result is requested, which is usually once at the end of the analysis.
+ */
+class DensityGrid
+{
+public:
+    /*! \brief Constructs an empty grid.
+     *
+     * \param[in] numBins  The number of bins along x, y and z
+     * \param[in] sigma    Width of the Gaussian for spreading positions in bins,
+     *                     0 adds each position to the bin that contains it
+     */
+    DensityGrid(const IVec& numBins, real sigma);
+    ~DensityGrid();
+
+    //! Returns the number of bins along x, y and z.
+    const IVec& numBins() const;
+
+    /*! \brief Adds positions to the grid with weight \p weight.
+     *
+     * \param[in] x       Positions in lattice coordinates
+     * \param[in] weight  Weight of each position
+     */
+    void add(ArrayRef<const RVec> x, real weight);
+    /*! \brief Adds positions with weights to the grid.
+     *
+     * \param[in] x        Positions in lattice coordinates
+     * \param[in] weights  Weight of each position, same size as \p x
+     */
+    void add(ArrayRef<const RVec> x, ArrayRef<const real> weights);
+
+    /*! \brief Returns the grid summed over all threads.
+     *
+     * The index of bin (ix,iy,iz) is (iz*ny + iy)*nx + ix, i.e. the x index
+     * runs fastest.
+     */
+    std::vector<double> sum() const;
+
+private:
+    class Impl;
+
+    PrivateImplPointer<Impl> impl_;
+};
+
+/*! \brief Writes a grid summed by DensityGrid to an MRC density map file.
+ *
+ * \param[in] filename  Name of the MRC file
+ * \param[in] numBins   The number of bins along x, y and z
+ * \param[in] data      The grid values, with the x index running fastest
+ * \param[in] origin    The position of the lower corner of bin (0,0,0) in nm
+ * \param[in] binWidth  The width of the bins in nm
+ */
+void writeDensityGridAsMrc(const std::string&     filename,
+                           const IVec&            numBins,
+                           ArrayRef<const double> data,
+                           const RVec&            origin,
+                           real                   binWidth);
+
+} // namespace gmx
+
+#endif
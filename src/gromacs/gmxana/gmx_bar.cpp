@@ -36,6 +36,7 @@
 #include "gmxpre.h"
 
 #include <cctype>
+#include <cinttypes>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
@@ -49,6 +50,7 @@
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxana/gmx_ana.h"
+#include "gromacs/gmxana/mbar.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/mdlib/energyoutput.h"
@@ -2172,6 +2174,230 @@ static double bar_err(int nbmin, int nbmax, const double* partsum)
     return std::sqrt(svar / (nbmax + 1 - nbmin));
 }
 
+/* Set up the MBAR reduced energy matrix from the collected samples.
+   Every native lambda state needs energy differences to all other
+   native lambda states, stored as lists (not histograms). The lambda
+   data of each state is stored in state and their temperature in temp. */
+static void mbar_data_init(mbar_data_t*                 md,
+                           std::vector<lambda_data_t*>* state,
+                           double*                      temp,
+                           sim_data_t*                  sd)
+{
+    lambda_data_t* bl;
+    lambda_data_t* bl_head = sd->lb;
+
+    md->nstate = 0;
+    state->clear();
+    for (bl = bl_head->next; bl != bl_head; bl = bl->next)
+    {
+        state->push_back(bl);
+        md->nstate++;
+    }
+    if (md->nstate < 2)
+    {
+        gmx_fatal(FARGS, "MBAR needs samples from at least two lambda states");
+    }
+    *temp = (*state)[0]->temp;
+
+    /* first determine the number of samples per state and check
+       that all foreign lambda sets are present and consistent */
+    md->n.assign(md->nstate, 0);
+    md->offset.assign(md->nstate + 1, 0);
+    for (int i = 0; i < md->nstate; i++)
+    {
+        gmx_bool have_n = FALSE;
+
+        if ((*state)[i]->temp != *temp)
+        {
+            gmx_fatal(FARGS, "MBAR requires all lambda states to have the same temperature");
+        }
+        for (int k = 0; k < md->nstate; k++)
+        {
+            sample_coll_t* sc;
+
+            if (k == i)
+            {
+                continue;
+            }
+            sc = lambda_data_find_sample_coll((*state)[i], (*state)[k]->lambda);
+            if (!sc)
+            {
+                char descX[STRLEN], descY[STRLEN];
+                snprint_lambda_vec(descX, STRLEN, "X", (*state)[k]->lambda);
+                snprint_lambda_vec(descY, STRLEN, "Y", (*state)[i]->lambda);
+                gmx_fatal(FARGS,
+                          "MBAR needs the energy differences to all lambda states, but could not "
+                          "find a set for foreign lambda (state X below)\nin the files for main "
+                          "lambda (state Y below)\n\n%s\n%s\n",
+                          descX, descY);
+            }
+            for (int j = 0; j < sc->nsamples; j++)
+            {
+                if (sc->r[j].use && sc->s[j]->hist)
+                {
+                    gmx_fatal(FARGS,
+                              "MBAR needs lists of energy differences, while file %s contains "
+                              "histograms",
+                              sc->s[j]->filename);
+                }
+            }
+            if (!have_n)
+            {
+                md->n[i] = sc->ntot;
+                have_n   = TRUE;
+            }
+            else if (sc->ntot != md->n[i])
+            {
+                gmx_fatal(FARGS,
+                          "MBAR needs the same number of samples for every foreign lambda, but "
+                          "the sets in file %s have different lengths",
+                          sc->s[0]->filename);
+            }
+        }
+        md->offset[i + 1] = md->offset[i] + md->n[i];
+    }
+    md->ntot = md->offset[md->nstate];
+
+    /* then fill the matrix, row k holding the energies at state k */
+    md->u.assign(md->nstate * md->ntot, 0.);
+    const double beta = 1. / (BOLTZ * *temp);
+    for (int i = 0; i < md->nstate; i++)
+    {
+        for (int k = 0; k < md->nstate; k++)
+        {
+            sample_coll_t* sc;
+            double*        u;
+
+            if (k == i)
+            {
+                /* the energy difference with the own state is zero */
+                continue;
+            }
+            sc = lambda_data_find_sample_coll((*state)[i], (*state)[k]->lambda);
+            u  = md->u.data() + k * md->ntot + md->offset[i];
+            for (int j = 0; j < sc->nsamples; j++)
+            {
+                const samples_t*      s = sc->s[j];
+                const sample_range_t* r = &(sc->r[j]);
+                if (r->use)
+                {
+                    for (int l = r->start; l < r->end; l++)
+                    {
+                        *u++ = beta * s->du[l];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Run MBAR over all lambda states in sd and print and write the results */
+static void do_mbar(sim_data_t*             sd,
+                    double                  prec,
+                    int                     nd,
+                    int                     nbmin,
+                    int                     nbmax,
+                    const char*             fn_bar,
+                    const char*             fn_barint,
+                    const gmx_output_env_t* oenv)
+{
+    mbar_data_t                 md;
+    std::vector<lambda_data_t*> state;
+    double                      temp;
+    std::vector<double>         f, dg_err;
+    double                      dg_tot_err;
+    char                        dgformat[20], ktformat[STRLEN], kteformat[STRLEN];
+    char                        buf[STRLEN], buf2[STRLEN];
+    FILE *                      fpb = nullptr, *fpi = nullptr;
+    double                      kT;
+
+    mbar_data_init(&md, &state, &temp, sd);
+
+    printf("\nSolving the MBAR equations for %d lambda states with %" PRId64
+           " samples using %d thread(s)\n",
+           md.nstate, md.ntot, mbar_num_threads(md.ntot));
+
+    /* Determine the free energies with a factor of 10 more accuracy
+       than requested for printing. */
+    if (!calc_mbar(&md, 0.1 * prec, nbmin, nbmax, &f, &dg_err, &dg_tot_err))
+    {
+        printf("\nWARNING: the MBAR iterations did not converge to the requested precision.\n"
+               "         This usually indicates insufficient phase space overlap\n"
+               "         between neighboring lambda states.\n");
+    }
+
+    kT = BOLTZ * temp;
+    sprintf(dgformat, "%%%d.%df", 3 + nd, nd);
+    sprintf(ktformat, "%%%d.%df", 5 + nd, nd);
+    sprintf(kteformat, "%%%d.%df", 3 + nd, nd);
+
+    if (fn_bar)
+    {
+        sprintf(buf, "%s (%s)", "\\DeltaG", "kT");
+        fpb = xvgropen_type(fn_bar, "Free energy differences", "\\lambda", buf, exvggtXYDY, oenv);
+    }
+    if (fn_barint)
+    {
+        sprintf(buf, "%s (%s)", "\\DeltaG", "kT");
+        fpi = xvgropen(fn_barint, "Free energy integral", "\\lambda", buf, oenv);
+    }
+
+    printf("\nTemperature: %g K\n", temp);
+    printf("\nMBAR free energies in kT relative to the first state:\n\n");
+    for (int i = 0; i < md.nstate; i++)
+    {
+        lambda_vec_print_short(state[i]->lambda, buf);
+        printf("%s ", buf);
+        printf(ktformat, f[i]);
+        printf("\n");
+        if (fpi != nullptr)
+        {
+            fprintf(fpi, "%s ", buf);
+            fprintf(fpi, dgformat, f[i]);
+            fprintf(fpi, "\n");
+        }
+    }
+
+    printf("\n\nFinal results in kJ/mol:\n\n");
+    for (int i = 0; i < md.nstate - 1; i++)
+    {
+        if (fpb != nullptr)
+        {
+            lambda_vec_print_intermediate(state[i]->lambda, state[i + 1]->lambda, buf);
+            fprintf(fpb, "%s ", buf);
+            fprintf(fpb, dgformat, f[i + 1] - f[i]);
+            fprintf(fpb, " ");
+            fprintf(fpb, dgformat, dg_err[i]);
+            fprintf(fpb, "\n");
+        }
+
+        lambda_vec_print_short(state[i]->lambda, buf);
+        lambda_vec_print_short(state[i + 1]->lambda, buf2);
+        printf("point %s - %s,   DG ", buf, buf2);
+        printf(dgformat, (f[i + 1] - f[i]) * kT);
+        printf(" +/- ");
+        printf(dgformat, dg_err[i] * kT);
+        printf("\n");
+    }
+    printf("\n");
+    lambda_vec_print_short(state[0]->lambda, buf);
+    lambda_vec_print_short(state[md.nstate - 1]->lambda, buf2);
+    printf("total %s - %s,   DG ", buf, buf2);
+    printf(dgformat, f[md.nstate - 1] * kT);
+    printf(" +/- ");
+    printf(dgformat, dg_tot_err * kT);
+    printf("\n\n");
+
+    if (fpi != nullptr)
+    {
+        xvgrclose(fpi);
+    }
+    if (fpb != nullptr)
+    {
+        xvgrclose(fpb);
+    }
+}
+
 
 /* Seek the end of an identifier (consecutive non-spaces), followed by
    an optional number of spaces or '='-signs. Returns a pointer to the
@@ -3405,12 +3631,25 @@ int gmx_bar(int argc, char* argv[])
 
         "To get a visual estimate of the phase space overlap, use the ",
         "[TT]-oh[tt] option to write series of histograms, together with the ",
-        "[TT]-nbin[tt] option.[PAR]"
+        "[TT]-nbin[tt] option.[PAR]",
+
+        "With [TT]-mbar[tt], the free energies of all [GRK]lambda[grk] states are ",
+        "determined simultaneously with the multistate Bennett acceptance ratio ",
+        "(MBAR) method of Shirts & Chodera, J. Chem. Phys. 129, 124105 (2008), ",
+        "instead of with BAR between neighboring states. This requires that ",
+        "every simulation wrote the energy differences to all other simulated ",
+        "states as lists, e.g. using [TT]calc-lambda-neighbors = -1[tt] and ",
+        "without histograms. The MBAR equations are solved by self-consistent ",
+        "iteration, parallelized over the samples with OpenMP threads. ",
+        "The error estimates are obtained by block averaging as for BAR. ",
+        "Reading the energy differences directly from [REF].edr[ref] files ",
+        "with [TT]-g[tt] avoids parsing text files.[PAR]"
     };
     static real begin = 0, end = -1, temp = -1;
     int         nd = 2, nbmin = 5, nbmax = 5;
     int         nbin     = 100;
     gmx_bool    use_dhdl = FALSE;
+    gmx_bool    use_mbar = FALSE;
     t_pargs     pa[]     = {
         { "-b", FALSE, etREAL, { &begin }, "Begin time for BAR" },
         { "-e", FALSE, etREAL, { &end }, "End time for BAR" },
@@ -3423,7 +3662,12 @@ int gmx_bar(int argc, char* argv[])
           FALSE,
           etBOOL,
           { &use_dhdl },
-          "Whether to linearly extrapolate dH/dl values to use as energies" }
+          "Whether to linearly extrapolate dH/dl values to use as energies" },
+        { "-mbar",
+          FALSE,
+          etBOOL,
+          { &use_mbar },
+          "Use MBAR over all lambda states instead of BAR between neighboring states" }
     };
 
     t_filenm fnm[] = { { efXVG, "-f", "dhdl", ffOPTRDMULT },
@@ -3514,6 +3758,26 @@ int gmx_bar(int argc, char* argv[])
         sim_data_histogram(&sim_data, opt2fn("-oh", NFILE, fnm), nbin, oenv);
     }
 
+    if (nbmin > nbmax)
+    {
+        nbmin = nbmax;
+    }
+
+    if (use_mbar)
+    {
+        if (use_dhdl)
+        {
+            gmx_fatal(FARGS, "MBAR can not be combined with extrapolation of dH/dl values");
+        }
+        do_mbar(&sim_data, prec, nd, nbmin, nbmax, opt2fn_null("-o", NFILE, fnm),
+                opt2fn_null("-oi", NFILE, fnm), oenv);
+
+        do_view(oenv, opt2fn_null("-o", NFILE, fnm), "-xydy");
+        do_view(oenv, opt2fn_null("-oi", NFILE, fnm), "-xydy");
+
+        return 0;
+    }
+
     /* assemble the output structures from the lambdas */
     results = barres_list_create(&sim_data, &nresults, use_dhdl);
 
@@ -3563,11 +3827,6 @@ int gmx_bar(int argc, char* argv[])
     }
 
 
-    if (nbmin > nbmax)
-    {
-        nbmin = nbmax;
-    }
-
     /* first calculate results */
     bEE      = TRUE;
     disc_err = FALSE;
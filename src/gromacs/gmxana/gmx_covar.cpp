@@ -40,6 +40,10 @@
 #include <cmath>
 #include <cstring>
 
+#include <algorithm>
+#include <functional>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/matio.h"
@@ -48,6 +52,7 @@
 #include "gromacs/gmxana/eigio.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/linearalgebra/eigensolver.h"
+#include "gromacs/linearalgebra/matrix.h"
 #include "gromacs/math/do_fit.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -61,6 +66,13 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/sysinfo.h"
 
+//! The number of frames processed together in a matrix-matrix operation
+static constexpr int c_framesPerBlock = 64;
+//! The number of extra basis vectors for the randomized eigensolver
+static constexpr int c_numOversample = 10;
+//! Fixed seed, so the results of the randomized eigensolver are reproducible
+static constexpr int64_t c_randomSeed = 1993;
+
 int gmx_covar(int argc, char* argv[])
 {
     const char* desc[] = {
@@ -95,10 +107,20 @@ int gmx_covar(int argc, char* argv[])
         "of atoms involved. It is easy to run out of memory, in which",
         "case this tool will probably exit with a 'Segmentation fault'. You",
         "should consider carefully whether a reduced set of atoms will meet",
-        "your needs for lower costs."
+        "your needs for lower costs.",
+        "[PAR]",
+        "When only the first few eigenvectors are of interest, option [TT]-nev[tt]",
+        "can be used to determine only the [TT]-nev[tt] largest eigenvalues and their",
+        "eigenvectors with a randomized eigensolver. The covariance matrix is then",
+        "never stored, memory usage and run time only increase linearly with",
+        "the number of atoms. Instead the trajectory is read [TT]-npower[tt]+2 times.",
+        "Usually 1 or 2 power iterations suffice to obtain accurate eigenvalues",
+        "for the largest eigenvalues, when the eigenvalue spectrum decays slowly",
+        "more power iterations are needed. Options [TT]-ascii[tt], [TT]-xpm[tt]",
+        "and [TT]-xpma[tt] can not be used with [TT]-nev[tt]."
     };
     static gmx_bool bFit = TRUE, bRef = FALSE, bM = FALSE, bPBC = TRUE;
-    static int      end  = -1;
+    static int      end  = -1, nev = 0, npower = 2;
     t_pargs         pa[] = {
         { "-fit", FALSE, etBOOL, { &bFit }, "Fit to a reference structure" },
         { "-ref",
@@ -109,7 +131,14 @@ int gmx_covar(int argc, char* argv[])
           "average" },
         { "-mwa", FALSE, etBOOL, { &bM }, "Mass-weighted covariance analysis" },
         { "-last", FALSE, etINT, { &end }, "Last eigenvector to write away (-1 is till the last)" },
-        { "-pbc", FALSE, etBOOL, { &bPBC }, "Apply corrections for periodic boundary conditions" }
+        { "-pbc", FALSE, etBOOL, { &bPBC }, "Apply corrections for periodic boundary conditions" },
+        { "-nev",
+          FALSE,
+          etINT,
+          { &nev },
+          "Only determine this many of the largest eigenvalues with a randomized eigensolver "
+          "(0 is full diagonalization)" },
+        { "-npower", FALSE, etINT, { &npower }, "Number of power iterations with [TT]-nev[tt]" }
     };
     FILE*             out = nullptr; /* initialization makes all compilers happy */
     t_trxstatus*      status;
@@ -120,16 +149,17 @@ int gmx_covar(int argc, char* argv[])
     matrix            box, zerobox;
     real *            sqrtm, *mat, *eigenvalues, sum, trace, inv_nframes;
     real              t, tstart, tend, **mat2;
+    double            sumDeviation2;
     real              xj, *w_rls = nullptr;
     real              min, max, *axis;
     int               natoms, nat, nframes0, nframes, nlevels;
-    int64_t           ndim, i, j, k, l;
+    int64_t           ndim, neig, i, j;
     int               WriteXref;
     const char *      fitfile, *trxfile, *ndxfile;
     const char *      eigvalfile, *eigvecfile, *averfile, *logfile;
     const char *      asciifile, *xpmfile, *xpmafile;
     char              str[STRLEN], *fitname, *ananame;
-    int               d, dj, nfit;
+    int               d, nfit;
     int *             index, *ifit;
     gmx_bool          bDiffMass1, bDiffMass2;
     t_rgb             rlo, rmi, rhi;
@@ -165,6 +195,17 @@ int gmx_covar(int argc, char* argv[])
     xpmfile    = opt2fn_null("-xpm", NFILE, fnm);
     xpmafile   = opt2fn_null("-xpma", NFILE, fnm);
 
+    if (nev < 0 || npower < 0)
+    {
+        gmx_fatal(FARGS, "-nev and -npower should be >= 0");
+    }
+    if (nev > 0 && (asciifile || xpmfile || xpmafile))
+    {
+        gmx_fatal(FARGS,
+                  "Options -ascii, -xpm and -xpma require the full covariance matrix, they can "
+                  "not be used with -nev");
+    }
+
     read_tps_conf(fitfile, &top, &pbcType, &xref, nullptr, box, TRUE);
     atoms = &top.atoms;
 
@@ -254,7 +295,12 @@ int gmx_covar(int argc, char* argv[])
     {
         gmx_fatal(FARGS, "Number of degrees of freedoms to large for matrix.\n");
     }
-    snew(mat, ndim * ndim);
+    if (nev > ndim)
+    {
+        gmx_fatal(FARGS, "-nev (%d) is larger than the number of degrees of freedom (%d)", nev,
+                  static_cast<int>(ndim));
+    }
+    neig = (nev > 0 ? nev : ndim);
 
     fprintf(stderr, "Calculating the average structure ...\n");
     nframes0 = 0;
@@ -297,61 +343,56 @@ int gmx_covar(int argc, char* argv[])
                            PbcType::No, zerobox, natoms, index);
     sfree(xread);
 
-    fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim),
-            static_cast<int>(ndim));
-    nframes = 0;
-    nat     = read_first_x(oenv, &status, trxfile, &t, &xread, box);
-    tstart  = t;
-    do
-    {
-        nframes++;
-        tend = t;
-        /* calculate x: a (fitted) structure of the selected atoms */
-        if (bPBC)
-        {
-            gmx_rmpbc(gpbc, nat, box, xread);
-        }
-        if (bFit)
-        {
-            reset_x(nfit, ifit, nat, nullptr, xread, w_rls);
-            do_fit(nat, w_rls, xref, xread);
-        }
-        if (bRef)
+    /* Reads the trajectory and passes the mass-weighted deviations of the
+     * selected atoms to handleBlock, in blocks of up to c_framesPerBlock frames,
+     * so we can use efficient matrix-matrix operations.
+     */
+    std::vector<real> xblock(c_framesPerBlock * ndim);
+    auto readDeviations = [&](const std::function<void(const real*, int)>& handleBlock) {
+        int nblock = 0;
+
+        nframes       = 0;
+        sumDeviation2 = 0;
+        nat           = read_first_x(oenv, &status, trxfile, &t, &xread, box);
+        tstart        = t;
+        do
         {
-            for (i = 0; i < natoms; i++)
+            nframes++;
+            tend = t;
+            /* calculate x: a (fitted) structure of the selected atoms */
+            if (bPBC)
             {
-                rvec_sub(xread[index[i]], xref[index[i]], x[i]);
+                gmx_rmpbc(gpbc, nat, box, xread);
             }
-        }
-        else
-        {
-            for (i = 0; i < natoms; i++)
+            if (bFit)
             {
-                rvec_sub(xread[index[i]], xav[i], x[i]);
+                reset_x(nfit, ifit, nat, nullptr, xread, w_rls);
+                do_fit(nat, w_rls, xref, xread);
             }
-        }
-
-        for (j = 0; j < natoms; j++)
-        {
-            for (dj = 0; dj < DIM; dj++)
+            real* xb = xblock.data() + nblock * ndim;
+            for (i = 0; i < natoms; i++)
             {
-                k  = ndim * (DIM * j + dj);
-                xj = x[j][dj];
-                for (i = j; i < natoms; i++)
+                for (d = 0; d < DIM; d++)
                 {
-                    l = k + DIM * i;
-                    for (d = 0; d < DIM; d++)
-                    {
-                        mat[l + d] += x[i][d] * xj;
-                    }
+                    xj = xread[index[i]][d] - (bRef ? xref[index[i]][d] : xav[i][d]);
+                    xb[DIM * i + d] = sqrtm[i] * xj;
+                    sumDeviation2 += gmx::square(xb[DIM * i + d]);
                 }
             }
+            nblock++;
+            if (nblock == c_framesPerBlock)
+            {
+                handleBlock(xblock.data(), nblock);
+                nblock = 0;
+            }
+        } while (read_next_x(oenv, status, &t, xread, box) && (bRef || nframes < nframes0));
+        if (nblock > 0)
+        {
+            handleBlock(xblock.data(), nblock);
         }
-    } while (read_next_x(oenv, status, &t, xread, box) && (bRef || nframes < nframes0));
-    close_trx(status);
-    gmx_rmpbc_done(gpbc);
-
-    fprintf(stderr, "Read %d frames\n", nframes);
+        close_trx(status);
+        sfree(xread);
+    };
 
     if (bRef)
     {
@@ -367,182 +408,221 @@ int gmx_covar(int argc, char* argv[])
         xproj = xav;
     }
 
-    /* correct the covariance matrix for the mass */
-    inv_nframes = 1.0 / nframes;
-    for (j = 0; j < natoms; j++)
-    {
-        for (dj = 0; dj < DIM; dj++)
-        {
-            for (i = j; i < natoms; i++)
-            {
-                k = ndim * (DIM * j + dj) + DIM * i;
-                for (d = 0; d < DIM; d++)
-                {
-                    mat[k + d] = mat[k + d] * inv_nframes * sqrtm[i] * sqrtm[j];
-                }
-            }
-        }
-    }
+    snew(eigenvalues, ndim);
 
-    /* symmetrize the matrix */
-    for (j = 0; j < ndim; j++)
+    if (nev == 0)
     {
-        for (i = j; i < ndim; i++)
-        {
-            mat[ndim * i + j] = mat[ndim * j + i];
-        }
-    }
+        fprintf(stderr, "Constructing covariance matrix (%dx%d) ...\n", static_cast<int>(ndim),
+                static_cast<int>(ndim));
+        snew(mat, ndim * ndim);
+        readDeviations([&](const real* xb, int nb) { symmetric_rank_k_update(mat, ndim, xb, nb); });
 
-    trace = 0;
-    for (i = 0; i < ndim; i++)
-    {
-        trace += mat[i * ndim + i];
-    }
-    fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace, bM ? "u " : "");
+        fprintf(stderr, "Read %d frames\n", nframes);
 
-    if (asciifile)
-    {
-        out = gmx_ffopen(asciifile, "w");
+        /* normalize the covariance matrix, the mass weighting is already applied */
+        inv_nframes = 1.0 / nframes;
         for (j = 0; j < ndim; j++)
         {
-            for (i = 0; i < ndim; i += 3)
+            for (i = j; i < ndim; i++)
             {
-                fprintf(out, "%g %g %g\n", mat[ndim * j + i], mat[ndim * j + i + 1],
-                        mat[ndim * j + i + 2]);
+                mat[ndim * j + i] *= inv_nframes;
             }
         }
-        gmx_ffclose(out);
-    }
 
-    if (xpmfile)
-    {
-        min = 0;
-        max = 0;
-        snew(mat2, ndim);
+        /* symmetrize the matrix */
         for (j = 0; j < ndim; j++)
         {
-            mat2[j] = &(mat[ndim * j]);
-            for (i = 0; i <= j; i++)
+            for (i = j; i < ndim; i++)
             {
-                if (mat2[j][i] < min)
-                {
-                    min = mat2[j][i];
-                }
-                if (mat2[j][j] > max)
-                {
-                    max = mat2[j][i];
-                }
+                mat[ndim * i + j] = mat[ndim * j + i];
             }
         }
-        snew(axis, ndim);
+
+        trace = 0;
         for (i = 0; i < ndim; i++)
         {
-            axis[i] = i + 1;
-        }
-        rlo.r   = 0;
-        rlo.g   = 0;
-        rlo.b   = 1;
-        rmi.r   = 1;
-        rmi.g   = 1;
-        rmi.b   = 1;
-        rhi.r   = 1;
-        rhi.g   = 0;
-        rhi.b   = 0;
-        out     = gmx_ffopen(xpmfile, "w");
-        nlevels = 80;
-        write_xpm3(out, 0, "Covariance", bM ? "u nm^2" : "nm^2", "dim", "dim", ndim, ndim, axis,
-                   axis, mat2, min, 0.0, max, rlo, rmi, rhi, &nlevels);
-        gmx_ffclose(out);
-        sfree(axis);
-        sfree(mat2);
-    }
-
-    if (xpmafile)
-    {
-        min = 0;
-        max = 0;
-        snew(mat2, ndim / DIM);
-        for (i = 0; i < ndim / DIM; i++)
-        {
-            snew(mat2[i], ndim / DIM);
+            trace += mat[i * ndim + i];
         }
-        for (j = 0; j < ndim / DIM; j++)
+        fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace, bM ? "u " : "");
+
+        if (asciifile)
         {
-            for (i = 0; i <= j; i++)
+            out = gmx_ffopen(asciifile, "w");
+            for (j = 0; j < ndim; j++)
             {
-                mat2[j][i] = 0;
-                for (d = 0; d < DIM; d++)
-                {
-                    mat2[j][i] += mat[ndim * (DIM * j + d) + DIM * i + d];
-                }
-                if (mat2[j][i] < min)
+                for (i = 0; i < ndim; i += 3)
                 {
-                    min = mat2[j][i];
+                    fprintf(out, "%g %g %g\n", mat[ndim * j + i], mat[ndim * j + i + 1],
+                            mat[ndim * j + i + 2]);
                 }
-                if (mat2[j][j] > max)
-                {
-                    max = mat2[j][i];
-                }
-                mat2[i][j] = mat2[j][i];
             }
+            gmx_ffclose(out);
         }
-        snew(axis, ndim / DIM);
-        for (i = 0; i < ndim / DIM; i++)
+
+        if (xpmfile)
         {
-            axis[i] = i + 1;
+            min = 0;
+            max = 0;
+            snew(mat2, ndim);
+            for (j = 0; j < ndim; j++)
+            {
+                mat2[j] = &(mat[ndim * j]);
+                for (i = 0; i <= j; i++)
+                {
+                    if (mat2[j][i] < min)
+                    {
+                        min = mat2[j][i];
+                    }
+                    if (mat2[j][j] > max)
+                    {
+                        max = mat2[j][i];
+                    }
+                }
+            }
+            snew(axis, ndim);
+            for (i = 0; i < ndim; i++)
+            {
+                axis[i] = i + 1;
+            }
+            rlo.r   = 0;
+            rlo.g   = 0;
+            rlo.b   = 1;
+            rmi.r   = 1;
+            rmi.g   = 1;
+            rmi.b   = 1;
+            rhi.r   = 1;
+            rhi.g   = 0;
+            rhi.b   = 0;
+            out     = gmx_ffopen(xpmfile, "w");
+            nlevels = 80;
+            write_xpm3(out, 0, "Covariance", bM ? "u nm^2" : "nm^2", "dim", "dim", ndim, ndim, axis,
+                       axis, mat2, min, 0.0, max, rlo, rmi, rhi, &nlevels);
+            gmx_ffclose(out);
+            sfree(axis);
+            sfree(mat2);
         }
-        rlo.r   = 0;
-        rlo.g   = 0;
-        rlo.b   = 1;
-        rmi.r   = 1;
-        rmi.g   = 1;
-        rmi.b   = 1;
-        rhi.r   = 1;
-        rhi.g   = 0;
-        rhi.b   = 0;
-        out     = gmx_ffopen(xpmafile, "w");
-        nlevels = 80;
-        write_xpm3(out, 0, "Covariance", bM ? "u nm^2" : "nm^2", "atom", "atom", ndim / DIM,
-                   ndim / DIM, axis, axis, mat2, min, 0.0, max, rlo, rmi, rhi, &nlevels);
-        gmx_ffclose(out);
-        sfree(axis);
-        for (i = 0; i < ndim / DIM; i++)
+
+        if (xpmafile)
         {
-            sfree(mat2[i]);
+            min = 0;
+            max = 0;
+            snew(mat2, ndim / DIM);
+            for (i = 0; i < ndim / DIM; i++)
+            {
+                snew(mat2[i], ndim / DIM);
+            }
+            for (j = 0; j < ndim / DIM; j++)
+            {
+                for (i = 0; i <= j; i++)
+                {
+                    mat2[j][i] = 0;
+                    for (d = 0; d < DIM; d++)
+                    {
+                        mat2[j][i] += mat[ndim * (DIM * j + d) + DIM * i + d];
+                    }
+                    if (mat2[j][i] < min)
+                    {
+                        min = mat2[j][i];
+                    }
+                    if (mat2[j][j] > max)
+                    {
+                        max = mat2[j][i];
+                    }
+                    mat2[i][j] = mat2[j][i];
+                }
+            }
+            snew(axis, ndim / DIM);
+            for (i = 0; i < ndim / DIM; i++)
+            {
+                axis[i] = i + 1;
+            }
+            rlo.r   = 0;
+            rlo.g   = 0;
+            rlo.b   = 1;
+            rmi.r   = 1;
+            rmi.g   = 1;
+            rmi.b   = 1;
+            rhi.r   = 1;
+            rhi.g   = 0;
+            rhi.b   = 0;
+            out     = gmx_ffopen(xpmafile, "w");
+            nlevels = 80;
+            write_xpm3(out, 0, "Covariance", bM ? "u nm^2" : "nm^2", "atom", "atom", ndim / DIM,
+                       ndim / DIM, axis, axis, mat2, min, 0.0, max, rlo, rmi, rhi, &nlevels);
+            gmx_ffclose(out);
+            sfree(axis);
+            for (i = 0; i < ndim / DIM; i++)
+            {
+                sfree(mat2[i]);
+            }
+            sfree(mat2);
         }
-        sfree(mat2);
-    }
 
+        /* call diagonalization routine */
 
-    /* call diagonalization routine */
+        snew(eigenvectors, ndim * ndim);
 
-    snew(eigenvalues, ndim);
-    snew(eigenvectors, ndim * ndim);
+        std::memcpy(eigenvectors, mat, ndim * ndim * sizeof(real));
+        fprintf(stderr, "\nDiagonalizing ...\n");
+        fflush(stderr);
+        eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
+        sfree(eigenvectors);
+    }
+    else
+    {
+        /* Each application of the covariance matrix reads the trajectory */
+        auto applyCovariance = [&](const real* q, int l, real* y) {
+            readDeviations([&](const real* xb, int nb) {
+                symmetric_rank_k_apply(ndim, xb, nb, q, l, y);
+            });
+            inv_nframes = 1.0 / nframes;
+            for (i = 0; i < l * ndim; i++)
+            {
+                y[i] *= inv_nframes;
+            }
+        };
+
+        fprintf(stderr,
+                "\nDetermining the %d largest eigenvalues of the covariance matrix (%dx%d)\n"
+                "with a randomized eigensolver, reading the trajectory %d times ...\n",
+                nev, static_cast<int>(ndim), static_cast<int>(ndim), npower + 2);
+        snew(mat, nev * ndim);
+        randomized_eigensolver(ndim, nev, c_numOversample, npower, c_randomSeed, applyCovariance,
+                               eigenvalues, mat);
 
-    std::memcpy(eigenvectors, mat, ndim * ndim * sizeof(real));
-    fprintf(stderr, "\nDiagonalizing ...\n");
-    fflush(stderr);
-    eigensolver(eigenvectors, ndim, 0, ndim, eigenvalues, mat);
-    sfree(eigenvectors);
+        fprintf(stderr, "Read %d frames\n", nframes);
+
+        trace = sumDeviation2 / nframes;
+        fprintf(stderr, "\nTrace of the covariance matrix: %g (%snm^2)\n", trace, bM ? "u " : "");
+    }
+    gmx_rmpbc_done(gpbc);
 
     /* now write the output */
 
     sum = 0;
-    for (i = 0; i < ndim; i++)
+    for (i = 0; i < neig; i++)
     {
         sum += eigenvalues[i];
     }
-    fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
-    if (std::abs(trace - sum) > 0.01 * trace)
+    if (nev == 0)
     {
-        fprintf(stderr,
-                "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
+        fprintf(stderr, "\nSum of the eigenvalues: %g (%snm^2)\n", sum, bM ? "u " : "");
+        if (std::abs(trace - sum) > 0.01 * trace)
+        {
+            fprintf(stderr,
+                    "\nWARNING: eigenvalue sum deviates from the trace of the covariance matrix\n");
+        }
+    }
+    else
+    {
+        fprintf(stderr, "\nSum of the %d largest eigenvalues: %g (%snm^2), %.1f%% of the trace\n",
+                nev, sum, bM ? "u " : "", 100 * sum / trace);
     }
 
     /* Set 'end', the maximum eigenvector and -value index used for output */
-    if (end == -1)
+    if (end == -1 || end > neig)
     {
-        if (nframes - 1 < ndim)
+        if (nframes - 1 < neig)
         {
             end = nframes - 1;
             fprintf(stderr,
@@ -552,7 +632,7 @@ int gmx_covar(int argc, char* argv[])
         }
         else
         {
-            end = ndim;
+            end = neig;
         }
     }
 
@@ -562,7 +642,8 @@ int gmx_covar(int argc, char* argv[])
     out = xvgropen(eigvalfile, "Eigenvalues of the covariance matrix", "Eigenvector index", str, oenv);
     for (i = 0; (i < end); i++)
     {
-        fprintf(out, "%10d %g\n", static_cast<int>(i + 1), eigenvalues[ndim - 1 - i]);
+        /* The full diagonalization returns the eigenvalues in ascending order */
+        fprintf(out, "%10d %g\n", static_cast<int>(i + 1), eigenvalues[nev > 0 ? i : ndim - 1 - i]);
     }
     xvgrclose(out);
 
@@ -588,8 +669,8 @@ int gmx_covar(int argc, char* argv[])
         WriteXref = eWXR_NOFIT;
     }
 
-    write_eigenvectors(eigvecfile, natoms, mat, TRUE, 1, end, WriteXref, x, bDiffMass1, xproj, bM,
-                       eigenvalues);
+    write_eigenvectors(eigvecfile, natoms, mat, nev == 0, 1, end, WriteXref, x, bDiffMass1, xproj,
+                       bM, eigenvalues);
 
     out = gmx_ffopen(logfile, "w");
 
@@ -627,10 +708,22 @@ int gmx_covar(int argc, char* argv[])
     {
         fprintf(out, "Fit is %smass weighted\n", bDiffMass1 ? "" : "non-");
     }
-    fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim),
-            static_cast<int>(ndim));
-    fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n", trace);
-    fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    if (nev == 0)
+    {
+        fprintf(out, "Diagonalized the %dx%d covariance matrix\n", static_cast<int>(ndim),
+                static_cast<int>(ndim));
+        fprintf(out, "Trace of the covariance matrix before diagonalizing: %g\n", trace);
+        fprintf(out, "Trace of the covariance matrix after diagonalizing: %g\n\n", sum);
+    }
+    else
+    {
+        fprintf(out,
+                "Determined the %d largest eigenvalues of the %dx%d covariance matrix\n"
+                "with a randomized eigensolver using %d power iterations\n",
+                nev, static_cast<int>(ndim), static_cast<int>(ndim), npower);
+        fprintf(out, "Trace of the covariance matrix: %g\n", trace);
+        fprintf(out, "Sum of the %d largest eigenvalues: %g\n\n", nev, sum);
+    }
 
     fprintf(out, "Wrote %d eigenvalues to %s\n", static_cast<int>(end), eigvalfile);
     if (WriteXref == eWXR_YES)
@@ -42,10 +42,13 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/gmxana/gstat.h"
 #include "gromacs/math/units.h"
@@ -219,12 +222,39 @@ static void calc_electron_density(const char*             fn,
         fprintf(stderr, "\nDividing the box in %d slices\n", *nslices);
     }
 
-    snew(*slDensity, nr_grps);
-    for (i = 0; i < nr_grps; i++)
+    /* Look up the number of electrons of each atom once */
+    std::vector<std::vector<real>> electrons(nr_grps);
+    for (n = 0; n < nr_grps; n++)
     {
-        snew((*slDensity)[i], *nslices);
+        electrons[n].resize(gnx[n]);
+        for (i = 0; i < gnx[n]; i++)
+        {
+            sought.nr_el    = 0;
+            sought.atomname = gmx_strdup(*(top->atoms.atomname[index[n][i]]));
+
+            found = static_cast<t_electron*>(
+                    bsearch(&sought, eltab, nr, sizeof(t_electron),
+                            reinterpret_cast<int (*)(const void*, const void*)>(compare)));
+
+            if (found == nullptr)
+            {
+                fprintf(stderr, "Couldn't find %s. Add it to the .dat file\n",
+                        *(top->atoms.atomname[index[n][i]]));
+                electrons[n][i] = 0;
+            }
+            else
+            {
+                electrons[n][i] = found->nr_el - top->atoms.atom[index[n][i]].q;
+            }
+            free(sought.atomname);
+        }
     }
 
+    /* Grid with the slices along the first and the groups along the second dimension */
+    gmx::DensityGrid       densityGrid({ *nslices, nr_grps, 1 }, 0);
+    std::vector<gmx::RVec> latticeX;
+    std::vector<real>      weights;
+
     gpbc = gmx_rmpbc_init(&top->idef, pbcType, top->atoms.nr);
     /*********** Start processing trajectory ***********/
     do
@@ -282,26 +312,13 @@ static void calc_electron_density(const char*             fn,
                 {
                     slice = static_cast<int>(z / (*slWidth));
                 }
-                sought.nr_el    = 0;
-                sought.atomname = gmx_strdup(*(top->atoms.atomname[index[n][i]]));
-
-                /* now find the number of electrons. This is not efficient. */
-                found = static_cast<t_electron*>(
-                        bsearch(&sought, eltab, nr, sizeof(t_electron),
-                                reinterpret_cast<int (*)(const void*, const void*)>(compare)));
-
-                if (found == nullptr)
-                {
-                    fprintf(stderr, "Couldn't find %s. Add it to the .dat file\n",
-                            *(top->atoms.atomname[index[n][i]]));
-                }
-                else
-                {
-                    (*slDensity)[n][slice] += (found->nr_el - top->atoms.atom[index[n][i]].q) * invvol;
-                }
-                free(sought.atomname);
+                latticeX.emplace_back(slice, n, 0);
+                weights.push_back(electrons[n][i] * invvol);
             }
         }
+        densityGrid.add(latticeX, weights);
+        latticeX.clear();
+        weights.clear();
         nr_frames++;
     } while (read_next_x(oenv, status, &t, x0, box));
     gmx_rmpbc_done(gpbc);
@@ -321,11 +338,14 @@ static void calc_electron_density(const char*             fn,
         *slWidth = aveBox / (*nslices);
     }
 
+    const std::vector<double> gridSum = densityGrid.sum();
+    snew(*slDensity, nr_grps);
     for (n = 0; n < nr_grps; n++)
     {
+        snew((*slDensity)[n], *nslices);
         for (i = 0; i < *nslices; i++)
         {
-            (*slDensity)[n][i] /= nr_frames;
+            (*slDensity)[n][i] = gridSum[n * (*nslices) + i] / nr_frames;
         }
     }
 
@@ -380,11 +400,10 @@ static void calc_density(const char*             fn,
         fprintf(stderr, "\nDividing the box in %d slices\n", *nslices);
     }
 
-    snew(*slDensity, nr_grps);
-    for (i = 0; i < nr_grps; i++)
-    {
-        snew((*slDensity)[i], *nslices);
-    }
+    /* Grid with the slices along the first and the groups along the second dimension */
+    gmx::DensityGrid       densityGrid({ *nslices, nr_grps, 1 }, 0);
+    std::vector<gmx::RVec> latticeX;
+    std::vector<real>      weights;
 
     gpbc = gmx_rmpbc_init(&top->idef, pbcType, top->atoms.nr);
     /*********** Start processing trajectory ***********/
@@ -481,9 +500,13 @@ static void calc_density(const char*             fn,
                     slice -= *nslices;
                 }
 
-                (*slDensity)[n][slice] += den_val[index[n][i]] * invvol;
+                latticeX.emplace_back(slice, n, 0);
+                weights.push_back(den_val[index[n][i]] * invvol);
             }
         }
+        densityGrid.add(latticeX, weights);
+        latticeX.clear();
+        weights.clear();
         nr_frames++;
     } while (read_next_x(oenv, status, &t, x0, box));
     gmx_rmpbc_done(gpbc);
@@ -503,11 +526,14 @@ static void calc_density(const char*             fn,
         *slWidth = aveBox / (*nslices);
     }
 
+    const std::vector<double> gridSum = densityGrid.sum();
+    snew(*slDensity, nr_grps);
     for (n = 0; n < nr_grps; n++)
     {
+        snew((*slDensity)[n], *nslices);
         for (i = 0; i < *nslices; i++)
         {
-            (*slDensity)[n][i] /= nr_frames;
+            (*slDensity)[n][i] = gridSum[n * (*nslices) + i] / nr_frames;
         }
     }
 
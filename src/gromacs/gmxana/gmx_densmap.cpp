@@ -40,11 +40,14 @@
 #include <cmath>
 #include <cstring>
 
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/commandline/viewit.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/matio.h"
 #include "gromacs/fileio/trxio.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/gmxana/gstat.h"
 #include "gromacs/math/utilities.h"
@@ -263,11 +266,9 @@ int gmx_densmap(int argc, char* argv[])
         }
     }
 
-    snew(grid, n1);
-    for (i = 0; i < n1; i++)
-    {
-        snew(grid[i], n2);
-    }
+    /* Grid in lattice coordinates with the first and second grid dimension along x and y */
+    gmx::DensityGrid       densityGrid({ n1, n2, 1 }, 0);
+    std::vector<gmx::RVec> latticeX;
 
     box1 = 0;
     box2 = 0;
@@ -310,9 +311,11 @@ int gmx_densmap(int argc, char* argv[])
                     {
                         m2 += 1;
                     }
-                    grid[static_cast<int>(m1 * n1)][static_cast<int>(m2 * n2)] += invcellvol;
+                    latticeX.emplace_back(m1 * n1, m2 * n2, 0);
                 }
             }
+            densityGrid.add(latticeX, invcellvol);
+            latticeX.clear();
         }
         else
         {
@@ -360,14 +363,27 @@ int gmx_densmap(int argc, char* argv[])
                     {
                         r += rmax;
                     }
-                    grid[static_cast<int>((axial + amax) * invspa)][static_cast<int>(r * invspz)] += 1;
+                    latticeX.emplace_back((axial + amax) * invspa, r * invspz, 0);
                 }
             }
+            densityGrid.add(latticeX, 1);
+            latticeX.clear();
         }
         nfr++;
     } while (read_next_x(oenv, status, &t, x, box));
     close_trx(status);
 
+    const std::vector<double> gridSum = densityGrid.sum();
+    snew(grid, n1);
+    for (i = 0; i < n1; i++)
+    {
+        snew(grid[i], n2);
+        for (j = 0; j < n2; j++)
+        {
+            grid[i][j] = gridSum[j * n1 + i];
+        }
+    }
+
     /* normalize gridpoints */
     maxgrid = 0;
     if (!bRadial)
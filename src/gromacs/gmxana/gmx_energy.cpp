@@ -48,6 +48,7 @@
 #include "gromacs/correlationfunctions/autocorr.h"
 #include "gromacs/fileio/enxio.h"
 #include "gromacs/fileio/gmxfio.h"
+#include "gromacs/fileio/timecontrol.h"
 #include "gromacs/fileio/tpxio.h"
 #include "gromacs/fileio/trxio.h"
 #include "gromacs/fileio/xvgr.h"
@@ -1894,6 +1895,24 @@ int gmx_energy(int argc, char* argv[])
     edat.bHaveSums = TRUE;
     snew(edat.s, nset);
 
+    if (!bDHDL)
+    {
+        /* We only need the selected terms, so skip all other data in the file */
+        enx_select_terms(fp, nset, set, FALSE);
+    }
+    if (bTimeSet(TBEGIN))
+    {
+        /* Seek to just before the begin time, check_times() below
+         * takes care of the exact (precision dependent) comparison.
+         */
+        std::vector<t_enxindexentry> frameIndex = enx_build_frame_index(fp);
+        if (!frameIndex.empty())
+        {
+            int frame = enx_find_frame_time(frameIndex, rTimeValue(TBEGIN));
+            enx_seek_frame(fp, frameIndex, std::max(frame - 1, 0));
+        }
+    }
+
     /* Initiate counters */
     bFoundStart = FALSE;
     start_step  = 0;
@@ -39,9 +39,14 @@
 #include <cmath>
 #include <cstdlib>
 
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
 #include "gromacs/fileio/trxio.h"
+#include "gromacs/gmxana/densitygrid.h"
 #include "gromacs/gmxana/gmx_ana.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -51,6 +56,7 @@
 #include "gromacs/trajectory/trajectoryframe.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/smalloc.h"
 
@@ -84,6 +90,12 @@ int gmx_spatial(int argc, char* argv[])
         "4. run [THISMODULE] on the [TT]c.tng[tt] output of step #3.",
         "5. Load [TT]grid.cube[tt] into VMD and view as an isosurface.",
         "",
+        "The bins of all frames are accumulated using multiple threads. With [TT]-sigma[tt]",
+        "each position is spread over the neighboring bins with a Gaussian, which gives",
+        "smoother maps for short trajectories. With [TT]-mrc[tt] the whole grid is",
+        "also written as an MRC density map, which can be read by most molecular",
+        "visualization programs.",
+        "",
         "[BB]Note[bb] that systems such as micelles will require [TT]gmx trjconv -pbc cluster[tt] ",
         "between steps 1 and 2.",
         "",
@@ -127,6 +139,7 @@ int gmx_spatial(int argc, char* argv[])
     static real     rBINWIDTH    = 0.05; /* nm */
     static gmx_bool bCALCDIV     = TRUE;
     static int      iNAB         = 4;
+    static real     rSIGMA       = 0; /* nm */
 
     t_pargs pa[] = { { "-pbc",
                        FALSE,
@@ -149,6 +162,12 @@ int gmx_spatial(int argc, char* argv[])
                      /*    { "-cut",      bCUTDOWN, etBOOL, {&bCUTDOWN},*/
                      /*      "Display a total cube that is of minimal size" }, */
                      { "-bin", FALSE, etREAL, { &rBINWIDTH }, "Width of the bins (nm)" },
+                     { "-sigma",
+                       FALSE,
+                       etREAL,
+                       { &rSIGMA },
+                       "Width of the Gaussian used for spreading positions over bins (nm), 0 "
+                       "counts each position in the bin that contains it" },
                      { "-nab",
                        FALSE,
                        etINT,
@@ -172,19 +191,20 @@ int gmx_spatial(int argc, char* argv[])
     int               i, nidx, nidxp;
     int               v;
     int               j, k;
-    int***            bin = nullptr;
     int               nbin[3];
     FILE*             flp;
-    int               x, y, z, minx, miny, minz, maxx, maxy, maxz;
+    const char*       mrcfile;
+    int               minx, miny, minz, maxx, maxy, maxz;
     int               numfr, numcu;
-    int               tot, maxval, minval;
+    double            tot, maxval, minval;
     double            norm;
     gmx_output_env_t* oenv;
     gmx_rmpbc_t       gpbc = nullptr;
 
     t_filenm fnm[] = { { efTPS, nullptr, nullptr, ffREAD }, /* this is for the topology */
                        { efTRX, "-f", nullptr, ffREAD },    /* and this for the trajectory */
-                       { efNDX, nullptr, nullptr, ffOPTRD } };
+                       { efNDX, nullptr, nullptr, ffOPTRD },
+                       { efMRC, "-mrc", "grid", ffOPTWR } };
 
 #define NFILE asize(fnm)
 
@@ -196,6 +216,12 @@ int gmx_spatial(int argc, char* argv[])
         return 0;
     }
 
+    if (rSIGMA < 0)
+    {
+        gmx_fatal(FARGS, "-sigma should be >= 0");
+    }
+    mrcfile = opt2fn_null("-mrc", NFILE, fnm);
+
     read_tps_conf(ftp2fn(efTPS, NFILE, fnm), &top, &pbcType, &xtop, nullptr, box, TRUE);
     sfree(xtop);
 
@@ -246,19 +272,10 @@ int gmx_spatial(int argc, char* argv[])
         MINBIN[i] -= iNAB * rBINWIDTH;
         nbin[i] = static_cast<int>(std::ceil((MAXBIN[i] - MINBIN[i]) / rBINWIDTH));
     }
-    snew(bin, nbin[XX]);
-    for (i = 0; i < nbin[XX]; ++i)
-    {
-        snew(bin[i], nbin[YY]);
-        for (j = 0; j < nbin[YY]; ++j)
-        {
-            snew(bin[i][j], nbin[ZZ]);
-        }
-    }
+    gmx::DensityGrid grid({ nbin[XX], nbin[YY], nbin[ZZ] }, rSIGMA / rBINWIDTH);
+    std::vector<gmx::RVec> latticeX(nidx);
     copy_mat(box, box_pbc);
     numfr = 0;
-    minx = miny = minz = 999;
-    maxx = maxy = maxz = 0;
 
     if (bPBC)
     {
@@ -290,35 +307,12 @@ int gmx_spatial(int argc, char* argv[])
                        fr.x[index[i]][YY], fr.x[index[i]][ZZ]);
                 exit(1);
             }
-            x = static_cast<int>(std::ceil((fr.x[index[i]][XX] - MINBIN[XX]) / rBINWIDTH));
-            y = static_cast<int>(std::ceil((fr.x[index[i]][YY] - MINBIN[YY]) / rBINWIDTH));
-            z = static_cast<int>(std::ceil((fr.x[index[i]][ZZ] - MINBIN[ZZ]) / rBINWIDTH));
-            ++bin[x][y][z];
-            if (x < minx)
-            {
-                minx = x;
-            }
-            if (x > maxx)
-            {
-                maxx = x;
-            }
-            if (y < miny)
-            {
-                miny = y;
-            }
-            if (y > maxy)
-            {
-                maxy = y;
-            }
-            if (z < minz)
-            {
-                minz = z;
-            }
-            if (z > maxz)
+            for (k = 0; k < DIM; k++)
             {
-                maxz = z;
+                latticeX[i][k] = (fr.x[index[i]][k] - MINBIN[k]) / rBINWIDTH;
             }
         }
+        grid.add(latticeX, 1.0);
         numfr++;
         /* printf("%f\t%f\t%f\n",box[XX][XX],box[YY][YY],box[ZZ][ZZ]); */
 
@@ -329,6 +323,30 @@ int gmx_spatial(int argc, char* argv[])
         gmx_rmpbc_done(gpbc);
     }
 
+    const std::vector<double> bin = grid.sum();
+
+    /* Determine the range of bins with non-zero occupancy */
+    minx = miny = minz = 999;
+    maxx = maxy = maxz = 0;
+    for (k = 0; k < nbin[XX]; k++)
+    {
+        for (j = 0; j < nbin[YY]; j++)
+        {
+            for (i = 0; i < nbin[ZZ]; i++)
+            {
+                if (bin[(i * nbin[YY] + j) * nbin[XX] + k] != 0)
+                {
+                    minx = std::min(minx, k);
+                    maxx = std::max(maxx, k);
+                    miny = std::min(miny, j);
+                    maxy = std::max(maxy, j);
+                    minz = std::min(minz, i);
+                    maxz = std::max(maxz, i);
+                }
+            }
+        }
+    }
+
     if (!bCUTDOWN)
     {
         minx = miny = minz = 0;
@@ -378,37 +396,8 @@ int gmx_spatial(int argc, char* argv[])
                 fr.x[indexp[i]][YY] * 10.0 / bohr, fr.x[indexp[i]][ZZ] * 10.0 / bohr);
     }
 
-    tot = 0;
-    for (k = 0; k < nbin[XX]; k++)
-    {
-        if (!(k < minx || k > maxx))
-        {
-            continue;
-        }
-        for (j = 0; j < nbin[YY]; j++)
-        {
-            if (!(j < miny || j > maxy))
-            {
-                continue;
-            }
-            for (i = 0; i < nbin[ZZ]; i++)
-            {
-                if (!(i < minz || i > maxz))
-                {
-                    continue;
-                }
-                if (bin[k][j][i] != 0)
-                {
-                    printf("A bin was not empty when it should have been empty. Programming "
-                           "error.\n");
-                    printf("bin[%d][%d][%d] was = %d\n", k, j, i, bin[k][j][i]);
-                    exit(1);
-                }
-            }
-        }
-    }
-
-    minval = 999;
+    tot    = 0;
+    minval = std::numeric_limits<double>::max();
     maxval = 0;
     for (k = 0; k < nbin[XX]; k++)
     {
@@ -428,15 +417,10 @@ int gmx_spatial(int argc, char* argv[])
                 {
                     continue;
                 }
-                tot += bin[k][j][i];
-                if (bin[k][j][i] > maxval)
-                {
-                    maxval = bin[k][j][i];
-                }
-                if (bin[k][j][i] < minval)
-                {
-                    minval = bin[k][j][i];
-                }
+                const double value = bin[(i * nbin[YY] + j) * nbin[XX] + k];
+                tot += value;
+                maxval = std::max(maxval, value);
+                minval = std::min(minval, value);
             }
         }
     }
@@ -445,7 +429,7 @@ int gmx_spatial(int argc, char* argv[])
             * (maxz - minz + 1 - (2 * iIGNOREOUTER));
     if (bCALCDIV)
     {
-        norm = static_cast<double>(numcu * numfr) / tot;
+        norm = static_cast<double>(numcu) * numfr / tot;
     }
     else
     {
@@ -470,7 +454,7 @@ int gmx_spatial(int argc, char* argv[])
                 {
                     continue;
                 }
-                fprintf(flp, "%12.6f ", static_cast<double>(norm * bin[k][j][i]) / numfr);
+                fprintf(flp, "%12.6f ", norm * bin[(i * nbin[YY] + j) * nbin[XX] + k] / numfr);
             }
             fprintf(flp, "\n");
         }
@@ -478,6 +462,19 @@ int gmx_spatial(int argc, char* argv[])
     }
     gmx_ffclose(flp);
 
+    if (mrcfile)
+    {
+        /* Write the whole grid, not only the range of non-zero bins */
+        std::vector<double> density(bin.size());
+        for (size_t b = 0; b < bin.size(); b++)
+        {
+            density[b] = norm * bin[b] / numfr;
+        }
+        const gmx::RVec origin = { static_cast<real>(MINBIN[XX]), static_cast<real>(MINBIN[YY]),
+                                   static_cast<real>(MINBIN[ZZ]) };
+        gmx::writeDensityGridAsMrc(mrcfile, grid.numBins(), density, origin, rBINWIDTH);
+    }
+
     if (bCALCDIV)
     {
         printf("Counts per frame in all %d cubes divided by %le\n", numcu, 1.0 / norm);
@@ -487,8 +484,8 @@ int gmx_spatial(int argc, char* argv[])
     else
     {
         printf("grid.cube contains counts per frame in all %d cubes\n", numcu);
-        printf("Raw data: average %le, min %le, max %le\n", 1.0 / norm,
-               static_cast<double>(minval) / numfr, static_cast<double>(maxval) / numfr);
+        printf("Raw data: average %le, min %le, max %le\n", 1.0 / norm, minval / numfr,
+               maxval / numfr);
     }
 
     return 0;
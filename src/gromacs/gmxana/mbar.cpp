@@ -0,0 +1,313 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements the MBAR free energy estimator used by gmx bar.
+ *
+ * \ingroup module_gmxana
+ */
+#include "gmxpre.h"
+
+#include "mbar.h"
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <limits>
+
+#include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
+
+int mbar_num_threads(int64_t n)
+{
+    /* Below this number of samples per thread the OpenMP overhead dominates */
+    const int64_t c_minSamplesPerThread = 1000;
+
+    return static_cast<int>(std::max<int64_t>(
+            1, std::min<int64_t>(gmx_omp_get_max_threads(), n / c_minSamplesPerThread)));
+}
+
+void mbar_data_create_subsample(mbar_data_t* md, const mbar_data_t* md_orig, int p, int npee)
+{
+    md->nstate = md_orig->nstate;
+    md->n.assign(md->nstate, 0);
+    md->offset.assign(md->nstate + 1, 0);
+    for (int i = 0; i < md->nstate; i++)
+    {
+        md->n[i]          = (md_orig->n[i] * (p + 1)) / npee - (md_orig->n[i] * p) / npee;
+        md->offset[i + 1] = md->offset[i] + md->n[i];
+    }
+    md->ntot = md->offset[md->nstate];
+
+    md->u.resize(md->nstate * md->ntot);
+    for (int k = 0; k < md->nstate; k++)
+    {
+        for (int i = 0; i < md->nstate; i++)
+        {
+            const double* src = md_orig->u.data() + k * md_orig->ntot + md_orig->offset[i]
+                                + (md_orig->n[i] * p) / npee;
+            std::copy(src, src + md->n[i], md->u.begin() + k * md->ntot + md->offset[i]);
+        }
+    }
+}
+
+/* Return log(sum_n exp(x_n)) for x_n in [x, x+n) without overflow */
+static double log_sum_exp(const double* x, int64_t n)
+{
+    double xmax = -std::numeric_limits<double>::infinity();
+    double sum  = 0;
+
+    for (int64_t i = 0; i < n; i++)
+    {
+        xmax = std::max(xmax, x[i]);
+    }
+    for (int64_t i = 0; i < n; i++)
+    {
+        sum += std::exp(x[i] - xmax);
+    }
+    return xmax + std::log(sum);
+}
+
+int mbar_solve(const mbar_data_t* md, double tol, int maxiter, std::vector<double>* f)
+{
+    const int     nstate   = md->nstate;
+    const int64_t ntot     = md->ntot;
+    const int     nthreads = mbar_num_threads(ntot);
+
+    std::vector<double> logN(nstate);
+    std::vector<double> logDenom(ntot);
+    std::vector<double> work(ntot);
+    /* per thread partial log-sum-exp's for the new free energies */
+    std::vector<double> partialMax(nthreads * nstate);
+    std::vector<double> partialSum(nthreads * nstate);
+    std::vector<double> fnew(nstate);
+
+    for (int k = 0; k < nstate; k++)
+    {
+        logN[k] = std::log(static_cast<double>(std::max<int64_t>(md->n[k], 1)));
+    }
+
+    /* Initial guess by exponential averaging between neighboring states */
+    f->assign(nstate, 0.);
+    for (int k = 1; k < nstate; k++)
+    {
+        const double* u = md->u.data() + k * md->ntot + md->offset[k - 1];
+        for (int64_t n = 0; n < md->n[k - 1]; n++)
+        {
+            work[n] = -u[n];
+        }
+        (*f)[k] = (*f)[k - 1];
+        if (md->n[k - 1] > 0)
+        {
+            (*f)[k] -= log_sum_exp(work.data(), md->n[k - 1]) - logN[k - 1];
+        }
+    }
+
+    for (int iter = 1; iter <= maxiter; iter++)
+    {
+        double fdiff = 0;
+
+#pragma omp parallel num_threads(nthreads)
+        {
+            try
+            {
+                const int     thread_id = gmx_omp_get_thread_num();
+                const int64_t n0        = (thread_id * ntot) / nthreads;
+                const int64_t n1        = ((thread_id + 1) * ntot) / nthreads;
+                double*       dmax      = work.data();
+                double*       ldenom    = logDenom.data();
+
+                /* The denominator log(sum_k N_k exp(f_k - u_k(x_n))) per sample,
+                   with the loop over samples innermost for vectorization */
+                for (int64_t n = n0; n < n1; n++)
+                {
+                    dmax[n]   = -std::numeric_limits<double>::infinity();
+                    ldenom[n] = 0;
+                }
+                for (int k = 0; k < nstate; k++)
+                {
+                    const double  c = logN[k] + (*f)[k];
+                    const double* u = md->u.data() + k * ntot;
+                    if (md->n[k] == 0)
+                    {
+                        continue;
+                    }
+                    for (int64_t n = n0; n < n1; n++)
+                    {
+                        dmax[n] = std::max(dmax[n], c - u[n]);
+                    }
+                }
+                for (int k = 0; k < nstate; k++)
+                {
+                    const double  c = logN[k] + (*f)[k];
+                    const double* u = md->u.data() + k * ntot;
+                    if (md->n[k] == 0)
+                    {
+                        continue;
+                    }
+                    for (int64_t n = n0; n < n1; n++)
+                    {
+                        ldenom[n] += std::exp(c - u[n] - dmax[n]);
+                    }
+                }
+                for (int64_t n = n0; n < n1; n++)
+                {
+                    ldenom[n] = dmax[n] + std::log(ldenom[n]);
+                }
+
+                /* The partial sums over our samples of exp(-u_i(x_n)) / denominator */
+                for (int i = 0; i < nstate; i++)
+                {
+                    const double* u    = md->u.data() + i * ntot;
+                    double        xmax = -std::numeric_limits<double>::infinity();
+                    double        sum  = 0;
+                    for (int64_t n = n0; n < n1; n++)
+                    {
+                        xmax = std::max(xmax, -u[n] - ldenom[n]);
+                    }
+                    for (int64_t n = n0; n < n1; n++)
+                    {
+                        sum += std::exp(-u[n] - ldenom[n] - xmax);
+                    }
+                    partialMax[thread_id * nstate + i] = xmax;
+                    partialSum[thread_id * nstate + i] = sum;
+                }
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+
+        /* Reduce the thread contributions */
+        for (int i = 0; i < nstate; i++)
+        {
+            double xmax = -std::numeric_limits<double>::infinity();
+            double sum  = 0;
+            for (int t = 0; t < nthreads; t++)
+            {
+                xmax = std::max(xmax, partialMax[t * nstate + i]);
+            }
+            for (int t = 0; t < nthreads; t++)
+            {
+                if (partialSum[t * nstate + i] > 0)
+                {
+                    sum += partialSum[t * nstate + i] * std::exp(partialMax[t * nstate + i] - xmax);
+                }
+            }
+            fnew[i] = -(xmax + std::log(sum));
+        }
+        for (int i = nstate - 1; i >= 0; i--)
+        {
+            fnew[i] -= fnew[0];
+            fdiff = std::max(fdiff, std::abs(fnew[i] - (*f)[i]));
+        }
+        f->swap(fnew);
+
+        if (debug)
+        {
+            fprintf(debug, "MBAR iteration %d, max. change in f %g\n", iter, fdiff);
+        }
+        if (fdiff < tol)
+        {
+            return iter;
+        }
+    }
+
+    return -1;
+}
+
+gmx_bool calc_mbar(const mbar_data_t*   md,
+                   double               tol,
+                   int                  npee_min,
+                   int                  npee_max,
+                   std::vector<double>* f,
+                   std::vector<double>* dg_err,
+                   double*              dg_tot_err)
+{
+    /* The MBAR self-consistent iteration converges linearly */
+    const int   c_maxIterations = 100000;
+    const int   nstate          = md->nstate;
+    gmx_bool    converged;
+    mbar_data_t md_block;
+
+    converged = (mbar_solve(md, tol, c_maxIterations, f) >= 0);
+
+    dg_err->assign(nstate - 1, 0.);
+    *dg_tot_err = 0;
+
+    std::vector<double> sig2(nstate - 1, 0.);
+    std::vector<double> fp;
+    double              tot_sig2 = 0;
+    for (int npee = npee_min; npee <= npee_max; npee++)
+    {
+        std::vector<double> dgs(nstate - 1, 0.);
+        std::vector<double> dgs2(nstate - 1, 0.);
+        double              tots  = 0;
+        double              tots2 = 0;
+
+        for (int p = 0; p < npee; p++)
+        {
+            mbar_data_create_subsample(&md_block, md, p, npee);
+            if (mbar_solve(&md_block, tol, c_maxIterations, &fp) < 0)
+            {
+                converged = FALSE;
+            }
+            for (int i = 0; i < nstate - 1; i++)
+            {
+                double dgp = fp[i + 1] - fp[i];
+                dgs[i] += dgp;
+                dgs2[i] += dgp * dgp;
+            }
+            tots += fp[nstate - 1];
+            tots2 += fp[nstate - 1] * fp[nstate - 1];
+        }
+        for (int i = 0; i < nstate - 1; i++)
+        {
+            dgs[i] /= npee;
+            dgs2[i] /= npee;
+            sig2[i] += (dgs2[i] - dgs[i] * dgs[i]) / (npee - 1);
+        }
+        tots /= npee;
+        tots2 /= npee;
+        tot_sig2 += (tots2 - tots * tots) / (npee - 1);
+    }
+    for (int i = 0; i < nstate - 1; i++)
+    {
+        (*dg_err)[i] = std::sqrt(sig2[i] / (npee_max - npee_min + 1));
+    }
+    *dg_tot_err = std::sqrt(tot_sig2 / (npee_max - npee_min + 1));
+
+    return converged;
+}
@@ -0,0 +1,107 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares the MBAR free energy estimator used by gmx bar.
+ *
+ * \ingroup module_gmxana
+ */
+#ifndef GMXANA_MBAR_H
+#define GMXANA_MBAR_H
+
+#include <cstdint>
+
+#include <vector>
+
+#include "gromacs/utility/basedefinitions.h"
+
+/*! \brief The reduced energy differences of all samples of all lambda
+ * states, evaluated at every lambda state, as needed by MBAR.
+ *
+ * The samples of state i are stored contiguously in the columns
+ * offset[i] to offset[i] + n[i] of each row, so that the inner loops
+ * of the solver run over contiguous memory.
+ */
+struct mbar_data_t
+{
+    //! The number of lambda states
+    int nstate = 0;
+    //! The number of samples per state
+    std::vector<int64_t> n;
+    //! The column offset of each state, with nstate + 1 entries
+    std::vector<int64_t> offset;
+    //! The total number of samples
+    int64_t ntot = 0;
+    /*! \brief The nstate x ntot matrix of u_k(x_n) - u_s(x_n) in kT,
+     * with s the state sample n was drawn from */
+    std::vector<double> u;
+};
+
+//! Returns the number of threads to use for a loop over \p n samples.
+int mbar_num_threads(int64_t n);
+
+//! Copies block \p p of \p npee blocks of the samples of each state in \p md_orig to \p md.
+void mbar_data_create_subsample(mbar_data_t* md, const mbar_data_t* md_orig, int p, int npee);
+
+/*! \brief Solves the MBAR equations by self-consistent iteration.
+ *
+ * \param[in]  md      The reduced energy differences
+ * \param[in]  tol     The tolerance on the maximum change of the free energies
+ * \param[in]  maxiter The maximum number of iterations
+ * \param[out] f       The reduced free energies in kT, with f[0] = 0
+ * \returns The number of iterations, or -1 when not converged.
+ */
+int mbar_solve(const mbar_data_t* md, double tol, int maxiter, std::vector<double>* f);
+
+/*! \brief Calculates all MBAR free energies with block averaged error estimates.
+ *
+ * \param[in]  md         The reduced energy differences
+ * \param[in]  tol        The tolerance passed to mbar_solve()
+ * \param[in]  npee_min   The minimum number of blocks for error estimates
+ * \param[in]  npee_max   The maximum number of blocks for error estimates
+ * \param[out] f          The free energies in kT relative to the first state
+ * \param[out] dg_err     The errors of the differences between neighboring states
+ * \param[out] dg_tot_err The error of the total difference
+ * \returns Whether the solver converged.
+ */
+gmx_bool calc_mbar(const mbar_data_t*   md,
+                   double               tol,
+                   int                  npee_min,
+                   int                  npee_max,
+                   std::vector<double>* f,
+                   std::vector<double>* dg_err,
+                   double*              dg_tot_err);
+
+#endif
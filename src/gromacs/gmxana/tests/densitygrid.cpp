@@ -0,0 +1,129 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the grid used by the density analysis tools.
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/densitygrid.h"
+
+#include <numeric>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/mrcdensitymap.h"
+#include "gromacs/math/coordinatetransformation.h"
+#include "gromacs/utility/arrayref.h"
+
+#include "testutils/testasserts.h"
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+TEST(DensityGridTest, BinsPositionsWithXIndexFastest)
+{
+    DensityGrid       grid({ 3, 2, 2 }, 0);
+    std::vector<RVec> x       = { { 0.5, 0.5, 0.5 }, { 2.9, 0.1, 0.1 }, { 0.1, 1.5, 1.5 },
+                            { 2.5, 1.5, 1.5 } };
+    std::vector<real> weights = { 1, 2, 3, 4 };
+    grid.add(x, weights);
+    grid.add(x, 0.5);
+
+    const std::vector<double> sum = grid.sum();
+    ASSERT_EQ(12, sum.size());
+    EXPECT_DOUBLE_EQ(1.5, sum[0]);
+    EXPECT_DOUBLE_EQ(2.5, sum[2]);
+    EXPECT_DOUBLE_EQ(3.5, sum[9]);
+    EXPECT_DOUBLE_EQ(4.5, sum[11]);
+    EXPECT_DOUBLE_EQ(12, std::accumulate(sum.begin(), sum.end(), 0.0));
+}
+
+TEST(DensityGridTest, IgnoresPositionsOutsideTheGrid)
+{
+    DensityGrid       grid({ 2, 2, 2 }, 0);
+    std::vector<RVec> x = { { -0.5, 0.5, 0.5 }, { 0.5, 2.0, 0.5 }, { 0.5, 0.5, 1.5 } };
+    grid.add(x, 1);
+
+    const std::vector<double> sum = grid.sum();
+    EXPECT_DOUBLE_EQ(1, std::accumulate(sum.begin(), sum.end(), 0.0));
+    EXPECT_DOUBLE_EQ(1, sum[4]);
+}
+
+TEST(DensityGridTest, GaussianSpreadingConservesWeight)
+{
+    DensityGrid       grid({ 21, 20, 22 }, 1.5);
+    std::vector<RVec> x = { { 10.5, 10.0, 11.2 }, { 9.3, 10.7, 10.0 } };
+    grid.add(x, 2);
+
+    const std::vector<double> sum = grid.sum();
+    EXPECT_REAL_EQ_TOL(4, std::accumulate(sum.begin(), sum.end(), 0.0),
+                       relativeToleranceAsFloatingPoint(4, 1e-3));
+}
+
+TEST(DensityGridTest, WritesMrcFile)
+{
+    TestFileManager   fileManager;
+    const std::string fileName = fileManager.getTemporaryFilePath("grid.mrc");
+
+    const IVec          numBins = { 3, 4, 5 };
+    std::vector<double> data(numBins[XX] * numBins[YY] * numBins[ZZ]);
+    std::iota(data.begin(), data.end(), 0.0);
+    writeDensityGridAsMrc(fileName, numBins, data, { 1, 2, 3 }, 0.5);
+
+    MrcDensityMapOfFloatFromFileReader reader(fileName);
+    const auto                         density = reader.densityDataCopy();
+    ASSERT_EQ(numBins[ZZ], density.extent(0));
+    ASSERT_EQ(numBins[YY], density.extent(1));
+    ASSERT_EQ(numBins[XX], density.extent(2));
+    EXPECT_FLOAT_EQ(data[(4 * numBins[YY] + 3) * numBins[XX] + 2], density(4, 3, 2));
+
+    // The center of bin (1,1,1) should be at lattice point (1,1,1)
+    RVec x = { 1.75, 2.75, 3.75 };
+    reader.transformationToDensityLattice()({ &x, &x + 1 });
+    EXPECT_REAL_EQ_TOL(1, x[XX], relativeToleranceAsFloatingPoint(1, 1e-5));
+    EXPECT_REAL_EQ_TOL(1, x[YY], relativeToleranceAsFloatingPoint(1, 1e-5));
+    EXPECT_REAL_EQ_TOL(1, x[ZZ], relativeToleranceAsFloatingPoint(1, 1e-5));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
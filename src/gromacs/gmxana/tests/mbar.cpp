@@ -0,0 +1,232 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the MBAR free energy estimator.
+ *
+ * \ingroup module_gmxana
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxana/mbar.h"
+
+#include <cmath>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/normaldistribution.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Returns MBAR data for states with reduced energies
+ * u_k(x) = forceConstant[k] * (x - center[k])^2 / 2, with n[k]
+ * samples drawn from the Boltzmann distribution of each state k.
+ */
+mbar_data_t harmonicStates(const std::vector<double>&  forceConstant,
+                           const std::vector<double>&  center,
+                           const std::vector<int64_t>& n,
+                           uint64_t                    seed)
+{
+    mbar_data_t md;
+    md.nstate = forceConstant.size();
+    md.n      = n;
+    md.offset.assign(md.nstate + 1, 0);
+    for (int i = 0; i < md.nstate; i++)
+    {
+        md.offset[i + 1] = md.offset[i] + md.n[i];
+    }
+    md.ntot = md.offset[md.nstate];
+    md.u.resize(md.nstate * md.ntot);
+
+    ThreeFry2x64<64>           rng(seed, RandomDomain::Other);
+    NormalDistribution<double> dist;
+    auto                       energy = [&](int k, double x) {
+        return 0.5 * forceConstant[k] * (x - center[k]) * (x - center[k]);
+    };
+    for (int i = 0; i < md.nstate; i++)
+    {
+        for (int64_t j = 0; j < md.n[i]; j++)
+        {
+            const double x = center[i] + dist(rng) / std::sqrt(forceConstant[i]);
+            for (int k = 0; k < md.nstate; k++)
+            {
+                md.u[k * md.ntot + md.offset[i] + j] = energy(k, x) - energy(i, x);
+            }
+        }
+    }
+    return md;
+}
+
+/*! \brief Returns the BAR free energy difference between the two states in \p md
+ *
+ * Solves the Bennett acceptance ratio equation for unequal sample sizes
+ * by bisection, independently of the MBAR solver.
+ */
+double barFreeEnergyDifference(const mbar_data_t& md)
+{
+    const double ratio     = static_cast<double>(md.n[0]) / md.n[1];
+    auto         imbalance = [&](double df) {
+        double sum = 0;
+        for (int64_t j = 0; j < md.n[0]; j++)
+        {
+            const double du = md.u[md.ntot + md.offset[0] + j];
+            sum += 1 / (1 + ratio * std::exp(du - df));
+        }
+        for (int64_t j = 0; j < md.n[1]; j++)
+        {
+            const double du = -md.u[md.offset[1] + j];
+            sum -= 1 / (1 + std::exp(df - du) / ratio);
+        }
+        return sum;
+    };
+    double low  = -50;
+    double high = 50;
+    while (high - low > 1e-12)
+    {
+        const double mid = 0.5 * (low + high);
+        if (imbalance(mid) < 0)
+        {
+            low = mid;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return 0.5 * (low + high);
+}
+
+//! Runs the tests with the number of OpenMP threads given by the parameter
+class MbarTest : public ::testing::TestWithParam<int>
+{
+public:
+    MbarTest() : numThreadsToRestore_(gmx_omp_get_max_threads())
+    {
+        gmx_omp_set_num_threads(GetParam());
+    }
+    ~MbarTest() override { gmx_omp_set_num_threads(numThreadsToRestore_); }
+
+private:
+    int numThreadsToRestore_;
+};
+
+TEST_P(MbarTest, TwoStatesReproduceBar)
+{
+    const mbar_data_t md = harmonicStates({ 1.0, 1.3 }, { 0.0, 0.4 }, { 3000, 5000 }, 12345);
+
+    std::vector<double> f;
+    ASSERT_GE(mbar_solve(&md, 1e-12, 100000, &f), 0);
+    ASSERT_EQ(f.size(), 2U);
+    EXPECT_EQ(f[0], 0);
+    EXPECT_NEAR(f[1], barFreeEnergyDifference(md), 1e-9);
+}
+
+TEST_P(MbarTest, HarmonicStatesMatchAnalyticalFreeEnergies)
+{
+    const std::vector<double> forceConstant = { 1.0, 1.5, 2.25, 3.375 };
+    const mbar_data_t         md =
+            harmonicStates(forceConstant, { 0.0, 0.1, 0.2, 0.3 }, { 8000, 6000, 7000, 5000 }, 42);
+
+    std::vector<double> f;
+    ASSERT_GE(mbar_solve(&md, 1e-10, 100000, &f), 0);
+    ASSERT_EQ(f.size(), forceConstant.size());
+    for (size_t k = 0; k < forceConstant.size(); k++)
+    {
+        // The reduced free energy of a harmonic state is -log(sqrt(2 pi / forceConstant))
+        EXPECT_NEAR(f[k], 0.5 * std::log(forceConstant[k] / forceConstant[0]), 0.02);
+    }
+}
+
+TEST_P(MbarTest, ConstantEnergyShiftsAreRecoveredExactly)
+{
+    const std::vector<double> shift = { 0.0, 1.5, -0.7, 3.2, 0.3 };
+    mbar_data_t               md    = harmonicStates({ 1, 1, 1, 1, 1 }, { 0, 0, 0, 0, 0 },
+                                            { 1000, 2000, 1500, 500, 3000 }, 7);
+    for (int i = 0; i < md.nstate; i++)
+    {
+        for (int k = 0; k < md.nstate; k++)
+        {
+            for (int64_t j = 0; j < md.n[i]; j++)
+            {
+                md.u[k * md.ntot + md.offset[i] + j] += shift[k] - shift[i];
+            }
+        }
+    }
+
+    std::vector<double> f;
+    ASSERT_GE(mbar_solve(&md, 1e-12, 100000, &f), 0);
+    for (int k = 0; k < md.nstate; k++)
+    {
+        EXPECT_NEAR(f[k], shift[k], 1e-9);
+    }
+}
+
+TEST_P(MbarTest, BlockAveragedErrorsAreConsistent)
+{
+    const mbar_data_t md =
+            harmonicStates({ 1.0, 1.5, 2.25 }, { 0.0, 0.1, 0.2 }, { 4000, 4000, 4000 }, 3);
+
+    std::vector<double> f, fSolved, dgErr;
+    double              dgTotErr;
+    ASSERT_TRUE(calc_mbar(&md, 1e-10, 4, 5, &f, &dgErr, &dgTotErr));
+    ASSERT_GE(mbar_solve(&md, 1e-10, 100000, &fSolved), 0);
+    ASSERT_EQ(dgErr.size(), 2U);
+    for (int k = 0; k < md.nstate; k++)
+    {
+        EXPECT_DOUBLE_EQ(f[k], fSolved[k]);
+    }
+    for (double err : dgErr)
+    {
+        EXPECT_GT(err, 0);
+        EXPECT_LT(err, 0.1);
+    }
+    EXPECT_GT(dgTotErr, 0);
+    EXPECT_LT(dgTotErr, 0.1);
+}
+
+INSTANTIATE_TEST_CASE_P(WithThreads, MbarTest, ::testing::Values(1, 2, 4));
+
+} // namespace
+} // namespace test
+} // namespace gmx
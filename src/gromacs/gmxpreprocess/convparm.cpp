@@ -45,6 +45,9 @@
 #include <cstring>
 
 #include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/gmxpreprocess/gpp_atomtype.h"
 #include "gromacs/gmxpreprocess/grompp_impl.h"
@@ -57,7 +60,9 @@
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/topology/ifunc.h"
 #include "gromacs/topology/topology.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 static int round_check(real r, int limit, int ftype, const char* name)
@@ -531,6 +536,110 @@ static void enter_function(const InteractionsOfType* p,
     }
 }
 
+//! Hashes the bytes of a parameter set, consistent with comparing them with memcmp.
+struct IParamsHash
+{
+    //! Returns the hash of the bytes of \p iparams.
+    size_t operator()(const t_iparams& iparams) const
+    {
+        return std::hash<std::string_view>()(
+                std::string_view(reinterpret_cast<const char*>(&iparams), sizeof(iparams)));
+    }
+};
+
+//! Compares parameter sets by their bytes, as enter_params() does.
+struct IParamsEqual
+{
+    //! Returns whether \p a and \p b have identical bytes.
+    bool operator()(const t_iparams& a, const t_iparams& b) const
+    {
+        return memcmp(&a, &b, sizeof(t_iparams)) == 0;
+    }
+};
+
+/*! \brief
+ * The parameters and interactions of one function type in one molecule type.
+ *
+ * The parameter types are numbered locally, starting at zero, and are
+ * shifted when they are added to the force-field parameters.
+ */
+struct LocalInteractions
+{
+    //! The function type.
+    t_functype ftype;
+    //! The unique parameters, in order of first use.
+    std::vector<t_iparams> iparams;
+    //! The interactions, with local parameter types.
+    InteractionList ilist;
+};
+
+/*! \brief
+ * Collects the unique parameters and the interactions of \p p, as enter_function() does.
+ *
+ * Parameters are only merged within \p p, as enter_function() only
+ * compares with the types it added itself. This allows processing
+ * different molecule types concurrently.
+ */
+static void collectInteractions(const InteractionsOfType* p,
+                                int                       comb,
+                                real                      reppow,
+                                bool                      bAppend,
+                                LocalInteractions*        local)
+{
+    std::unordered_map<t_iparams, int, IParamsHash, IParamsEqual> typeOfParameters;
+
+    for (const auto& parm : p->interactionTypes)
+    {
+        t_iparams newparam;
+        if (assign_param(local->ftype, &newparam, parm.forceParam(), comb, reppow) < 0)
+        {
+            /* This interaction is all-zero and should not be added */
+            continue;
+        }
+        int type = local->iparams.size();
+        if (bAppend)
+        {
+            local->iparams.push_back(newparam);
+        }
+        else
+        {
+            const auto found = typeOfParameters.emplace(newparam, type);
+            if (found.second)
+            {
+                local->iparams.push_back(newparam);
+            }
+            else
+            {
+                type = found.first->second;
+            }
+        }
+        GMX_RELEASE_ASSERT(parm.atoms().ssize() == NRAL(local->ftype),
+                           "Need to have correct number of atoms for the parameter");
+        append_interaction(&local->ilist, type, parm.atoms());
+    }
+}
+
+/*! \brief
+ * Appends the parameters of \p local to \p ffparams and the interactions to \p il.
+ */
+static void appendInteractions(const LocalInteractions& local,
+                               gmx_ffparams_t*          ffparams,
+                               InteractionList*         il)
+{
+    const int typeOffset = ffparams->numTypes();
+
+    ffparams->iparams.insert(ffparams->iparams.end(), local.iparams.begin(), local.iparams.end());
+    ffparams->functype.insert(ffparams->functype.end(), local.iparams.size(), local.ftype);
+
+    const int numAtoms = NRAL(local.ftype);
+    for (int i = 0; i < local.ilist.size(); i += 1 + numAtoms)
+    {
+        il->iatoms.push_back(local.ilist.iatoms[i] + typeOffset);
+        il->iatoms.insert(il->iatoms.end(), local.ilist.iatoms.begin() + i + 1,
+                          local.ilist.iatoms.begin() + i + 1 + numAtoms);
+    }
+}
+
 void convertInteractionsOfType(int                                      atnr,
                                gmx::ArrayRef<const InteractionsOfType>  nbtypes,
                                gmx::ArrayRef<const MoleculeInformation> mi,
@@ -555,21 +664,58 @@ void convertInteractionsOfType(int                                      atnr,
     enter_function(&(nbtypes[F_BHAM]), static_cast<t_functype>(F_BHAM), comb, reppow, ffp, nullptr,
                    TRUE, TRUE);
 
-    for (size_t mt = 0; mt < mtop->moltype.size(); mt++)
+    /* The parameters of the molecule types are collected in parallel,
+     * and then added to the force-field parameters in order, which gives
+     * the same parameter types as processing them one after the other.
+     * Distance restraints may share a type with the last distance
+     * restraint of a previous molecule type, so these are handled in order.
+     */
+    const int                                   numMolTypes = mtop->moltype.size();
+    std::vector<std::vector<LocalInteractions>> localInteractions(numMolTypes);
+    const int                                   numThreads = gmx_omp_get_max_threads();
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int mt = 0; mt < numMolTypes; mt++)
+    {
+        try
+        {
+            gmx::ArrayRef<const InteractionsOfType> interactions = mi[mt].interactions;
+            for (int ftype = 0; ftype < F_NRE; ftype++)
+            {
+                const unsigned long ftypeFlags = interaction_function[ftype].flags;
+                if ((ftype != F_LJ) && (ftype != F_BHAM)
+                    && ((ftypeFlags & IF_BOND) || (ftypeFlags & IF_VSITE)
+                        || (ftypeFlags & IF_CONSTRAINT)))
+                {
+                    localInteractions[mt].push_back({ static_cast<t_functype>(ftype), {}, {} });
+                    if (ftype != F_DISRES)
+                    {
+                        collectInteractions(&(interactions[ftype]), comb, reppow,
+                                            (ftype == F_POSRES || ftype == F_FBPOSRES),
+                                            &localInteractions[mt].back());
+                    }
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    for (int mt = 0; mt < numMolTypes; mt++)
     {
         molt = &mtop->moltype[mt];
         for (i = 0; (i < F_NRE); i++)
         {
             molt->ilist[i].iatoms.clear();
-
-            gmx::ArrayRef<const InteractionsOfType> interactions = mi[mt].interactions;
-
-            flags = interaction_function[i].flags;
-            if ((i != F_LJ) && (i != F_BHAM)
-                && ((flags & IF_BOND) || (flags & IF_VSITE) || (flags & IF_CONSTRAINT)))
+        }
+        for (const LocalInteractions& local : localInteractions[mt])
+        {
+            if (local.ftype == F_DISRES)
+            {
+                enter_function(&(mi[mt].interactions[F_DISRES]), local.ftype, comb, reppow, ffp,
+                               &molt->ilist[F_DISRES], FALSE, FALSE);
+            }
+            else
             {
-                enter_function(&(interactions[i]), static_cast<t_functype>(i), comb, reppow, ffp,
-                               &molt->ilist[i], FALSE, (i == F_POSRES || i == F_FBPOSRES));
+                appendInteractions(local, ffp, &molt->ilist[local.ftype]);
             }
         }
     }
@@ -44,11 +44,13 @@
 #include <cstdlib>
 #include <cstring>
 
+#include <memory>
 #include <numeric>
 #include <vector>
 
 #include "gromacs/commandline/pargs.h"
 #include "gromacs/fileio/confio.h"
+#include "gromacs/gmxpreprocess/positiongrid.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
 #include "gromacs/mdlib/force.h"
@@ -66,34 +68,23 @@
 #include "gromacs/utility/smalloc.h"
 
 
-/*! \brief Return whether any atoms of two groups are below minimum distance.
+/*! \brief Return whether any atom of a group is closer than the grid cutoff to a grid position.
  *
- * \param[in] pbc the periodic boundary conditions
+ * \param[in] grid the grid with the positions of the atoms to keep away from
  * \param[in] x the coordinates
- * \param[in] smallerGroupIndices the atom indices of the first group to check
- * \param[in] largerGroupIndices the atom indices of the second group to check
- * \param[in] minimumDistance the minimum required distance betwenn any atom in
- *                            the first and second group
- * \returns true if any distance between an atom from group A and group B is
- *               smaller than a minimum distance.
+ * \param[in] groupIndices the atom indices of the group to check
+ * \returns true if any distance between an atom from the group and a position
+ *               in the grid is smaller than the grid cutoff.
  */
-static bool groupsCloserThanCutoffWithPbc(t_pbc*                   pbc,
-                                          rvec                     x[],
-                                          gmx::ArrayRef<const int> smallerGroupIndices,
-                                          gmx::ArrayRef<const int> largerGroupIndices,
-                                          real                     minimumDistance)
+static bool groupCloserThanCutoffToGrid(const gmx::PositionGrid& grid,
+                                        const rvec               x[],
+                                        gmx::ArrayRef<const int> groupIndices)
 {
-    const real minimumDistance2 = minimumDistance * minimumDistance;
-    for (int aIndex : largerGroupIndices)
+    for (int index : groupIndices)
     {
-        for (int bIndex : smallerGroupIndices)
+        if (grid.hasPositionWithinCutoff(x[index]))
         {
-            rvec dx;
-            pbc_dx(pbc, x[aIndex], x[bIndex], dx);
-            if (norm2(dx) < minimumDistance2)
-            {
-                return true;
-            }
+            return true;
         }
     }
     return false;
@@ -127,13 +118,12 @@ static void insert_ion(int                      nsa,
                        int                      repl[],
                        gmx::ArrayRef<const int> index,
                        rvec                     x[],
-                       t_pbc*                   pbc,
                        int                      sign,
                        int                      q,
                        const char*              ionname,
                        t_atoms*                 atoms,
                        real                     rmin,
-                       std::vector<int>*        notSolventGroup)
+                       gmx::PositionGrid*       notSolventGrid)
 {
     std::vector<int> solventMoleculeAtomsToBeReplaced =
             solventMoleculeIndices(solventMoleculesForReplacement->back(), nsa, index);
@@ -141,7 +131,7 @@ static void insert_ion(int                      nsa,
     if (rmin > 0.0)
     {
         // check for proximity to non-solvent
-        while (groupsCloserThanCutoffWithPbc(pbc, x, solventMoleculeAtomsToBeReplaced, *notSolventGroup, rmin)
+        while (groupCloserThanCutoffToGrid(*notSolventGrid, x, solventMoleculeAtomsToBeReplaced)
                && !solventMoleculesForReplacement->empty())
         {
             solventMoleculesForReplacement->pop_back();
@@ -159,7 +149,10 @@ static void insert_ion(int                      nsa,
             solventMoleculesForReplacement->back(), solventMoleculeAtomsToBeReplaced[0], ionname);
 
     /* Replace solvent molecule charges with ion charge */
-    notSolventGroup->push_back(solventMoleculeAtomsToBeReplaced[0]);
+    if (notSolventGrid != nullptr)
+    {
+        notSolventGrid->addPosition(x[solventMoleculeAtomsToBeReplaced[0]]);
+    }
     repl[solventMoleculesForReplacement->back()] = sign;
 
     // The first solvent molecule atom is replaced with an ion and the respective
@@ -632,7 +625,17 @@ int gmx_genion(int argc, char* argv[])
         fprintf(stderr, "Using random seed %d.\n", seed);
 
 
-        std::vector<int> notSolventGroup = invertIndexGroup(atoms.nr, solventGroup);
+        // Cell list of the non-solvent atoms and the placed ions, which the
+        // ions should be at least rmin away from
+        std::unique_ptr<gmx::PositionGrid> notSolventGrid;
+        if (rmin > 0.0)
+        {
+            notSolventGrid = std::make_unique<gmx::PositionGrid>(pbc, rmin);
+            for (int atomIndex : invertIndexGroup(atoms.nr, solventGroup))
+            {
+                notSolventGrid->addPosition(x[atomIndex]);
+            }
+        }
 
         std::vector<int> solventMoleculesForReplacement(nw);
         std::iota(std::begin(solventMoleculesForReplacement), std::end(solventMoleculesForReplacement), 0);
@@ -646,13 +649,13 @@ int gmx_genion(int argc, char* argv[])
         /* Now loop over the ions that have to be placed */
         while (p_num-- > 0)
         {
-            insert_ion(nsa, &solventMoleculesForReplacement, repl, solventGroup, x, &pbc, 1, p_q,
-                       p_name, &atoms, rmin, &notSolventGroup);
+            insert_ion(nsa, &solventMoleculesForReplacement, repl, solventGroup, x, 1, p_q, p_name,
+                       &atoms, rmin, notSolventGrid.get());
         }
         while (n_num-- > 0)
         {
-            insert_ion(nsa, &solventMoleculesForReplacement, repl, solventGroup, x, &pbc, -1, n_q,
-                       n_name, &atoms, rmin, &notSolventGroup);
+            insert_ion(nsa, &solventMoleculesForReplacement, repl, solventGroup, x, -1, n_q, n_name,
+                       &atoms, rmin, notSolventGrid.get());
         }
         fprintf(stderr, "\n");
 
@@ -49,6 +49,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <unordered_map>
 #include <unordered_set>
 
 #include <sys/types.h>
@@ -62,8 +63,26 @@
 
 struct t_define
 {
-    std::string name;
+    //! The value the define is replaced by.
     std::string def;
+    //! Position of the define in the order of definition, defines are replaced in this order.
+    int order;
+};
+
+/*! \brief
+ * The defines of a topology, with lookup by name.
+ *
+ * Also keeps track of the order in which the defines were added,
+ * since that determines which replacements are done first.
+ */
+struct DefineTable
+{
+    //! The defines, by name.
+    std::unordered_map<std::string, t_define> defines;
+    //! The number of defines added so far, used to order them.
+    int numAdded = 0;
+    //! The number of defines with names that are not a single word.
+    int numNonWordNames = 0;
 };
 
 /* enum used for handling ifdefs */
@@ -77,7 +96,7 @@ enum
 
 struct gmx_cpp
 {
-    std::shared_ptr<std::vector<t_define>>    defines;
+    std::shared_ptr<DefineTable>              defines;
     std::shared_ptr<std::vector<std::string>> includes;
     std::unordered_set<std::string>           unmatched_defines;
     FILE*                                     fp = nullptr;
@@ -96,6 +115,12 @@ static bool is_word_end(char c)
     return !((isalnum(c) != 0) || c == '_');
 }
 
+//! Returns whether \p name is non-empty and consists only of word characters.
+static bool isWord(const std::string& name)
+{
+    return !name.empty() && std::none_of(name.begin(), name.end(), is_word_end);
+}
+
 static const char* strstrw(const char* buf, const char* word)
 {
     const char* ptr;
@@ -191,21 +216,31 @@ static void add_include(std::vector<std::string>* includes, const char* includeP
     includes->push_back(includePath);
 }
 
-static void add_define(std::vector<t_define>* defines, const std::string& name, const char* value)
+static void add_define(DefineTable* defines, const std::string& name, const char* value)
 {
     GMX_RELEASE_ASSERT(defines, "Need defines");
     GMX_RELEASE_ASSERT(value, "Need a value");
 
-    for (t_define& define : *defines)
+    auto found = defines->defines.find(name);
+    if (found != defines->defines.end())
     {
-        if (define.name == name)
-        {
-            define.def = value;
-            return;
-        }
+        found->second.def = value;
+        return;
     }
 
-    defines->push_back({ name, value });
+    defines->defines.emplace(name, t_define{ value, defines->numAdded++ });
+    if (!isWord(name))
+    {
+        defines->numNonWordNames++;
+    }
+}
+
+static void remove_define(DefineTable* defines, const std::string& name)
+{
+    if (defines->defines.erase(name) > 0 && !isWord(name))
+    {
+        defines->numNonWordNames--;
+    }
 }
 
 /* Open the file to be processed. The handle variable holds internal
@@ -213,7 +248,7 @@ static void add_define(std::vector<t_define>* defines, const std::string& name,
 static int cpp_open_file(const char*                                filenm,
                          gmx_cpp_t*                                 handle,
                          char**                                     cppopts,
-                         std::shared_ptr<std::vector<t_define>>*    definesFromParent,
+                         std::shared_ptr<DefineTable>*              definesFromParent,
                          std::shared_ptr<std::vector<std::string>>* includesFromParent)
 {
     // TODO: We should avoid new/delete, we should use Pimpl instead
@@ -226,7 +261,7 @@ static int cpp_open_file(const char*                                filenm,
     }
     else
     {
-        cpp->defines = std::make_shared<std::vector<t_define>>();
+        cpp->defines = std::make_shared<DefineTable>();
     }
 
     if (includesFromParent)
@@ -370,22 +405,16 @@ static int process_directive(gmx_cpp_t* handlep, const std::string& dname, const
             {
                 return eCPP_SYNTAX;
             }
-            bool found = false;
-            for (const t_define& define : *handle->defines)
+            bool found = (handle->defines->defines.count(dval) > 0);
+            if (found)
             {
-                if (define.name == dval)
+                // erase from unmatched_defines in original handle
+                gmx_cpp_t root = handle;
+                while (root->parent != nullptr)
                 {
-                    // erase from unmatched_defines in original handle
-                    gmx_cpp_t root = handle;
-                    while (root->parent != nullptr)
-                    {
-                        root = root->parent;
-                    }
-                    root->unmatched_defines.erase(dval);
-
-                    found = true;
-                    break;
+                    root = root->parent;
                 }
+                root->unmatched_defines.erase(dval);
             }
             if ((bIfdef && found) || (bIfndef && !found))
             {
@@ -523,15 +552,7 @@ static int process_directive(gmx_cpp_t* handlep, const std::string& dname, const
         {
             return eCPP_SYNTAX;
         }
-        std::vector<t_define>& defines = *handle->defines;
-        for (size_t i = 0; i < defines.size(); i++)
-        {
-            if (defines[i].name == dval)
-            {
-                defines.erase(defines.begin() + i);
-                break;
-            }
-        }
+        remove_define(handle->defines.get(), dval);
 
         return eCPP_OK;
     }
@@ -540,6 +561,94 @@ static int process_directive(gmx_cpp_t* handlep, const std::string& dname, const
     return eCPP_SYNTAX;
 }
 
+/*! \brief
+ * Appends \p text to \p result, replacing all defines that were added at
+ * position \p firstOrder or later.
+ *
+ * The text is split into words once and each word is looked up in the
+ * define table. The value of a replaced define is processed in the same way,
+ * but only with the defines added after it. This gives the same result as
+ * replacing all occurrences of one define after the other in the order in
+ * which they were added, as was done originally.
+ */
+static void replaceDefinesInText(const DefineTable& defines,
+                                 const char*        text,
+                                 int                firstOrder,
+                                 std::string*       word,
+                                 std::string*       result,
+                                 gmx_cpp*           root)
+{
+    const char* ptr = text;
+    while (*ptr != '\0')
+    {
+        if (is_word_end(*ptr))
+        {
+            result->push_back(*ptr);
+            ++ptr;
+            continue;
+        }
+        const char* wordEnd = ptr;
+        while (!is_word_end(*wordEnd))
+        {
+            ++wordEnd;
+        }
+        word->assign(ptr, wordEnd - ptr);
+        const auto found = defines.defines.find(*word);
+        if (found != defines.defines.end() && !found->second.def.empty()
+            && found->second.order >= firstOrder)
+        {
+            root->unmatched_defines.erase(found->first);
+            replaceDefinesInText(defines, found->second.def.c_str(), found->second.order + 1, word,
+                                 result, root);
+        }
+        else
+        {
+            result->append(ptr, wordEnd - ptr);
+        }
+        ptr = wordEnd;
+    }
+}
+
+/*! \brief
+ * Replaces all occurrences of each define in \p buf, one define after the other.
+ *
+ * Needed for define names that are not a single word, e.g. when
+ * passed with -D on the command line.
+ */
+static void replaceDefinesOneByOne(const DefineTable& defines, int n, char buf[], gmx_cpp* root)
+{
+    std::vector<std::pair<const std::string*, const t_define*>> orderedDefines;
+    for (const auto& define : defines.defines)
+    {
+        orderedDefines.emplace_back(&define.first, &define.second);
+    }
+    std::sort(orderedDefines.begin(), orderedDefines.end(),
+              [](const auto& a, const auto& b) { return a.second->order < b.second->order; });
+
+    for (const auto& define : orderedDefines)
+    {
+        const std::string& defineName = *define.first;
+        const std::string& defineDef  = define.second->def;
+        if (!defineDef.empty() && strstrw(buf, defineName.c_str()) != nullptr)
+        {
+            root->unmatched_defines.erase(defineName);
+
+            std::string name;
+            const char* ptr = buf;
+            const char* ptr2;
+            while ((ptr2 = strstrw(ptr, defineName.c_str())) != nullptr)
+            {
+                name.append(ptr, ptr2 - ptr);
+                name += defineDef;
+                ptr = ptr2 + defineName.size();
+            }
+            name += ptr;
+            GMX_RELEASE_ASSERT(name.size() < static_cast<size_t>(n), "The line should fit in buf");
+            strcpy(buf, name.c_str());
+        }
+    }
+}
+
 /* Return one whole line from the file into buf which holds at most n
    characters, for subsequent processing. Returns integer status. This
    routine also does all the "intelligent" work like processing cpp
@@ -620,44 +729,28 @@ int cpp_read_line(gmx_cpp_t* handlep, int n, char buf[])
     }
 
     /* Check whether we have any defines that need to be replaced. Note
-       that we have to use a best fit algorithm, rather than first come
-       first go. We do this by sorting the defines on length first, and
-       then on alphabetical order. */
-    for (t_define& define : *handle->defines)
+       that later defines are also replaced within the values of earlier
+       defines, but not the other way around. */
+    if (!handle->defines->defines.empty())
     {
-        if (!define.def.empty())
+        // Need to erase unmatched defines in original handle
+        gmx_cpp_t root = handle;
+        while (root->parent != nullptr)
         {
-            int         nn  = 0;
-            const char* ptr = buf;
-            while ((ptr = strstrw(ptr, define.name.c_str())) != nullptr)
-            {
-                nn++;
-                ptr += strlen(define.name.c_str());
-            }
-            if (nn > 0)
-            {
-                // Need to erase  unmatched define in original handle
-                gmx_cpp_t root = handle;
-                while (root->parent != nullptr)
-                {
-                    root = root->parent;
-                }
-                root->unmatched_defines.erase(define.name);
+            root = root->parent;
+        }
 
-                std::string name;
-                const char* ptr = buf;
-                const char* ptr2;
-                while ((ptr2 = strstrw(ptr, define.name.c_str())) != nullptr)
-                {
-                    name.append(ptr, ptr2 - ptr);
-                    name += define.def;
-                    ptr = ptr2 + define.name.size();
-                }
-                name += ptr;
-                GMX_RELEASE_ASSERT(name.size() < static_cast<size_t>(n),
-                                   "The line should fit in buf");
-                strcpy(buf, name.c_str());
-            }
+        if (handle->defines->numNonWordNames > 0)
+        {
+            replaceDefinesOneByOne(*handle->defines, n, buf, root);
+        }
+        else
+        {
+            std::string word;
+            std::string line;
+            replaceDefinesInText(*handle->defines, buf, 0, &word, &line, root);
+            GMX_RELEASE_ASSERT(line.size() < static_cast<size_t>(n), "The line should fit in buf");
+            strcpy(buf, line.c_str());
         }
     }
 
@@ -703,15 +796,10 @@ int cpp_close_file(gmx_cpp_t* handlep)
 
 const std::string* cpp_find_define(const gmx_cpp_t* handlep, const std::string& defineName)
 {
-    for (const t_define& define : *(*handlep)->defines)
-    {
-        if (define.name == defineName)
-        {
-            return &define.def;
-        }
-    }
+    const auto& defines = (*handlep)->defines->defines;
+    const auto  found   = defines.find(defineName);
 
-    return nullptr;
+    return (found != defines.end()) ? &found->second.def : nullptr;
 }
 
 void cpp_done(gmx_cpp_t handle)
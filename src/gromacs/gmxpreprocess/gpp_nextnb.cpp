@@ -41,11 +41,16 @@
 
 #include <cstdlib>
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/gmxpreprocess/grompp_impl.h"
 #include "gromacs/gmxpreprocess/toputil.h"
 #include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/listoflists.h"
 #include "gromacs/utility/smalloc.h"
 
 /* #define DEBUG_NNB */
@@ -72,12 +77,6 @@ static int bond_sort(const void* a, const void* b)
     }
 }
 
-static int compare_int(const void* a, const void* b)
-{
-    return (*reinterpret_cast<const int*>(a) - *reinterpret_cast<const int*>(b));
-}
-
-
 #ifdef DEBUG
 #    define prints(str, n, s) __prints(str, n, s)
 static void __prints(char* str, int n, sortable* s)
@@ -172,77 +171,6 @@ void __print_nnb(t_nextnb* nnb, char* s)
 }
 #endif
 
-static void nnb2excl(t_nextnb* nnb, gmx::ListOfLists<int>* excls)
-{
-    int       i, j, j_index;
-    int       nre, nrx, nrs, nr_of_sortables;
-    sortable* s;
-
-    excls->clear();
-
-    for (i = 0; (i < nnb->nr); i++)
-    {
-        /* calculate the total number of exclusions for atom i */
-        nr_of_sortables = 0;
-        for (nre = 0; (nre <= nnb->nrex); nre++)
-        {
-            nr_of_sortables += nnb->nrexcl[i][nre];
-        }
-
-        /* make space for sortable array */
-        snew(s, nr_of_sortables);
-
-        /* fill the sortable array and sort it */
-        nrs = 0;
-        for (nre = 0; (nre <= nnb->nrex); nre++)
-        {
-            for (nrx = 0; (nrx < nnb->nrexcl[i][nre]); nrx++)
-            {
-                s[nrs].ai = i;
-                s[nrs].aj = nnb->a[i][nre][nrx];
-                nrs++;
-            }
-        }
-        if (nrs != nr_of_sortables)
-        {
-            gmx_incons("Generating exclusions");
-        }
-        prints("nnb2excl before qsort", nr_of_sortables, s);
-        if (nr_of_sortables > 1)
-        {
-            qsort(s, nr_of_sortables, static_cast<size_t>(sizeof(s[0])), bond_sort);
-            prints("nnb2excl after qsort", nr_of_sortables, s);
-        }
-
-        /* remove duplicate entries from the list */
-        j_index = 0;
-        if (nr_of_sortables > 0)
-        {
-            for (j = 1; (j < nr_of_sortables); j++)
-            {
-                if ((s[j].ai != s[j - 1].ai) || (s[j].aj != s[j - 1].aj))
-                {
-                    s[j_index++] = s[j - 1];
-                }
-            }
-            s[j_index++] = s[j - 1];
-        }
-        nr_of_sortables = j_index;
-        prints("after rm-double", j_index, s);
-
-        /* put the sorted exclusions in the target list */
-        excls->pushBackListOfSize(nr_of_sortables);
-        gmx::ArrayRef<int> exclusionsForAtom = excls->back();
-        for (nrs = 0; (nrs < nr_of_sortables); nrs++)
-        {
-            exclusionsForAtom[nrs] = s[nrs].aj;
-        }
-
-        /* cleanup temporary space */
-        sfree(s);
-    }
-}
-
 /*! \brief Return true of neighbor is already present in some exclusion level
  *
  * To avoid exploding complexity when processing exclusions for highly
@@ -389,58 +317,128 @@ void gen_nnb(t_nextnb* nnb, gmx::ArrayRef<InteractionsOfType> plist)
     sfree(s);
 }
 
-static void sort_and_purge_nnb(t_nextnb* nnb)
+/*! \brief Returns the atoms bonded to each atom, using chemical bonds in \p plist
+ *
+ * \param[in]  numAtoms           The number of atoms in the molecule
+ * \param[in]  plist              The interactions of the molecule
+ * \param[out] bondedAtomsStart   The start of the list of each atom in \p bondedAtoms,
+ *                                size numAtoms + 1
+ * \param[out] bondedAtoms        The bonded atoms of all atoms
+ */
+static void makeBondedAtomLists(int                                     numAtoms,
+                                gmx::ArrayRef<const InteractionsOfType> plist,
+                                std::vector<int>*                       bondedAtomsStart,
+                                std::vector<int>*                       bondedAtoms)
 {
-    int  i, j, k, m, n, cnt, prev, idx;
-    bool found;
-
-    for (i = 0; (i < nnb->nr); i++)
+    bondedAtomsStart->assign(numAtoms + 1, 0);
+    for (int ftype = 0; ftype < F_NRE; ftype++)
     {
-        for (n = 0; (n <= nnb->nrex); n++)
+        if (IS_CHEMBOND(ftype))
         {
-            /* Sort atoms in this list */
-            if (nnb->nrexcl[i][n] > 0)
-            {
-                qsort(nnb->a[i][n], nnb->nrexcl[i][n], sizeof(int), compare_int);
-            }
-            cnt  = 0;
-            prev = -1;
-            for (j = 0; j < nnb->nrexcl[i][n]; j++)
+            int i = 0;
+            for (const auto& bond : plist[ftype].interactionTypes)
             {
-                idx = nnb->a[i][n][j];
-
-                found = false;
-                for (m = 0; m < n && !found; m++)
+                const int ai = bond.ai();
+                const int aj = bond.aj();
+                if (ai < 0 || aj < 0 || ai >= numAtoms || aj >= numAtoms)
                 {
-                    for (k = 0; k < nnb->nrexcl[i][m] && !found; k++)
-                    {
-                        found = idx == nnb->a[i][m][k];
-                    }
+                    gmx_fatal(FARGS, "Impossible atom numbers in bond %d: ai=%d, aj=%d", i, ai, aj);
                 }
+                (*bondedAtomsStart)[ai + 1]++;
+                (*bondedAtomsStart)[aj + 1]++;
+                i++;
+            }
+        }
+    }
+    for (int a = 0; a < numAtoms; a++)
+    {
+        (*bondedAtomsStart)[a + 1] += (*bondedAtomsStart)[a];
+    }
 
-                if (!found && nnb->a[i][n][j] != prev)
-                {
-                    nnb->a[i][n][cnt] = nnb->a[i][n][j];
-                    prev              = nnb->a[i][n][cnt];
-                    cnt++;
-                }
+    /* Store every bond in both directions */
+    bondedAtoms->resize(bondedAtomsStart->back());
+    std::vector<int> fillCount(bondedAtomsStart->begin(), bondedAtomsStart->end() - 1);
+    for (int ftype = 0; ftype < F_NRE; ftype++)
+    {
+        if (IS_CHEMBOND(ftype))
+        {
+            for (const auto& bond : plist[ftype].interactionTypes)
+            {
+                (*bondedAtoms)[fillCount[bond.ai()]++] = bond.aj();
+                (*bondedAtoms)[fillCount[bond.aj()]++] = bond.ai();
             }
-            nnb->nrexcl[i][n] = cnt;
         }
     }
 }
 
-
-void generate_excl(int nrexcl, int nratoms, gmx::ArrayRef<InteractionsOfType> plist, gmx::ListOfLists<int>* excls)
+void generate_excl(int                               nrexcl,
+                   int                               nratoms,
+                   gmx::ArrayRef<InteractionsOfType> plist,
+                   gmx::ListOfLists<int>*            excls,
+                   int                               numThreads)
 {
-    t_nextnb nnb;
     if (nrexcl < 0)
     {
         gmx_fatal(FARGS, "Can't have %d exclusions...", nrexcl);
     }
-    init_nnb(&nnb, nratoms, nrexcl);
-    gen_nnb(&nnb, plist);
-    sort_and_purge_nnb(&nnb);
-    nnb2excl(&nnb, excls);
-    done_nnb(&nnb);
+
+    std::vector<int> bondedAtomsStart;
+    std::vector<int> bondedAtoms;
+    makeBondedAtomLists(nratoms, plist, &bondedAtomsStart, &bondedAtoms);
+
+    /* The exclusions of an atom are all atoms, including itself, that are
+     * at most nrexcl bonds away. These are independent for each atom, so we
+     * let each thread do a breadth-first search for a contiguous range of atoms
+     * and concatenate the lists of the threads in order afterwards.
+     */
+    constexpr int c_minNumAtomsPerThread = 1000;
+    numThreads = std::max(1, std::min(numThreads, nratoms / c_minNumAtomsPerThread));
+    std::vector<gmx::ListOfLists<int>> threadExclusions(numThreads);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int thread = 0; thread < numThreads; thread++)
+    {
+        try
+        {
+            const int atomStart = (thread * nratoms) / numThreads;
+            const int atomEnd   = ((thread + 1) * nratoms) / numThreads;
+
+            /* Stores for each atom the last atom whose search visited it */
+            std::vector<int> visitedFrom(nratoms, -1);
+            std::vector<int> exclusions;
+            for (int i = atomStart; i < atomEnd; i++)
+            {
+                exclusions.clear();
+                exclusions.push_back(i);
+                visitedFrom[i] = i;
+                size_t shellStart = 0;
+                for (int distance = 1; distance <= nrexcl; distance++)
+                {
+                    const size_t shellEnd = exclusions.size();
+                    for (size_t n = shellStart; n < shellEnd; n++)
+                    {
+                        const int atom = exclusions[n];
+                        for (int b = bondedAtomsStart[atom]; b < bondedAtomsStart[atom + 1]; b++)
+                        {
+                            const int bondedAtom = bondedAtoms[b];
+                            if (visitedFrom[bondedAtom] != i)
+                            {
+                                visitedFrom[bondedAtom] = i;
+                                exclusions.push_back(bondedAtom);
+                            }
+                        }
+                    }
+                    shellStart = shellEnd;
+                }
+                std::sort(exclusions.begin(), exclusions.end());
+                threadExclusions[thread].pushBack(exclusions);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+
+    excls->clear();
+    for (const auto& exclusionsOfThread : threadExclusions)
+    {
+        excls->appendListOfLists(exclusionsOfThread);
+    }
 }
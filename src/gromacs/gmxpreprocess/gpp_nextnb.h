@@ -80,9 +80,15 @@ void gen_nnb(t_nextnb* nnb, gmx::ArrayRef<InteractionsOfType> plist);
  * initiated using init_nnb.
  */
 
-void generate_excl(int nrexcl, int nratoms, gmx::ArrayRef<InteractionsOfType> plist, gmx::ListOfLists<int>* excls);
+void generate_excl(int                               nrexcl,
+                   int                               nratoms,
+                   gmx::ArrayRef<InteractionsOfType> plist,
+                   gmx::ListOfLists<int>*            excls,
+                   int                               numThreads = 1);
 /* Generate an exclusion block from bonds and constraints in
- * plist.
+ * plist. The exclusions of each atom are all atoms up to nrexcl
+ * bonds away, including the atom itself, sorted by index.
+ * Atoms are processed in parallel using up to numThreads threads.
  */
 
 #endif
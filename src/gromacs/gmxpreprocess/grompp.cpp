@@ -260,7 +260,7 @@ static int rm_interactions(int ifunc, gmx::ArrayRef<MoleculeInformation> mols)
     for (auto& mol : mols)
     {
         n += mol.interactions[ifunc].size();
-        mol.interactions[ifunc].interactionTypes.clear();
+        mol.interactions[ifunc].clear();
     }
     return n;
 }
@@ -508,21 +508,17 @@ static void renumber_moltypes(gmx_mtop_t* sys, std::vector<MoleculeInformation>*
 {
 
     std::vector<int> order;
+    /* The new index of each molecule type, -1 when not used (yet) */
+    std::vector<int> newIndex(molinfo->size(), -1);
     for (gmx_molblock_t& molblock : sys->molblock)
     {
-        const auto found = std::find_if(order.begin(), order.end(), [&molblock](const auto& entry) {
-            return molblock.type == entry;
-        });
-        if (found == order.end())
+        if (newIndex[molblock.type] < 0)
         {
             /* This type did not occur yet, add it */
+            newIndex[molblock.type] = order.size();
             order.push_back(molblock.type);
-            molblock.type = order.size() - 1;
-        }
-        else
-        {
-            molblock.type = std::distance(order.begin(), found);
         }
+        molblock.type = newIndex[molblock.type];
     }
 
     /* We still need to reorder the molinfo structs */
@@ -530,11 +526,9 @@ static void renumber_moltypes(gmx_mtop_t* sys, std::vector<MoleculeInformation>*
     int                              index = 0;
     for (auto& mi : *molinfo)
     {
-        const auto found = std::find(order.begin(), order.end(), index);
-        if (found != order.end())
+        if (newIndex[index] >= 0)
         {
-            int pos    = std::distance(order.begin(), found);
-            minew[pos] = mi;
+            minew[newIndex[index]] = std::move(mi);
         }
         else
         {
@@ -544,7 +538,7 @@ static void renumber_moltypes(gmx_mtop_t* sys, std::vector<MoleculeInformation>*
         index++;
     }
 
-    *molinfo = minew;
+    *molinfo = std::move(minew);
 }
 
 static void molinfo2mtop(gmx::ArrayRef<const MoleculeInformation> mi, gmx_mtop_t* mtop)
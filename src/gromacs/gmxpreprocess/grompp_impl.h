@@ -39,12 +39,17 @@
 #ifndef GMX_GMXPREPROCESS_GROMPP_IMPL_H
 #define GMX_GMXPREPROCESS_GROMPP_IMPL_H
 
+#include <array>
+#include <functional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/gmxpreprocess/notset.h"
 #include "gromacs/topology/atoms.h"
 #include "gromacs/topology/block.h"
 #include "gromacs/topology/idef.h"
+#include "gromacs/topology/ifunc.h"
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/listoflists.h"
@@ -128,6 +133,31 @@ private:
     std::string interactionTypeName_;
 };
 
+/*! \brief
+ * Key for looking up interaction types by their atom types.
+ *
+ * Holds the number of atom types, followed by the types themselves.
+ */
+using InteractionTypeKey = std::array<int, MAXATOMLIST + 1>;
+
+//! Hash function for InteractionTypeKey.
+struct InteractionTypeKeyHash
+{
+    //! Combines the hashes of all elements of \p key.
+    size_t operator()(const InteractionTypeKey& key) const
+    {
+        size_t hash = 0;
+        for (int value : key)
+        {
+            hash ^= std::hash<int>()(value) + 0x9e3779b9 + (hash << 6U) + (hash >> 2U);
+        }
+        return hash;
+    }
+};
+
+//! Maps atom types to the index of the first interaction type with those types.
+using InteractionTypeIndex = std::unordered_map<InteractionTypeKey, int, InteractionTypeKeyHash>;
+
 /*! \libinternal \brief
  * A set of interactions of a given type
  * (found in the enumeration in ifunc.h), complete with
@@ -149,9 +179,38 @@ struct InteractionsOfType
     std::vector<real> cmap;
     //! The five atomtypes followed by a number that identifies the type.
     std::vector<int> cmapAtomTypes;
+    /*! \brief Lookup of interactionTypes by their atom types.
+     *
+     * Filled on demand by grompp when assigning default parameters,
+     * covers the first \p numIndexedInteractionTypes entries.
+     * Appending to interactionTypes keeps the lookup valid, any other
+     * change to interactionTypes should be followed by a call to
+     * invalidateTypeIndices(), or be done through clear().
+     */
+    InteractionTypeIndex interactionTypeIndex;
+    //! Number of entries in interactionTypes covered by interactionTypeIndex.
+    size_t numIndexedInteractionTypes = 0;
+    //! Lookup of the offsets in cmapAtomTypes by the five atom types, filled on demand.
+    InteractionTypeIndex cmapTypeIndex;
+    //! Number of elements in cmapAtomTypes covered by cmapTypeIndex.
+    size_t numIndexedCmapAtomTypes = 0;
 
     //! Number of parameters.
     size_t size() const { return interactionTypes.size(); }
+    //! Removes all parameters and the lookups of them.
+    void clear()
+    {
+        interactionTypes.clear();
+        invalidateTypeIndices();
+    }
+    //! Discards the lookups by atom types, they are rebuilt on the next lookup.
+    void invalidateTypeIndices()
+    {
+        interactionTypeIndex.clear();
+        numIndexedInteractionTypes = 0;
+        cmapTypeIndex.clear();
+        numIndexedCmapAtomTypes = 0;
+    }
     //! Elements in cmap grid data.
     int ncmap() const { return cmap.size(); }
     //! Number of elements in cmapAtomTypes.
@@ -51,6 +51,7 @@
 #include "gromacs/fileio/xvgr.h"
 #include "gromacs/gmxlib/conformation_utilities.h"
 #include "gromacs/gmxpreprocess/makeexclusiondistances.h"
+#include "gromacs/gmxpreprocess/positiongrid.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/utilities.h"
 #include "gromacs/math/vec.h"
@@ -60,7 +61,6 @@
 #include "gromacs/pbcutil/pbc.h"
 #include "gromacs/random/threefry.h"
 #include "gromacs/random/uniformrealdistribution.h"
-#include "gromacs/selection/nbsearch.h"
 #include "gromacs/selection/selection.h"
 #include "gromacs/selection/selectioncollection.h"
 #include "gromacs/selection/selectionoption.h"
@@ -76,6 +76,7 @@
 #include "gromacs/utility/enumerationhelpers.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 using gmx::RVec;
@@ -105,33 +106,60 @@ static void center_molecule(gmx::ArrayRef<RVec> x)
     }
 }
 
-static void generate_trial_conf(gmx::ArrayRef<RVec>       xin,
-                                const rvec                offset,
-                                RotationType              enum_rot,
-                                gmx::DefaultRandomEngine* rng,
-                                std::vector<RVec>*        xout)
+/*! \brief The random numbers that determine a trial placement
+ *
+ * These are drawn serially in the order of the trials, so evaluating
+ * batches of trials in parallel gives the same result as evaluating
+ * the trials one by one.
+ */
+struct TrialRandomNumbers
 {
-    gmx::UniformRealDistribution<real> dist(0, 2.0 * M_PI);
-    xout->assign(xin.begin(), xin.end());
+    //! Uniform random numbers in [0,1) for the offset
+    rvec offset;
+    //! The rotation angles
+    real alfa, beta, gamma;
+};
+
+static TrialRandomNumbers drawTrialRandomNumbers(RotationType                        enum_rot,
+                                                 gmx::UniformRealDistribution<real>* offsetDist,
+                                                 gmx::DefaultRandomEngine*           rng)
+{
+    TrialRandomNumbers trial;
+    for (int d = 0; d < DIM; d++)
+    {
+        trial.offset[d] = (*offsetDist)(*rng);
+    }
 
-    real alfa = 0.0, beta = 0.0, gamma = 0.0;
+    gmx::UniformRealDistribution<real> dist(0, 2.0 * M_PI);
     switch (enum_rot)
     {
         case RotationType::XYZ:
-            alfa  = dist(*rng);
-            beta  = dist(*rng);
-            gamma = dist(*rng);
+            trial.alfa  = dist(*rng);
+            trial.beta  = dist(*rng);
+            trial.gamma = dist(*rng);
             break;
         case RotationType::Z:
-            alfa = beta = 0.;
-            gamma       = dist(*rng);
+            trial.alfa = trial.beta = 0.;
+            trial.gamma             = dist(*rng);
             break;
-        case RotationType::None: alfa = beta = gamma = 0.; break;
+        case RotationType::None: trial.alfa = trial.beta = trial.gamma = 0.; break;
         default: GMX_THROW(gmx::InternalError("Invalid RotationType"));
     }
+    return trial;
+}
+
+static void generate_trial_conf(gmx::ArrayRef<RVec>       xin,
+                                const rvec                offset,
+                                RotationType              enum_rot,
+                                const TrialRandomNumbers& trial,
+                                std::vector<RVec>*        xout)
+{
+    xout->assign(xin.begin(), xin.end());
+
     if (enum_rot == RotationType::XYZ || enum_rot == RotationType::Z)
     {
-        rotate_conf(xout->size(), as_rvec_array(xout->data()), nullptr, alfa, beta, gamma);
+        rotate_conf(xout->size(), as_rvec_array(xout->data()), nullptr, trial.alfa, trial.beta,
+                    trial.gamma);
     }
     for (size_t i = 0; i < xout->size(); ++i)
     {
@@ -139,30 +167,38 @@ static void generate_trial_conf(gmx::ArrayRef<RVec>       xin,
     }
 }
 
-static bool isInsertionAllowed(gmx::AnalysisNeighborhoodSearch* search,
-                               const std::vector<real>&         exclusionDistances,
-                               const std::vector<RVec>&         x,
-                               const std::vector<real>&         exclusionDistances_insrt,
-                               const t_atoms&                   atoms,
-                               const std::set<int>&             removableAtoms,
-                               gmx::AtomsRemover*               remover)
+/*! \brief Returns whether a molecule can be inserted at \p x
+ *
+ * Only the positions in \p grid with index \p firstIndex or higher are
+ * checked. Atoms in \p removableAtoms that overlap are added to
+ * \p overlappingAtoms instead of preventing the insertion.
+ */
+static bool isInsertionAllowed(const gmx::PositionGrid& grid,
+                               const std::vector<real>& exclusionDistances,
+                               const std::vector<RVec>& x,
+                               const std::vector<real>& exclusionDistances_insrt,
+                               const std::set<int>&     removableAtoms,
+                               int                      firstIndex,
+                               std::vector<int>*        overlappingAtoms)
 {
-    gmx::AnalysisNeighborhoodPositions  pos(x);
-    gmx::AnalysisNeighborhoodPairSearch pairSearch = search->startPairSearch(pos);
-    gmx::AnalysisNeighborhoodPair       pair;
-    while (pairSearch.findNextPair(&pair))
+    for (size_t i = 0; i < x.size(); i++)
     {
-        const real r1 = exclusionDistances[pair.refIndex()];
-        const real r2 = exclusionDistances_insrt[pair.testIndex()];
-        if (pair.distance2() < gmx::square(r1 + r2))
-        {
-            if (removableAtoms.count(pair.refIndex()) == 0)
+        const real r2        = exclusionDistances_insrt[i];
+        const auto checkPair = [&](int index, real distance2) {
+            if (index < firstIndex || distance2 >= gmx::square(exclusionDistances[index] + r2))
             {
                 return false;
             }
-            // TODO: If molecule information is available, this should ideally
-            // use it to remove whole molecules.
-            remover->markResidue(atoms, pair.refIndex(), true);
+            if (removableAtoms.count(index) == 0)
+            {
+                return true;
+            }
+            overlappingAtoms->push_back(index);
+            return false;
+        };
+        if (grid.forEachPositionWithinCutoff(x[i], checkPair))
+        {
+            return false;
         }
     }
     return true;
@@ -201,11 +237,6 @@ static void insert_mols(int                  nmol_insrt,
         maxRadius = std::max(maxInsertRadius, maxExistingRadius);
     }
 
-    // TODO: Make all of this exception-safe.
-    gmx::AnalysisNeighborhood nb;
-    nb.setCutoff(maxInsertRadius + maxRadius);
-
-
     if (seed == 0)
     {
         seed = static_cast<int>(gmx::makeRandomSeed());
@@ -241,7 +272,24 @@ static void insert_mols(int                  nmol_insrt,
         exclusionDistances.reserve(finalAtomCount);
     }
 
-    std::vector<RVec> x_n(x_insrt.size());
+    // The grid contains all atoms, including the inserted ones, in the order of x
+    gmx::PositionGrid grid(pbc, maxInsertRadius + maxRadius);
+    for (const RVec& xi : *x)
+    {
+        grid.addPosition(xi);
+    }
+
+    /* Trials are evaluated in parallel in batches of fixed size against the
+     * grid at the start of the batch. They are then committed in order,
+     * checking only against the molecules inserted earlier in the same batch,
+     * which gives the same result as evaluating the trials one by one.
+     */
+    const int c_trialBatchSize = 64;
+    const int numThreads       = std::min(gmx_omp_get_max_threads(), c_trialBatchSize);
+    std::vector<TrialRandomNumbers> pendingTrials;
+    std::vector<std::vector<RVec>>  trialX(c_trialBatchSize);
+    std::vector<std::vector<int>>   trialOverlappingAtoms(c_trialBatchSize);
+    std::vector<char>               trialIsAllowed(c_trialBatchSize);
 
     int                                mol        = 0;
     int                                trial      = 0;
@@ -251,15 +299,8 @@ static void insert_mols(int                  nmol_insrt,
 
     while (mol < nmol_insrt && trial < ntry * nmol_insrt)
     {
-        rvec offset_x;
-        if (!insertAtPositions)
-        {
-            // Insert at random positions.
-            offset_x[XX] = box[XX][XX] * dist(rng);
-            offset_x[YY] = box[YY][YY] * dist(rng);
-            offset_x[ZZ] = box[ZZ][ZZ] * dist(rng);
-        }
-        else
+        int batchSize = std::min(c_trialBatchSize, ntry * nmol_insrt - trial);
+        if (insertAtPositions)
         {
             // Skip a position if ntry trials were not successful.
             if (trial >= firstTrial + ntry)
@@ -271,28 +312,82 @@ static void insert_mols(int                  nmol_insrt,
                 firstTrial = trial;
                 continue;
             }
-            // Insert at positions taken from option -ip file.
-            offset_x[XX] = rpos[XX][mol] + deltaR[XX] * (2 * dist(rng) - 1);
-            offset_x[YY] = rpos[YY][mol] + deltaR[YY] * (2 * dist(rng) - 1);
-            offset_x[ZZ] = rpos[ZZ][mol] + deltaR[ZZ] * (2 * dist(rng) - 1);
+            // All trials in a batch are for the same position, trials
+            // after a successful one are kept for the next position.
+            batchSize = std::min(batchSize, firstTrial + ntry - trial);
         }
-        fprintf(stderr, "\rTry %d", ++trial);
-        fflush(stderr);
-
-        generate_trial_conf(x_insrt, offset_x, enum_rot, &rng, &x_n);
-        gmx::AnalysisNeighborhoodPositions pos(*x);
-        gmx::AnalysisNeighborhoodSearch    search = nb.initSearch(&pbc, pos);
-        if (isInsertionAllowed(&search, exclusionDistances, x_n, exclusionDistances_insrt, *atoms,
-                               removableAtoms, &remover))
+        while (gmx::ssize(pendingTrials) < batchSize)
         {
-            x->insert(x->end(), x_n.begin(), x_n.end());
-            exclusionDistances.insert(exclusionDistances.end(), exclusionDistances_insrt.begin(),
-                                      exclusionDistances_insrt.end());
-            builder.mergeAtoms(atoms_insrt);
-            ++mol;
-            firstTrial = trial;
-            fprintf(stderr, " success (now %d atoms)!\n", builder.currentAtomCount());
+            pendingTrials.push_back(drawTrialRandomNumbers(enum_rot, &dist, &rng));
+        }
+
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+        for (int t = 0; t < batchSize; t++)
+        {
+            try
+            {
+                const TrialRandomNumbers& random = pendingTrials[t];
+                rvec                      offset_x;
+                for (int d = 0; d < DIM; d++)
+                {
+                    if (!insertAtPositions)
+                    {
+                        // Insert at random positions.
+                        offset_x[d] = box[d][d] * random.offset[d];
+                    }
+                    else
+                    {
+                        // Insert at positions taken from option -ip file.
+                        offset_x[d] = rpos[d][mol] + deltaR[d] * (2 * random.offset[d] - 1);
+                    }
+                }
+                generate_trial_conf(x_insrt, offset_x, enum_rot, random, &trialX[t]);
+                trialOverlappingAtoms[t].clear();
+                trialIsAllowed[t] = isInsertionAllowed(grid, exclusionDistances, trialX[t],
+                                                       exclusionDistances_insrt, removableAtoms, 0,
+                                                       &trialOverlappingAtoms[t]);
+            }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+        }
+
+        const int numPositionsBeforeBatch = grid.numPositions();
+        int       numTrialsDone           = 0;
+        while (numTrialsDone < batchSize && mol < nmol_insrt)
+        {
+            const int t = numTrialsDone++;
+            fprintf(stderr, "\rTry %d", ++trial);
+            fflush(stderr);
+
+            std::vector<int> overlapsWithBatch;
+            if (trialIsAllowed[t]
+                && isInsertionAllowed(grid, exclusionDistances, trialX[t], exclusionDistances_insrt,
+                                      removableAtoms, numPositionsBeforeBatch, &overlapsWithBatch))
+            {
+                // TODO: If molecule information is available, this should ideally
+                // use it to remove whole molecules.
+                for (int atomIndex : trialOverlappingAtoms[t])
+                {
+                    remover.markResidue(*atoms, atomIndex, true);
+                }
+                for (const RVec& xi : trialX[t])
+                {
+                    grid.addPosition(xi);
+                }
+                x->insert(x->end(), trialX[t].begin(), trialX[t].end());
+                exclusionDistances.insert(exclusionDistances.end(),
+                                          exclusionDistances_insrt.begin(),
+                                          exclusionDistances_insrt.end());
+                builder.mergeAtoms(atoms_insrt);
+                ++mol;
+                firstTrial = trial;
+                fprintf(stderr, " success (now %d atoms)!\n", builder.currentAtomCount());
+                if (insertAtPositions)
+                {
+                    break;
+                }
+            }
         }
+        pendingTrials.erase(pendingTrials.begin(), pendingTrials.begin() + numTrialsDone);
     }
 
     fprintf(stderr, "\n");
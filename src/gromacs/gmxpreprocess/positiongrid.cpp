@@ -0,0 +1,143 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Implements gmx::PositionGrid.
+ *
+ * \ingroup module_gmxpreprocess
+ */
+#include "gmxpre.h"
+
+#include "positiongrid.h"
+
+#include <cmath>
+
+#include <algorithm>
+
+#include "gromacs/utility/gmxassert.h"
+
+namespace gmx
+{
+
+namespace
+{
+
+//! The maximum number of cells, limits the memory use for small cutoffs
+constexpr int c_maxNumCells = 1 << 22;
+
+} // namespace
+
+PositionGrid::PositionGrid(const t_pbc& pbc, real cutoff) : pbc_(pbc), cutoff2_(cutoff * cutoff)
+{
+    GMX_RELEASE_ASSERT(cutoff > 0, "The cutoff should be positive");
+
+    // Screw PBC shifts the other dimensions when crossing the x boundary
+    const bool usePbc = (pbc.pbcType == PbcType::Xyz || pbc.pbcType == PbcType::XY);
+    useGrid_[XX]      = usePbc;
+    useGrid_[YY]      = usePbc;
+    useGrid_[ZZ]      = (pbc.pbcType == PbcType::Xyz);
+
+    // The cells should be at least the cutoff wide perpendicular to their faces.
+    // With PBC in x and y only, the z box vector can be zero and the cells
+    // are only divided in the xy-plane, so we use the widths in that plane.
+    const real volume   = det(pbc.box);
+    const real area     = pbc.box[XX][XX] * pbc.box[YY][YY];
+    real       numTotal = 1;
+    rvec       numCellsReal;
+    for (int d = 0; d < DIM; d++)
+    {
+        numCellsReal[d] = 1;
+        if (useGrid_[d])
+        {
+            real width;
+            if (useGrid_[ZZ])
+            {
+                rvec normal;
+                cprod(pbc.box[(d + 1) % DIM], pbc.box[(d + 2) % DIM], normal);
+                width = volume / norm(normal);
+            }
+            else
+            {
+                width = area / norm(pbc.box[d == XX ? YY : XX]);
+            }
+            numCellsReal[d] = std::max(std::floor(width / cutoff), real(1));
+        }
+        numTotal *= numCellsReal[d];
+    }
+    // Larger cells are always correct, so scale down when there are too many
+    const real scale = std::min(std::cbrt(c_maxNumCells / numTotal), real(1));
+    for (int d = 0; d < DIM; d++)
+    {
+        numCells_[d] = std::max(static_cast<int>(numCellsReal[d] * scale), 1);
+    }
+    cellFirst_.resize(numCells_[XX] * numCells_[YY] * numCells_[ZZ], -1);
+}
+
+void PositionGrid::cellCoordinates(const RVec& x, ivec cell) const
+{
+    // Fractional coordinates with respect to the lower-triangular box
+    const matrix& box = pbc_.box;
+    rvec          s   = { 0, 0, 0 };
+    if (useGrid_[ZZ])
+    {
+        s[ZZ] = x[ZZ] / box[ZZ][ZZ];
+    }
+    if (useGrid_[YY])
+    {
+        s[YY] = (x[YY] - s[ZZ] * box[ZZ][YY]) / box[YY][YY];
+    }
+    if (useGrid_[XX])
+    {
+        s[XX] = (x[XX] - s[ZZ] * box[ZZ][XX] - s[YY] * box[YY][XX]) / box[XX][XX];
+    }
+    for (int d = 0; d < DIM; d++)
+    {
+        const real sInBox = s[d] - std::floor(s[d]);
+        cell[d]           = std::min(static_cast<int>(sInBox * numCells_[d]), numCells_[d] - 1);
+    }
+}
+
+void PositionGrid::addPosition(const RVec& x)
+{
+    ivec c;
+    cellCoordinates(x, c);
+    const int cell  = (c[XX] * numCells_[YY] + c[YY]) * numCells_[ZZ] + c[ZZ];
+    const int index = positions_.size();
+    positions_.push_back(x);
+    next_.push_back(cellFirst_[cell]);
+    cellFirst_[cell] = index;
+}
+
+} // namespace gmx
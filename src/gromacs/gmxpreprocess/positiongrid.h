@@ -0,0 +1,158 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Declares a cell list of positions that can be extended incrementally.
+ *
+ * \ingroup module_gmxpreprocess
+ */
+#ifndef GMX_GMXPREPROCESS_POSITIONGRID_H
+#define GMX_GMXPREPROCESS_POSITIONGRID_H
+
+#include <vector>
+
+#include "gromacs/math/vec.h"
+#include "gromacs/math/vectypes.h"
+#include "gromacs/pbcutil/pbc.h"
+#include "gromacs/utility/real.h"
+
+namespace gmx
+{
+
+/*! \internal
+ * \brief Cell list of positions that supports adding positions at any time
+ *
+ * Positions are put into cells of the (triclinic) unit cell that are at
+ * least the cutoff wide in all periodic dimensions, so all positions
+ * within the cutoff of a test position are found in the neighboring cells.
+ * In contrast to AnalysisNeighborhoodSearch, positions can be added
+ * without rebuilding the grid, so checking a position and adding it
+ * both take constant time for uniform densities.
+ *
+ * Distances are computed with pbc_dx(). For non-periodic dimensions and
+ * screw PBC a single cell is used along the affected dimensions.
+ *
+ * Searching is thread safe as long as no positions are added concurrently.
+ */
+class PositionGrid
+{
+public:
+    /*! \brief Sets up an empty grid
+     *
+     * \param[in] pbc     The periodic boundary conditions, a copy is stored
+     * \param[in] cutoff  The maximum search distance, should be > 0
+     */
+    PositionGrid(const t_pbc& pbc, real cutoff);
+
+    //! Adds a position, its index is the number of positions added before
+    void addPosition(const RVec& x);
+
+    //! Returns the number of positions added
+    int numPositions() const { return positions_.size(); }
+
+    /*! \brief Calls \p function for all positions within the cutoff of \p x
+     *
+     * \p function is called as function(index, distance2) and should return
+     * true to stop the search.
+     *
+     * \returns true when the search was stopped by \p function
+     */
+    template<typename Function>
+    bool forEachPositionWithinCutoff(const RVec& x, Function&& function) const
+    {
+        ivec center;
+        cellCoordinates(x, center);
+        ivec first, last;
+        for (int d = 0; d < DIM; d++)
+        {
+            // With fewer than three cells all cells are neighbors
+            first[d] = (numCells_[d] < 3 ? 0 : center[d] - 1);
+            last[d]  = (numCells_[d] < 3 ? numCells_[d] - 1 : center[d] + 1);
+        }
+        for (int cx = first[XX]; cx <= last[XX]; cx++)
+        {
+            const int ix = (cx + numCells_[XX]) % numCells_[XX];
+            for (int cy = first[YY]; cy <= last[YY]; cy++)
+            {
+                const int iy = (cy + numCells_[YY]) % numCells_[YY];
+                for (int cz = first[ZZ]; cz <= last[ZZ]; cz++)
+                {
+                    const int iz   = (cz + numCells_[ZZ]) % numCells_[ZZ];
+                    const int cell = (ix * numCells_[YY] + iy) * numCells_[ZZ] + iz;
+                    for (int i = cellFirst_[cell]; i >= 0; i = next_[i])
+                    {
+                        rvec dx;
+                        pbc_dx(&pbc_, x, positions_[i], dx);
+                        const real distance2 = norm2(dx);
+                        if (distance2 < cutoff2_ && function(i, distance2))
+                        {
+                            return true;
+                        }
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    //! Returns whether any position is closer than the cutoff to \p x
+    bool hasPositionWithinCutoff(const RVec& x) const
+    {
+        return forEachPositionWithinCutoff(x, [](int, real) { return true; });
+    }
+
+private:
+    //! Computes the cell coordinates of \p x
+    void cellCoordinates(const RVec& x, ivec cell) const;
+
+    //! The periodic boundary conditions
+    t_pbc pbc_;
+    //! The square of the cutoff
+    real cutoff2_;
+    //! Whether the grid is divided along each box vector
+    bool useGrid_[DIM];
+    //! The number of cells along each box vector
+    ivec numCells_;
+    //! The index of the last added position in each cell, -1 when empty
+    std::vector<int> cellFirst_;
+    //! The index of the next position in the same cell, -1 at the end
+    std::vector<int> next_;
+    //! The positions
+    std::vector<RVec> positions_;
+};
+
+} // namespace gmx
+
+#endif
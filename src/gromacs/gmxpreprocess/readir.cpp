@@ -46,6 +46,7 @@
 
 #include <algorithm>
 #include <string>
+#include <utility>
 
 #include "gromacs/awh/read_params.h"
 #include "gromacs/fileio/readinp.h"
@@ -571,6 +572,47 @@ void check_ir(const char*                   mdparin,
         }
     }
 
+    if (ir->useMts)
+    {
+        sprintf(err_buf, "Multiple time stepping is only supported with integrator %s",
+                ei_names[eiMD]);
+        CHECK(ir->eI != eiMD);
+        sprintf(err_buf,
+                "Multiple time stepping requires Ewald-type electrostatics or LJ-PME, "
+                "otherwise there are no long-range forces to compute less frequently");
+        CHECK(!(EEL_PME_EWALD(ir->coulombtype) || EVDW_PME(ir->vdwtype)));
+        sprintf(err_buf, "With multiple time stepping mts-factor should be larger than 1");
+        CHECK(ir->mtsFactor < 2);
+
+        if (ir->mtsFactor >= 2)
+        {
+            /* Energies, the virial and output forces are only complete
+             * at steps where the long-range forces are computed.
+             */
+            std::vector<std::pair<const char*, int>> intervals = {
+                { "nstcalcenergy", ir->nstcalcenergy },
+                { "nstenergy", ir->nstenergy },
+                { "nstlog", ir->nstlog },
+                { "nstfout", ir->nstfout }
+            };
+            if (ir->epc != epcNO)
+            {
+                intervals.emplace_back("nstpcouple", ir->nstpcouple);
+            }
+            if (ir->efep != efepNO)
+            {
+                intervals.emplace_back("nstdhdl", ir->fepvals->nstdhdl);
+            }
+            for (const auto& interval : intervals)
+            {
+                sprintf(err_buf,
+                        "With multiple time stepping %s should be a multiple of mts-factor",
+                        interval.first);
+                CHECK(interval.second % ir->mtsFactor != 0);
+            }
+        }
+    }
+
     if (ir->nsteps == 0 && !ir->bContinuation)
     {
         warning_note(wi,
@@ -1883,6 +1925,9 @@ void get_ir(const char*     mdparin,
     printStringNoNewline(
             &inp, "Part index is updated automatically on checkpointing (keeps files separate)");
     ir->simulation_part = get_eint(&inp, "simulation-part", 1, wi);
+    printStringNoNewline(&inp, "multiple time stepping for the long-range nonbonded forces");
+    ir->useMts    = (get_eeenum(&inp, "mts", yesno_names, wi) != 0);
+    ir->mtsFactor = get_eint(&inp, "mts-factor", 2, wi);
     printStringNoNewline(&inp, "mode for center of mass motion removal");
     ir->comm_mode = get_eeenum(&inp, "comm-mode", ecm_names, wi);
     printStringNoNewline(&inp, "number of steps for center of mass motion removal");
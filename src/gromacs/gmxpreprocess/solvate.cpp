@@ -39,9 +39,13 @@
 
 #include "solvate.h"
 
+#include <cmath>
 #include <cstring>
 
 #include <algorithm>
+#include <array>
+#include <memory>
+#include <numeric>
 #include <random>
 #include <vector>
 
@@ -50,6 +54,7 @@
 #include "gromacs/fileio/pdbio.h"
 #include "gromacs/gmxlib/conformation_utilities.h"
 #include "gromacs/gmxpreprocess/makeexclusiondistances.h"
+#include "gromacs/gmxpreprocess/positiongrid.h"
 #include "gromacs/math/functions.h"
 #include "gromacs/math/units.h"
 #include "gromacs/math/vec.h"
@@ -63,9 +68,11 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/arraysize.h"
 #include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
 using gmx::RVec;
@@ -366,6 +373,121 @@ static void replicateSolventBox(t_atoms*           atoms,
     fprintf(stderr, "Solvent box contains %d atoms in %d residues\n", atoms->nr, atoms->nres);
 }
 
+//! Scale factor for the solvent-solvent overlap search cutoff, the exact check decides
+constexpr real c_solventOverlapSearchCutoffScale = 1.01;
+
+/*! \brief
+ * Overlapping pair of solvent atoms across the edges.
+ *
+ * The atom and residue indices refer to the replicated solvent configuration.
+ */
+struct SolventOverlap
+{
+    //! The lower atom index
+    int atom1;
+    //! The higher atom index
+    int atom2;
+    //! The residue index of atom1
+    int residue1;
+    //! The residue index of atom2
+    int residue2;
+    //! Whether the residue of atom2 should be removed, otherwise that of atom1
+    bool removeSecond;
+};
+
+/*! \brief
+ * Adds a pair of solvent atoms to \p overlaps when they overlap across the edges.
+ *
+ * \param[in]     pbc        PBC information.
+ * \param[in]     maxRadius  The maximum solvent exclusion radius.
+ * \param[in]     atom1      Index of the first atom, should be lower than \p atom2.
+ * \param[in]     atom2      Index of the second atom.
+ * \param[in]     residue1   Residue index of the first atom.
+ * \param[in]     residue2   Residue index of the second atom.
+ * \param[in]     x1         Position of the first atom.
+ * \param[in]     x2         Position of the second atom.
+ * \param[in]     r1         Exclusion radius of the first atom.
+ * \param[in]     r2         Exclusion radius of the second atom.
+ * \param[in,out] overlaps   The overlapping pairs.
+ *
+ * The distance is computed with pbc_dx(), so the result does not depend on
+ * the search that found the pair.
+ */
+static void addSolventOverlap(const t_pbc&                 pbc,
+                              real                         maxRadius,
+                              int                          atom1,
+                              int                          atom2,
+                              int                          residue1,
+                              int                          residue2,
+                              const rvec                   x1,
+                              const rvec                   x2,
+                              real                         r1,
+                              real                         r2,
+                              std::vector<SolventOverlap>* overlaps)
+{
+    rvec dx;
+    pbc_dx(&pbc, x2, x1, dx);
+    if (norm2(dx) >= gmx::square(r1 + r2))
+    {
+        return;
+    }
+    rvec_sub(x2, x1, dx);
+    bool bCandidate1 = false, bCandidate2 = false;
+    // To satisfy Clang static analyzer.
+    GMX_ASSERT(pbc.ndim_ePBC <= DIM, "Too many periodic dimensions");
+    for (int d = 0; d < pbc.ndim_ePBC; ++d)
+    {
+        // If the distance in some dimension is larger than the
+        // cutoff, then it means that the distance has been computed
+        // over the PBC.  Mark the position with a larger coordinate
+        // for potential removal.
+        if (dx[d] > maxRadius)
+        {
+            bCandidate2 = true;
+        }
+        else if (dx[d] < -maxRadius)
+        {
+            bCandidate1 = true;
+        }
+    }
+    if (bCandidate1 || bCandidate2)
+    {
+        // Only mark one of the positions for removal if both were
+        // candidates, atom2 is the one with the higher index.
+        overlaps->push_back({ atom1, atom2, residue1, residue2, bCandidate2 });
+    }
+}
+
+/*! \brief
+ * Decides which residues to remove for the overlapping pairs.
+ *
+ * \param[in,out] overlaps          The overlapping pairs, sorted on return.
+ * \param[in,out] residueIsRemoved  Whether each residue is removed.
+ *
+ * The pairs are processed in order of their atom indices. A pair is skipped
+ * when one of its residues has already been removed, so the result only
+ * depends on the set of pairs, not on the order in which they were found.
+ */
+static void resolveSolventOverlaps(std::vector<SolventOverlap>* overlaps,
+                                   std::vector<char>*           residueIsRemoved)
+{
+    const auto pairLess = [](const SolventOverlap& a, const SolventOverlap& b) {
+        return a.atom1 < b.atom1 || (a.atom1 == b.atom1 && a.atom2 < b.atom2);
+    };
+    const auto pairEqual = [](const SolventOverlap& a, const SolventOverlap& b) {
+        return a.atom1 == b.atom1 && a.atom2 == b.atom2;
+    };
+    std::sort(overlaps->begin(), overlaps->end(), pairLess);
+    overlaps->erase(std::unique(overlaps->begin(), overlaps->end(), pairEqual), overlaps->end());
+    for (const SolventOverlap& overlap : *overlaps)
+    {
+        if (!(*residueIsRemoved)[overlap.residue1] && !(*residueIsRemoved)[overlap.residue2])
+        {
+            (*residueIsRemoved)[overlap.removeSecond ? overlap.residue2 : overlap.residue1] = 1;
+        }
+    }
+}
+
 /*! \brief
  * Removes overlap of solvent atoms across the edges.
  *
@@ -384,6 +506,10 @@ static void replicateSolventBox(t_atoms*           atoms,
  * solvent outside those box edges; these atoms can then overlap with those on
  * the opposite box edge in a way that is not part of the pre-equilibrated
  * configuration.
+ *
+ * The overlapping pairs are resolved with resolveSolventOverlaps(), so
+ * the result does not depend on the order of the pair search and
+ * generateSolventInTiles() produces the same result.
  */
 static void removeSolventBoxOverlap(t_atoms*           atoms,
                                     std::vector<RVec>* x,
@@ -398,57 +524,30 @@ static void removeSolventBoxOverlap(t_atoms*           atoms,
     // opposite edges.
     const real                maxRadius = *std::max_element(r->begin(), r->end());
     gmx::AnalysisNeighborhood nb;
-    nb.setCutoff(2 * maxRadius);
+    nb.setCutoff(c_solventOverlapSearchCutoffScale * 2 * maxRadius);
     gmx::AnalysisNeighborhoodPositions  pos(*x);
     gmx::AnalysisNeighborhoodSearch     search     = nb.initSearch(&pbc, pos);
     gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(pos);
     gmx::AnalysisNeighborhoodPair       pair;
+    std::vector<SolventOverlap>         overlaps;
     while (pairSearch.findNextPair(&pair))
     {
-        const int i1 = pair.refIndex();
-        const int i2 = pair.testIndex();
-        if (remover.isMarked(i2))
-        {
-            pairSearch.skipRemainingPairsForTestPosition();
-            continue;
-        }
-        if (remover.isMarked(i1) || atoms->atom[i1].resind == atoms->atom[i2].resind)
+        const int i1 = std::min(pair.refIndex(), pair.testIndex());
+        const int i2 = std::max(pair.refIndex(), pair.testIndex());
+        if (atoms->atom[i1].resind != atoms->atom[i2].resind)
         {
-            continue;
+            addSolventOverlap(pbc, maxRadius, i1, i2, atoms->atom[i1].resind,
+                              atoms->atom[i2].resind, (*x)[i1], (*x)[i2], (*r)[i1], (*r)[i2],
+                              &overlaps);
         }
-        if (pair.distance2() < gmx::square((*r)[i1] + (*r)[i2]))
+    }
+    std::vector<char> residueIsRemoved(atoms->nres, 0);
+    resolveSolventOverlaps(&overlaps, &residueIsRemoved);
+    for (int i = 0; i < atoms->nr; i++)
+    {
+        if (residueIsRemoved[atoms->atom[i].resind] && !remover.isMarked(i))
         {
-            rvec dx;
-            rvec_sub((*x)[i2], (*x)[i1], dx);
-            bool bCandidate1 = false, bCandidate2 = false;
-            // To satisfy Clang static analyzer.
-            GMX_ASSERT(pbc.ndim_ePBC <= DIM, "Too many periodic dimensions");
-            for (int d = 0; d < pbc.ndim_ePBC; ++d)
-            {
-                // If the distance in some dimension is larger than the
-                // cutoff, then it means that the distance has been computed
-                // over the PBC.  Mark the position with a larger coordinate
-                // for potential removal.
-                if (dx[d] > maxRadius)
-                {
-                    bCandidate2 = true;
-                }
-                else if (dx[d] < -maxRadius)
-                {
-                    bCandidate1 = true;
-                }
-            }
-            // Only mark one of the positions for removal if both were
-            // candidates.
-            if (bCandidate2 && (!bCandidate1 || i2 > i1))
-            {
-                remover.markResidue(*atoms, i2, true);
-                pairSearch.skipRemainingPairsForTestPosition();
-            }
-            else if (bCandidate1)
-            {
-                remover.markResidue(*atoms, i1, true);
-            }
+            remover.markResidue(*atoms, i, true);
         }
     }
 
@@ -568,6 +667,425 @@ static void removeSolventOverlappingWithSolute(t_atoms*                 atoms,
             originalAtomCount - atoms->nr);
 }
 
+/*! \brief
+ * Generates the solvent configuration per copy of the solvent box.
+ *
+ * \param[in,out] atoms     Solvent atoms, replaced by the generated solvent.
+ * \param[in,out] x         Solvent positions.
+ * \param[in,out] v         Solvent velocities (can be empty).
+ * \param[in,out] r         Solvent exclusion radii.
+ * \param[in]     box       Initial solvent box.
+ * \param[in]     pbc       PBC information, should be rectangular and periodic.
+ * \param[in]     x_solute  Solute positions.
+ * \param[in]     r_solute  Solute exclusion radii.
+ * \param[in]     rshell    The radius outside the solute molecule, 0 for no shell.
+ *
+ * This generates the same solvent as replicateSolventBox() followed by
+ * removeSolventBoxOverlap(), removeSolventOutsideShell() and
+ * removeSolventOverlappingWithSolute(), but without building the full
+ * replicated configuration. Each copy of the solvent box (tile) is generated
+ * and filtered in parallel. The solvent-solvent overlap of a tile is searched
+ * for among the atoms of the tile and of the neighboring tiles, or their
+ * periodic images, that can be within the cutoff. So the positions used for
+ * searching are bounded per tile. For the whole box only the overlapping
+ * pairs, a flag per residue and the indices of the kept residues are stored
+ * until the final configuration is built.
+ */
+static void generateSolventInTiles(t_atoms*                 atoms,
+                                   std::vector<RVec>*       x,
+                                   std::vector<RVec>*       v,
+                                   std::vector<real>*       r,
+                                   const matrix             box,
+                                   const t_pbc&             pbc,
+                                   const std::vector<RVec>& x_solute,
+                                   const std::vector<real>& r_solute,
+                                   real                     rshell)
+{
+    // The atom ranges of the residues of the solvent box
+    std::vector<int> residueStart;
+    for (int i = 0; i < atoms->nr; i++)
+    {
+        if (i == 0 || atoms->atom[i].resind != atoms->atom[i - 1].resind)
+        {
+            residueStart.push_back(i);
+        }
+    }
+    residueStart.push_back(atoms->nr);
+    const int numResidues = residueStart.size() - 1;
+
+    // Calculate the box multiplication factors.
+    ivec n_box;
+    int  numTiles = 1;
+    for (int i = 0; i < DIM; ++i)
+    {
+        n_box[i] = 1;
+        while (n_box[i] * box[i][i] < pbc.box[i][i])
+        {
+            n_box[i]++;
+        }
+        numTiles *= n_box[i];
+    }
+    fprintf(stderr, "Will generate new solvent configuration of %dx%dx%d boxes in tiles\n",
+            n_box[XX], n_box[YY], n_box[ZZ]);
+    const auto tileShift = [&n_box, box](int tile, rvec delta) {
+        delta[XX] = (tile / (n_box[YY] * n_box[ZZ])) * box[XX][XX];
+        delta[YY] = ((tile / n_box[ZZ]) % n_box[YY]) * box[YY][YY];
+        delta[ZZ] = (tile % n_box[ZZ]) * box[ZZ][ZZ];
+    };
+
+    const real maxRadius = *std::max_element(r->begin(), r->end());
+    rvec       boxWithMargin;
+    rvec       minCoordinate = { GMX_REAL_MAX, GMX_REAL_MAX, GMX_REAL_MAX };
+    rvec       maxCoordinate = { -GMX_REAL_MAX, -GMX_REAL_MAX, -GMX_REAL_MAX };
+    for (int d = 0; d < DIM; ++d)
+    {
+        boxWithMargin[d] = pbc.box[d][d] + 3 * maxRadius;
+        for (int i = 0; i < atoms->nr; i++)
+        {
+            minCoordinate[d] = std::min(minCoordinate[d], (*x)[i][d]);
+            maxCoordinate[d] = std::max(maxCoordinate[d], (*x)[i][d]);
+        }
+    }
+
+    // Returns the residues that replicateSolventBox() keeps in a tile
+    const auto keptResiduesInTile = [&](int tile) {
+        rvec delta;
+        tileShift(tile, delta);
+        std::vector<int> residues;
+        for (int res = 0; res < numResidues; res++)
+        {
+            bool bKeepResidue = false;
+            for (int i = residueStart[res]; i < residueStart[res + 1] && !bKeepResidue; i++)
+            {
+                bool bKeepAtom = true;
+                for (int m = 0; m < DIM; ++m)
+                {
+                    bKeepAtom = bKeepAtom && (delta[m] + (*x)[i][m] < boxWithMargin[m]);
+                }
+                bKeepResidue = bKeepAtom;
+            }
+            if (bKeepResidue)
+            {
+                residues.push_back(res);
+            }
+        }
+        return residues;
+    };
+
+    /* For each tile index along each dimension, store the tile indices and
+     * periodic shifts of the tiles with atoms that can be within the overlap
+     * search cutoff of the atoms of the tile along that dimension.
+     */
+    const real searchCutoff = c_solventOverlapSearchCutoffScale * 2 * maxRadius;
+    std::array<std::vector<std::vector<std::pair<int, real>>>, DIM> neighborTiles;
+    for (int d = 0; d < DIM; ++d)
+    {
+        neighborTiles[d].resize(n_box[d]);
+        const int maxShift = (d < pbc.ndim_ePBC ? 1 : 0);
+        for (int tile1 = 0; tile1 < n_box[d]; tile1++)
+        {
+            for (int tile2 = 0; tile2 < n_box[d]; tile2++)
+            {
+                for (int s = -maxShift; s <= maxShift; s++)
+                {
+                    const real shift    = s * pbc.box[d][d];
+                    const real offset   = (tile2 - tile1) * box[d][d] + shift;
+                    const real distance = std::abs(offset) - (maxCoordinate[d] - minCoordinate[d]);
+                    if (distance < searchCutoff)
+                    {
+                        neighborTiles[d][tile1].emplace_back(tile2, shift);
+                    }
+                }
+            }
+        }
+    }
+
+    const int numThreads = std::min(gmx_omp_get_max_threads(), numTiles);
+
+    // Count the kept atoms and residues, to obtain the indices in the replicated configuration
+    std::vector<int> tileNumAtoms(numTiles, 0);
+    std::vector<int> tileNumResidues(numTiles, 0);
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        try
+        {
+            for (int res : keptResiduesInTile(tile))
+            {
+                tileNumAtoms[tile] += residueStart[res + 1] - residueStart[res];
+                tileNumResidues[tile]++;
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    std::vector<int> tileAtomOffset(numTiles + 1, 0);
+    std::vector<int> tileResidueOffset(numTiles + 1, 0);
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        tileAtomOffset[tile + 1]    = tileAtomOffset[tile] + tileNumAtoms[tile];
+        tileResidueOffset[tile + 1] = tileResidueOffset[tile] + tileNumResidues[tile];
+    }
+    fprintf(stderr, "Solvent box contains %d atoms in %d residues\n", tileAtomOffset[numTiles],
+            tileResidueOffset[numTiles]);
+
+    /* Find the overlapping pairs of solvent atoms per tile. The atoms of the
+     * tile are searched against those of the tile and of the neighboring
+     * tiles. The search positions are shifted to the periodic images close
+     * to the tile, the checks use the positions in the replicated
+     * configuration.
+     */
+    std::vector<std::vector<SolventOverlap>> tileOverlaps(numTiles);
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        try
+        {
+            if (tileNumAtoms[tile] == 0)
+            {
+                continue;
+            }
+
+            std::vector<RVec> localX;
+            std::vector<RVec> searchX;
+            std::vector<real> localR;
+            std::vector<int>  localAtom;
+            std::vector<int>  localResidue;
+            const auto addTile = [&](int tileToAdd, const rvec shift) {
+                rvec delta;
+                tileShift(tileToAdd, delta);
+                int atom    = tileAtomOffset[tileToAdd];
+                int residue = tileResidueOffset[tileToAdd];
+                for (int res : keptResiduesInTile(tileToAdd))
+                {
+                    for (int i = residueStart[res]; i < residueStart[res + 1]; i++)
+                    {
+                        RVec xi;
+                        for (int m = 0; m < DIM; ++m)
+                        {
+                            xi[m] = delta[m] + (*x)[i][m];
+                        }
+                        localX.push_back(xi);
+                        searchX.push_back(xi);
+                        rvec_inc(searchX.back(), shift);
+                        localR.push_back((*r)[i]);
+                        localAtom.push_back(atom++);
+                        localResidue.push_back(residue);
+                    }
+                    residue++;
+                }
+            };
+            const rvec noShift = { 0, 0, 0 };
+            addTile(tile, noShift);
+            const int numOwnAtoms = localX.size();
+
+            const ivec tileIndex = { tile / (n_box[YY] * n_box[ZZ]), (tile / n_box[ZZ]) % n_box[YY],
+                                     tile % n_box[ZZ] };
+            for (const auto& neighborX : neighborTiles[XX][tileIndex[XX]])
+            {
+                for (const auto& neighborY : neighborTiles[YY][tileIndex[YY]])
+                {
+                    for (const auto& neighborZ : neighborTiles[ZZ][tileIndex[ZZ]])
+                    {
+                        const int neighbor =
+                                (neighborX.first * n_box[YY] + neighborY.first) * n_box[ZZ]
+                                + neighborZ.first;
+                        const rvec shift = { neighborX.second, neighborY.second, neighborZ.second };
+                        // The atoms of this tile have already been added
+                        if (neighbor != tile || norm2(shift) > 0)
+                        {
+                            addTile(neighbor, shift);
+                        }
+                    }
+                }
+            }
+
+            gmx::AnalysisNeighborhood     nb;
+            gmx::AnalysisNeighborhoodPair pair;
+            nb.setCutoff(searchCutoff);
+            gmx::AnalysisNeighborhoodPositions  pos(searchX);
+            gmx::AnalysisNeighborhoodSearch     search = nb.initSearch(nullptr, pos);
+            gmx::AnalysisNeighborhoodPositions  ownPos(as_rvec_array(searchX.data()), numOwnAtoms);
+            gmx::AnalysisNeighborhoodPairSearch pairSearch = search.startPairSearch(ownPos);
+            while (pairSearch.findNextPair(&pair))
+            {
+                const int i1 = pair.testIndex();
+                const int i2 = pair.refIndex();
+                // Pairs with atoms of other tiles are also found from there,
+                // so only the tile with the lower atom index adds them
+                if (localAtom[i1] < localAtom[i2] && localResidue[i1] != localResidue[i2])
+                {
+                    addSolventOverlap(pbc, maxRadius, localAtom[i1], localAtom[i2],
+                                      localResidue[i1], localResidue[i2], localX[i1], localX[i2],
+                                      localR[i1], localR[i2], &tileOverlaps[tile]);
+                }
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    std::vector<SolventOverlap> overlaps;
+    for (const auto& overlapsOfTile : tileOverlaps)
+    {
+        overlaps.insert(overlaps.end(), overlapsOfTile.begin(), overlapsOfTile.end());
+    }
+    tileOverlaps.clear();
+    std::vector<char> residueIsRemoved(tileResidueOffset[numTiles], 0);
+    resolveSolventOverlaps(&overlaps, &residueIsRemoved);
+
+    std::unique_ptr<gmx::PositionGrid> soluteGrid;
+    std::unique_ptr<gmx::PositionGrid> shellGrid;
+    if (!x_solute.empty())
+    {
+        const real maxSoluteRadius = *std::max_element(r_solute.begin(), r_solute.end());
+        soluteGrid = std::make_unique<gmx::PositionGrid>(pbc, maxRadius + maxSoluteRadius);
+        if (rshell > 0)
+        {
+            shellGrid = std::make_unique<gmx::PositionGrid>(pbc, rshell);
+        }
+        for (const RVec& xi : x_solute)
+        {
+            soluteGrid->addPosition(xi);
+            if (shellGrid)
+            {
+                shellGrid->addPosition(xi);
+            }
+        }
+    }
+
+    // Remove the residues overlapping with solvent or solute and those outside the shell
+    std::vector<std::vector<int>> survivingResidues(numTiles);
+    std::vector<int>              tileNumAtomsOverlappingSolvent(numTiles, 0);
+    std::vector<int>              tileNumAtomsOutsideShell(numTiles, 0);
+    std::vector<int>              tileNumAtomsOverlappingSolute(numTiles, 0);
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        try
+        {
+            rvec delta;
+            tileShift(tile, delta);
+            int residue = tileResidueOffset[tile];
+            for (int res : keptResiduesInTile(tile))
+            {
+                const int numAtoms = residueStart[res + 1] - residueStart[res];
+                if (residueIsRemoved[residue++])
+                {
+                    tileNumAtomsOverlappingSolvent[tile] += numAtoms;
+                    continue;
+                }
+                if (soluteGrid)
+                {
+                    bool bInShell     = !shellGrid;
+                    bool bOverlapping = false;
+                    for (int i = residueStart[res]; i < residueStart[res + 1]; i++)
+                    {
+                        RVec xi;
+                        for (int m = 0; m < DIM; ++m)
+                        {
+                            xi[m] = delta[m] + (*x)[i][m];
+                        }
+                        if (!bInShell)
+                        {
+                            bInShell = shellGrid->hasPositionWithinCutoff(xi);
+                        }
+                        if (!bOverlapping)
+                        {
+                            const real ri = (*r)[i];
+                            bOverlapping  = soluteGrid->forEachPositionWithinCutoff(
+                                    xi, [&r_solute, ri](int j, real distance2) {
+                                        return distance2 < gmx::square(r_solute[j] + ri);
+                                    });
+                        }
+                    }
+                    if (!bInShell)
+                    {
+                        tileNumAtomsOutsideShell[tile] += numAtoms;
+                        continue;
+                    }
+                    if (bOverlapping)
+                    {
+                        tileNumAtomsOverlappingSolute[tile] += numAtoms;
+                        continue;
+                    }
+                }
+                survivingResidues[tile].push_back(res);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    const auto sum = [](const std::vector<int>& values) {
+        return std::accumulate(values.begin(), values.end(), 0);
+    };
+    fprintf(stderr, "Removed %d solvent atoms due to solvent-solvent overlap\n",
+            sum(tileNumAtomsOverlappingSolvent));
+    if (shellGrid)
+    {
+        fprintf(stderr, "Removed %d solvent atoms more than %f nm from solute.\n",
+                sum(tileNumAtomsOutsideShell), rshell);
+    }
+    if (soluteGrid)
+    {
+        fprintf(stderr, "Removed %d solvent atoms due to solute-solvent overlap\n",
+                sum(tileNumAtomsOverlappingSolute));
+    }
+
+    // Build the configuration of the remaining residues in tile order
+    int numAtomsKept    = 0;
+    int numResiduesKept = 0;
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        for (int res : survivingResidues[tile])
+        {
+            numAtomsKept += residueStart[res + 1] - residueStart[res];
+            numResiduesKept++;
+        }
+    }
+    t_atoms newAtoms;
+    init_t_atoms(&newAtoms, 0, FALSE);
+    gmx::AtomsBuilder builder(&newAtoms, nullptr);
+    builder.reserve(numAtomsKept, numResiduesKept);
+    std::vector<RVec> newX;
+    std::vector<RVec> newV;
+    std::vector<real> newR;
+    newX.reserve(numAtomsKept);
+    newV.reserve(!v->empty() ? numAtomsKept : 0);
+    newR.reserve(numAtomsKept);
+    for (int tile = 0; tile < numTiles; tile++)
+    {
+        rvec delta;
+        tileShift(tile, delta);
+        for (int res : survivingResidues[tile])
+        {
+            for (int i = residueStart[res]; i < residueStart[res + 1]; i++)
+            {
+                RVec xi;
+                for (int m = 0; m < DIM; ++m)
+                {
+                    xi[m] = delta[m] + (*x)[i][m];
+                }
+                newX.push_back(xi);
+                if (!v->empty())
+                {
+                    newV.push_back((*v)[i]);
+                }
+                newR.push_back((*r)[i]);
+                builder.addAtom(*atoms, i);
+            }
+            builder.finishResidue(atoms->resinfo[atoms->atom[residueStart[res]].resind]);
+        }
+    }
+    sfree(atoms->atom);
+    sfree(atoms->atomname);
+    sfree(atoms->resinfo);
+    atoms->nr       = newAtoms.nr;
+    atoms->nres     = newAtoms.nres;
+    atoms->atom     = newAtoms.atom;
+    atoms->atomname = newAtoms.atomname;
+    atoms->resinfo  = newAtoms.resinfo;
+    std::swap(*x, newX);
+    std::swap(*v, newV);
+    std::swap(*r, newR);
+}
+
 /*! \brief
  * Removes a given number of solvent residues.
  *
@@ -614,7 +1132,8 @@ static void add_solv(const char*        filename,
                      real               defaultDistance,
                      real               scaleFactor,
                      real               rshell,
-                     int                max_sol)
+                     int                max_sol,
+                     bool               bTile)
 {
     gmx_mtop_t        topSolvent;
     std::vector<RVec> xSolvent, vSolvent;
@@ -656,6 +1175,7 @@ static void add_solv(const char*        filename,
     fprintf(stderr, "Generating solvent configuration\n");
     t_pbc pbc;
     set_pbc(&pbc, pbcType, box);
+    bool bSolventIsFiltered = false;
     if (!gmx::boxesAreEqual(boxSolvent, box))
     {
         if (TRICLINIC(boxSolvent))
@@ -666,13 +1186,32 @@ static void add_solv(const char*        filename,
         }
         /* apply pbc for solvent configuration for whole molecules */
         rm_res_pbc(atomsSolvent, &xSolvent, boxSolvent);
-        replicateSolventBox(atomsSolvent, &xSolvent, &vSolvent, &exclusionDistances_solvt, boxSolvent, box);
-        if (pbcType != PbcType::No)
+        const bool pbcAllowsTiles = (pbc.pbcType == PbcType::Xyz || pbc.pbcType == PbcType::XY);
+        if (bTile && (!pbcAllowsTiles || TRICLINIC(box)))
+        {
+            fprintf(stderr,
+                    "Note: generating the solvent in tiles is only supported for rectangular "
+                    "boxes with full or xy PBC, will not use tiles\n");
+            bTile = false;
+        }
+        if (bTile)
         {
-            removeSolventBoxOverlap(atomsSolvent, &xSolvent, &vSolvent, &exclusionDistances_solvt, pbc);
+            generateSolventInTiles(atomsSolvent, &xSolvent, &vSolvent, &exclusionDistances_solvt,
+                                   boxSolvent, pbc, *x, exclusionDistances, rshell);
+            bSolventIsFiltered = true;
+        }
+        else
+        {
+            replicateSolventBox(atomsSolvent, &xSolvent, &vSolvent, &exclusionDistances_solvt,
+                                boxSolvent, box);
+            if (pbcType != PbcType::No)
+            {
+                removeSolventBoxOverlap(atomsSolvent, &xSolvent, &vSolvent,
+                                        &exclusionDistances_solvt, pbc);
+            }
         }
     }
-    if (atoms->nr > 0)
+    if (atoms->nr > 0 && !bSolventIsFiltered)
     {
         if (rshell > 0.0)
         {
@@ -918,6 +1457,7 @@ int gmx_solvate(int argc, char* argv[])
     real              defaultDistance = 0.105, r_shell = 0, scaleFactor = 0.57;
     rvec              new_box                  = { 0.0, 0.0, 0.0 };
     gmx_bool          bReadV                   = FALSE;
+    gmx_bool          bTile                    = FALSE;
     int               max_sol                  = 0;
     int               firstSolventResidueIndex = 0;
     gmx_output_env_t* oenv;
@@ -939,6 +1479,12 @@ int gmx_solvate(int argc, char* argv[])
           "Maximum number of solvent molecules to add if they fit in the box. If zero (default) "
           "this is ignored" },
         { "-vel", FALSE, etBOOL, { &bReadV }, "Keep velocities from input solute and solvent" },
+        { "-tile",
+          FALSE,
+          etBOOL,
+          { &bTile },
+          "Generate and filter the solvent per copy of the solvent box in parallel, which uses "
+          "much less memory for large boxes. The output is the same as without this option" },
     };
 
     if (!parse_common_args(&argc, argv, 0, NFILE, fnm, asize(pa), pa, asize(desc), desc,
@@ -1016,7 +1562,7 @@ int gmx_solvate(int argc, char* argv[])
     }
 
     add_solv(solventFileName, atoms, &top.symtab, &x, &v, pbcTypeForOutput, box, &aps,
-             defaultDistance, scaleFactor, r_shell, max_sol);
+             defaultDistance, scaleFactor, r_shell, max_sol, bTile);
 
     /* write new configuration 1 to file confout */
     confout = ftp2fn(efSTO, NFILE, fnm);
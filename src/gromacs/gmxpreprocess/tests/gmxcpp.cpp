@@ -0,0 +1,176 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the topology preprocessor.
+ *
+ * \ingroup module_gmxpreprocess
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxpreprocess/gmxcpp.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/utility/cstringutil.h"
+#include "gromacs/utility/textwriter.h"
+
+#include "testutils/testfilemanager.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+class GmxCppTest : public ::testing::Test
+{
+public:
+    /*! \brief Preprocesses \p fileContents with command line options \p options
+     *
+     * \returns The lines of the preprocessed file.
+     */
+    std::vector<std::string> preprocess(const std::string&       fileContents,
+                                        std::vector<std::string> options = {})
+    {
+        std::string filename = fileManager_.getTemporaryFilePath("input.top");
+        TextWriter::writeFileFromString(filename, fileContents);
+
+        std::vector<char*> cppopts;
+        for (auto& option : options)
+        {
+            cppopts.push_back(&option[0]);
+        }
+        cppopts.push_back(nullptr);
+
+        gmx_cpp_t handle;
+        EXPECT_EQ(eCPP_OK, cpp_open_file(filename.c_str(), &handle, cppopts.data()));
+        std::vector<std::string> lines;
+        char                     buf[STRLEN];
+        int                      status;
+        while ((status = cpp_read_line(&handle, STRLEN, buf)) == eCPP_OK)
+        {
+            lines.emplace_back(buf);
+        }
+        EXPECT_EQ(eCPP_EOF, status);
+        unusedDefinesWarning_ = checkAndWarnForUnusedDefines(*handle);
+        cpp_done(handle);
+
+        return lines;
+    }
+
+    //! Manages the temporary input file.
+    TestFileManager fileManager_;
+    //! Warning about unused command line defines of the last run.
+    std::string unusedDefinesWarning_;
+};
+
+TEST_F(GmxCppTest, ReplacesWholeWordsOnly)
+{
+    auto lines = preprocess("#define gb_1 0.1000 1.5700e+07\ngb_1 gb_10 xgb_1 gb_1;gb_1\n");
+
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ("0.1000 1.5700e+07 gb_10 xgb_1 0.1000 1.5700e+07;0.1000 1.5700e+07", lines[0]);
+}
+
+TEST_F(GmxCppTest, ReplacesDefinesInOrderOfDefinition)
+{
+    auto lines = preprocess(
+            "#define A B\n"
+            "#define B 3\n"
+            "#define D C\n"
+            "A B C D\n");
+
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ("3 3 C C", lines[0]);
+
+    lines = preprocess(
+            "#define B 3\n"
+            "#define A B\n"
+            "A B\n");
+
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ("B 3", lines[0]);
+}
+
+TEST_F(GmxCppTest, DoesNotReplaceDefineWithinItsOwnValue)
+{
+    auto lines = preprocess("#define A A B\nA\n");
+
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ("A B", lines[0]);
+}
+
+TEST_F(GmxCppTest, HandlesIfdefAndUndef)
+{
+    auto lines = preprocess(
+            "#define X 1\n"
+            "#ifdef X\n"
+            "in X\n"
+            "#else\n"
+            "out\n"
+            "#endif\n"
+            "#undef X\n"
+            "#ifndef X\n"
+            "X\n"
+            "#endif\n"
+            "#define X 2\n"
+            "X\n");
+
+    ASSERT_EQ(3, lines.size());
+    EXPECT_EQ("in 1", lines[0]);
+    EXPECT_EQ("X", lines[1]);
+    EXPECT_EQ("2", lines[2]);
+}
+
+TEST_F(GmxCppTest, UsesCommandLineDefines)
+{
+    auto lines = preprocess("#ifdef POSRES\nfc FC\n#endif\n",
+                            { "-DPOSRES", "-DFC=1000", "-DUNUSED" });
+
+    ASSERT_EQ(1, lines.size());
+    EXPECT_EQ("fc 1000", lines[0]);
+    EXPECT_NE(std::string::npos, unusedDefinesWarning_.find("UNUSED"));
+    EXPECT_EQ(std::string::npos, unusedDefinesWarning_.find("POSRES"));
+    EXPECT_EQ(std::string::npos, unusedDefinesWarning_.find("FC"));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,143 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for generating exclusions from bonds.
+ *
+ * \ingroup module_preprocessing
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxpreprocess/gpp_nextnb.h"
+
+#include <gtest/gtest.h>
+
+#include "gromacs/gmxpreprocess/grompp_impl.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/arrayref.h"
+#include "gromacs/utility/listoflists.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Adds a bond between atoms \p ai and \p aj to \p interactions
+void addBond(ArrayRef<InteractionsOfType> interactions, int ai, int aj)
+{
+    const int atoms[] = { ai, aj };
+    interactions[F_BONDS].interactionTypes.emplace_back(InteractionOfType(atoms, {}));
+}
+
+//! Returns interactions for a linear chain of \p numAtoms atoms
+std::vector<InteractionsOfType> makeLinearChain(int numAtoms)
+{
+    std::vector<InteractionsOfType> interactions(F_NRE);
+    for (int a = 0; a + 1 < numAtoms; a++)
+    {
+        addBond(interactions, a, a + 1);
+    }
+    return interactions;
+}
+
+TEST(GenerateExclusionsTest, ExcludesOnlySelfWithZeroExclusionDistance)
+{
+    auto             interactions = makeLinearChain(4);
+    ListOfLists<int> exclusions;
+    generate_excl(0, 4, interactions, &exclusions);
+    ASSERT_EQ(exclusions.ssize(), 4);
+    for (int a = 0; a < 4; a++)
+    {
+        EXPECT_EQ(exclusions[a].size(), 1);
+        EXPECT_EQ(exclusions[a][0], a);
+    }
+}
+
+TEST(GenerateExclusionsTest, WorksForLinearChain)
+{
+    auto             interactions = makeLinearChain(6);
+    ListOfLists<int> exclusions;
+    generate_excl(2, 6, interactions, &exclusions);
+    ASSERT_EQ(exclusions.ssize(), 6);
+    const std::vector<int> firstAtom = { 0, 1, 2 };
+    const std::vector<int> thirdAtom = { 0, 1, 2, 3, 4 };
+    const std::vector<int> lastAtom  = { 3, 4, 5 };
+    EXPECT_EQ(std::vector<int>(exclusions[0].begin(), exclusions[0].end()), firstAtom);
+    EXPECT_EQ(std::vector<int>(exclusions[2].begin(), exclusions[2].end()), thirdAtom);
+    EXPECT_EQ(std::vector<int>(exclusions[5].begin(), exclusions[5].end()), lastAtom);
+}
+
+TEST(GenerateExclusionsTest, ExcludesRingAtomsOnce)
+{
+    auto interactions = makeLinearChain(5);
+    addBond(interactions, 4, 0);
+    // A duplicate bond should not give duplicate exclusions
+    addBond(interactions, 1, 0);
+    ListOfLists<int> exclusions;
+    generate_excl(3, 5, interactions, &exclusions);
+    for (int a = 0; a < 5; a++)
+    {
+        const std::vector<int> allAtoms = { 0, 1, 2, 3, 4 };
+        EXPECT_EQ(std::vector<int>(exclusions[a].begin(), exclusions[a].end()), allAtoms);
+    }
+}
+
+TEST(GenerateExclusionsTest, ThreadingDoesNotChangeResult)
+{
+    // A branched chain large enough to be split over threads
+    const int numAtoms     = 10000;
+    auto      interactions = makeLinearChain(numAtoms);
+    for (int a = 0; a + 7 < numAtoms; a += 5)
+    {
+        addBond(interactions, a, a + 7);
+    }
+    ListOfLists<int> serialExclusions;
+    generate_excl(3, numAtoms, interactions, &serialExclusions, 1);
+    ListOfLists<int> threadedExclusions;
+    generate_excl(3, numAtoms, interactions, &threadedExclusions, 4);
+
+    ASSERT_EQ(threadedExclusions.ssize(), serialExclusions.ssize());
+    for (int a = 0; a < numAtoms; a++)
+    {
+        EXPECT_EQ(std::vector<int>(threadedExclusions[a].begin(), threadedExclusions[a].end()),
+                  std::vector<int>(serialExclusions[a].begin(), serialExclusions[a].end()));
+    }
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
@@ -0,0 +1,183 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for gmx::PositionGrid.
+ *
+ * \ingroup module_gmxpreprocess
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxpreprocess/positiongrid.h"
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns \p count random positions, partly outside the unit cell of \p box
+std::vector<RVec> randomPositions(const matrix box, int count, DefaultRandomEngine* rng)
+{
+    UniformRealDistribution<real> dist(-0.5, 1.5);
+    std::vector<RVec>             positions(count);
+    for (RVec& x : positions)
+    {
+        x = { 0, 0, 0 };
+        for (int d = 0; d < DIM; d++)
+        {
+            const real s = dist(*rng);
+            for (int e = 0; e < DIM; e++)
+            {
+                x[e] += s * box[d][e];
+            }
+        }
+    }
+    return positions;
+}
+
+//! Checks that the grid finds the same pairs as a brute force search
+void checkAgainstBruteForce(PbcType pbcType, const matrix box, real cutoff)
+{
+    t_pbc pbc;
+    set_pbc(&pbc, pbcType, box);
+
+    DefaultRandomEngine     rng(1234);
+    const std::vector<RVec> positions     = randomPositions(box, 200, &rng);
+    const std::vector<RVec> testPositions = randomPositions(box, 50, &rng);
+
+    PositionGrid grid(pbc, cutoff);
+    for (const RVec& x : positions)
+    {
+        grid.addPosition(x);
+    }
+    ASSERT_EQ(grid.numPositions(), int(positions.size()));
+
+    for (const RVec& x : testPositions)
+    {
+        std::vector<int> expected;
+        for (size_t i = 0; i < positions.size(); i++)
+        {
+            rvec dx;
+            pbc_dx(&pbc, x, positions[i], dx);
+            if (norm2(dx) < cutoff * cutoff)
+            {
+                expected.push_back(i);
+            }
+        }
+        std::vector<bool> found(positions.size(), false);
+        int               numFound = 0;
+        grid.forEachPositionWithinCutoff(x, [&found, &numFound](int index, real /*distance2*/) {
+            EXPECT_FALSE(found[index]) << "Positions should be found only once";
+            found[index] = true;
+            numFound++;
+            return false;
+        });
+        EXPECT_EQ(numFound, int(expected.size()));
+        for (int i : expected)
+        {
+            EXPECT_TRUE(found[i]);
+        }
+        EXPECT_EQ(grid.hasPositionWithinCutoff(x), !expected.empty());
+    }
+}
+
+TEST(PositionGridTest, FindsPairsInRectangularBox)
+{
+    const matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+    checkAgainstBruteForce(PbcType::Xyz, box, 0.7);
+}
+
+TEST(PositionGridTest, FindsPairsInTriclinicBox)
+{
+    const matrix box = { { 4, 0, 0 }, { 1.5, 3.5, 0 }, { -1, 1.2, 3 } };
+    checkAgainstBruteForce(PbcType::Xyz, box, 0.7);
+}
+
+TEST(PositionGridTest, FindsPairsWithFewCells)
+{
+    const matrix box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    checkAgainstBruteForce(PbcType::Xyz, box, 1.2);
+}
+
+TEST(PositionGridTest, FindsPairsWithPbcXY)
+{
+    const matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+    checkAgainstBruteForce(PbcType::XY, box, 0.7);
+}
+
+TEST(PositionGridTest, FindsPairsWithPbcXYAndZeroBoxHeight)
+{
+    const matrix box = { { 3, 0, 0 }, { 1, 4, 0 }, { 0, 0, 0 } };
+    checkAgainstBruteForce(PbcType::XY, box, 0.7);
+}
+
+TEST(PositionGridTest, FindsPairsWithoutPbc)
+{
+    const matrix box = { { 3, 0, 0 }, { 0, 4, 0 }, { 0, 0, 5 } };
+    checkAgainstBruteForce(PbcType::No, box, 0.7);
+}
+
+TEST(PositionGridTest, StopsWhenRequested)
+{
+    const matrix box = { { 3, 0, 0 }, { 0, 3, 0 }, { 0, 0, 3 } };
+    t_pbc        pbc;
+    set_pbc(&pbc, PbcType::Xyz, box);
+    PositionGrid grid(pbc, 0.5);
+    grid.addPosition({ 1, 1, 1 });
+    grid.addPosition({ 1.1, 1, 1 });
+    int numCalls = 0;
+    EXPECT_TRUE(grid.forEachPositionWithinCutoff({ 1, 1.1, 1 }, [&numCalls](int, real) {
+        numCalls++;
+        return true;
+    }));
+    EXPECT_EQ(numCalls, 1);
+    EXPECT_FALSE(grid.hasPositionWithinCutoff({ 2.5, 2.5, 2.5 }));
+    // Across the periodic boundary
+    grid.addPosition({ 0.1, 2.5, 2.5 });
+    EXPECT_TRUE(grid.hasPositionWithinCutoff({ 2.9, 2.5, 2.5 }));
+}
+
+} // namespace
+} // namespace test
+} // namespace gmx
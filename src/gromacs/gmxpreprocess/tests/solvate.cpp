@@ -122,4 +122,65 @@ TEST_F(SolvateTest, update_Topology_Works)
     runTest(CommandLine(cmdline));
 }
 
+//! Test fixture that checks that -tile generates the same solvent
+class SolvateTileTest : public gmx::test::CommandLineTestBase
+{
+public:
+    void runTest(const CommandLine& args)
+    {
+        std::string outputFileNames[2];
+        for (int useTiles = 0; useTiles < 2; useTiles++)
+        {
+            CommandLine cmdline(args);
+            outputFileNames[useTiles] =
+                    fileManager().getTemporaryFilePath(useTiles ? "tiles.gro" : "default.gro");
+            cmdline.addOption("-o", outputFileNames[useTiles]);
+            if (useTiles)
+            {
+                cmdline.append("-tile");
+            }
+            ASSERT_EQ(0, gmx_solvate(cmdline.argc(), cmdline.argv()));
+        }
+        EXPECT_EQ(gmx::TextReader::readFileToString(outputFileNames[0]),
+                  gmx::TextReader::readFileToString(outputFileNames[1]));
+    }
+};
+
+TEST_F(SolvateTileTest, MatchesDefaultWithNonCubicBox)
+{
+    const char* const cmdline[] = { "solvate", "-cs", "-box", "3.3", "2.1", "4.4" };
+    runTest(CommandLine(cmdline));
+}
+
+TEST_F(SolvateTileTest, MatchesDefaultWithScale)
+{
+    const char* const cmdline[] = { "solvate", "-cs", "-box", "2.5", "3", "3.5", "-scale", "1.0" };
+    runTest(CommandLine(cmdline));
+}
+
+TEST_F(SolvateTileTest, MatchesDefaultWithSoluteAndRadius)
+{
+    const char* const cmdline[] = { "solvate", "-cs", "-box", "3", "2.7", "2.9", "-radius", "0.2" };
+    CommandLine       args(cmdline);
+    args.addOption("-cp", fileManager().getInputFilePath("spc-and-methanol.gro"));
+    runTest(args);
+}
+
+TEST_F(SolvateTileTest, MatchesDefaultWithShell)
+{
+    const char* const cmdline[] = { "solvate", "-cs" };
+    CommandLine       args(cmdline);
+    args.addOption("-cp", fileManager().getInputFilePath("spc-and-methanol.gro"));
+    args.addOption("-shell", 1.0);
+    runTest(args);
+}
+
+TEST_F(SolvateTileTest, MatchesDefaultWithMixedSolvent)
+{
+    const char* const cmdline[] = { "solvate", "-box", "3.3", "2.1", "2.9" };
+    CommandLine       args(cmdline);
+    args.addOption("-cs", fileManager().getInputFilePath("mixed_solvent.gro"));
+    runTest(args);
+}
+
 } // namespace
@@ -0,0 +1,184 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for assigning default parameters to interactions in toppush.
+ *
+ * \ingroup module_gmxpreprocess
+ */
+#include "gmxpre.h"
+
+#include "gromacs/gmxpreprocess/toppush.h"
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/fileio/warninp.h"
+#include "gromacs/gmxpreprocess/gpp_atomtype.h"
+#include "gromacs/gmxpreprocess/gpp_bond_atomtype.h"
+#include "gromacs/gmxpreprocess/grompp_impl.h"
+#include "gromacs/gmxpreprocess/topdirs.h"
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/topology/symtab.h"
+#include "gromacs/utility/stringutil.h"
+
+namespace gmx
+{
+namespace
+{
+
+class DefaultDihedralParametersTest : public ::testing::Test
+{
+public:
+    DefaultDihedralParametersTest() : wi_(init_warning(FALSE, 0))
+    {
+        open_symtab(&symtab_);
+        molecule_.initMolInfo();
+        addAtomType("A");
+        addAtomType("B");
+    }
+
+    ~DefaultDihedralParametersTest() override
+    {
+        molecule_.fullCleanUp();
+        free_nbparam(nbparam_, atypes_.size());
+        free_warning(wi_);
+        done_symtab(&symtab_);
+    }
+
+    //! Adds a Lennard-Jones atom type \p name, which is also its bonded type.
+    void addAtomType(const char* name)
+    {
+        std::string line = formatString("%s 12.0 0.0 A 0.3 0.5", name);
+        push_at(&symtab_, &atypes_, &bondAtomTypes_, &line[0], F_LJ, &nbparam_, nullptr, wi_);
+    }
+
+    //! Adds a proper dihedral type with force constant \p forceConstant.
+    void addDihedralType(const char* types, real forceConstant)
+    {
+        std::string line = formatString("%s 1 0.0 %g 1", types, forceConstant);
+        push_dihedraltype(Directive::d_dihedraltypes, forceField_, &bondAtomTypes_, &line[0], wi_);
+    }
+
+    /*! \brief Adds four atoms with the given atom types, a dihedral
+     * between them, and returns the force constant assigned to it.
+     */
+    real forceConstantOfDihedral(const std::array<const char*, 4>& types)
+    {
+        for (const char* type : types)
+        {
+            const int   atom = molecule_.atoms.nr + 1;
+            std::string line = formatString("%d %s 1 RES %s%d 1 0.0 12.0", atom, type, type, atom);
+            push_atom(&symtab_, &molecule_.atoms, &atypes_, &line[0], wi_);
+        }
+        const int   first = molecule_.atoms.nr - 3;
+        std::string line  = formatString("%d %d %d %d 1", first, first + 1, first + 2, first + 3);
+        bool        warnedCopyAToB = false;
+        push_bond(Directive::d_dihedrals, forceField_, molecule_.interactions, &molecule_.atoms,
+                  &atypes_, &line[0], TRUE, FALSE, 1.0, FALSE, &warnedCopyAToB, wi_);
+
+        const InteractionsOfType& dihedrals = molecule_.interactions[F_PDIHS];
+        EXPECT_EQ(dihedrals.size(), 1U);
+        return dihedrals.interactionTypes.back().c1();
+    }
+
+protected:
+    t_symtab                              symtab_;
+    warninp_t                             wi_;
+    PreprocessingAtomTypes                atypes_;
+    PreprocessingBondAtomType             bondAtomTypes_;
+    t_nbparam**                           nbparam_ = nullptr;
+    std::array<InteractionsOfType, F_NRE> forceField_;
+    MoleculeInformation                   molecule_;
+};
+
+TEST_F(DefaultDihedralParametersTest, ExactMatchBeatsEarlierWildcardMatch)
+{
+    addDihedralType("X A B X", 1);
+    addDihedralType("A A B B", 2);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 2);
+}
+
+TEST_F(DefaultDihedralParametersTest, MoreSpecificWildcardMatchWins)
+{
+    addDihedralType("X A B X", 1);
+    addDihedralType("X A B B", 3);
+    addDihedralType("B A B B", 4);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 3);
+}
+
+TEST_F(DefaultDihedralParametersTest, FirstDefinedWinsAmongEqualMatches)
+{
+    addDihedralType("X A B B", 5);
+    addDihedralType("A A B X", 6);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 5);
+}
+
+TEST_F(DefaultDihedralParametersTest, FirstDefinedWinsAmongEqualMatchesInOtherOrder)
+{
+    addDihedralType("A A B X", 6);
+    addDihedralType("X A B B", 5);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 6);
+}
+
+TEST_F(DefaultDihedralParametersTest, TypesAddedAfterLookupAreFound)
+{
+    addDihedralType("X A B X", 1);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 1);
+    addDihedralType("B B A A", 7);
+    molecule_.interactions[F_PDIHS].clear();
+    EXPECT_EQ(forceConstantOfDihedral({ "B", "B", "A", "A" }), 7);
+}
+
+TEST_F(DefaultDihedralParametersTest, LookupIsRebuiltAfterClearingTypes)
+{
+    addDihedralType("A A B B", 1);
+    addDihedralType("X A B X", 2);
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 1);
+    // Refill the types with more entries than before, so a lookup
+    // that is not invalidated would return the wrong entries
+    forceField_[F_PDIHS].clear();
+    addDihedralType("B B B B", 4);
+    addDihedralType("X A B X", 3);
+    addDihedralType("A A A A", 5);
+    molecule_.interactions[F_PDIHS].clear();
+    EXPECT_EQ(forceConstantOfDihedral({ "A", "A", "B", "B" }), 3);
+}
+
+} // namespace
+} // namespace gmx
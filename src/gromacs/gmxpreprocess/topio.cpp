@@ -78,8 +78,10 @@
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/futil.h"
 #include "gromacs/utility/gmxassert.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/logger.h"
 #include "gromacs/utility/pleasecite.h"
 #include "gromacs/utility/smalloc.h"
@@ -104,7 +106,7 @@ static void gen_pairs(const InteractionsOfType& nbs, InteractionsOfType* pairs,
     }
 
     fprintf(stderr, "Generating 1-4 interactions: fudge = %g\n", fudge);
-    pairs->interactionTypes.clear();
+    pairs->clear();
     int                             i = 0;
     std::array<int, 2>              atomNumbers;
     std::array<real, MAXFORCEPARAM> forceParam = { NOTSET };
@@ -365,6 +367,14 @@ static void make_atoms_sys(gmx::ArrayRef<const gmx_molblock_t>      molblock,
 }
 
 
+//! Returns whether \p mi is the molecule type to couple, as selected in \p opts.
+static bool isCoupledMoleculeType(const MoleculeInformation& mi, const t_gromppopts* opts)
+{
+    return (opts->couple_moltype != nullptr
+            && (gmx_strcasecmp("system", opts->couple_moltype) == 0
+                || strcmp(*(mi.name), opts->couple_moltype) == 0));
+}
+
 static char** read_topol(const char*                           infile,
                          const char*                           outfile,
                          const char*                           define,
@@ -438,6 +448,8 @@ static char** read_topol(const char*                           infile,
     nbparam = nullptr;              /* The temporary non-bonded matrix */
     pair    = nullptr;              /* The temporary pair interaction matrix */
     std::vector<std::vector<gmx::ExclusionBlock>> exclusionBlocks;
+    /* Molecule types in order of first use, processed after reading the topology */
+    std::vector<int> usedMoleculeTypes;
     nb_funct = F_LJ;
 
     *reppow = 12.0; /* Default value for repulsion power     */
@@ -812,9 +824,7 @@ static char** read_topol(const char*                           infile,
                             molblock->back().type = whichmol;
                             molblock->back().nmol = nrcopies;
 
-                            bCouple = (opts->couple_moltype != nullptr
-                                       && (gmx_strcasecmp("system", opts->couple_moltype) == 0
-                                           || strcmp(*(mi0->name), opts->couple_moltype) == 0));
+                            bCouple = isCoupledMoleculeType(*mi0, opts);
                             if (bCouple)
                             {
                                 nmol_couple += nrcopies;
@@ -832,17 +842,7 @@ static char** read_topol(const char*                           infile,
                             sum_q(&mi0->atoms, nrcopies, &qt, &qBt);
                             if (!mi0->bProcessed)
                             {
-                                generate_excl(mi0->nrexcl, mi0->atoms.nr, mi0->interactions, &(mi0->excls));
-                                gmx::mergeExclusions(&(mi0->excls), exclusionBlocks[whichmol]);
-                                make_shake(mi0->interactions, &mi0->atoms, opts->nshake, logger);
-
-                                if (bCouple)
-                                {
-                                    convert_moltype_couple(mi0, dcatt, *fudgeQQ, opts->couple_lam0,
-                                                           opts->couple_lam1, opts->bCoupleIntra,
-                                                           nb_funct, &(interactions[nb_funct]), wi);
-                                }
-                                stupid_fill_block(&mi0->mols, mi0->atoms.nr, TRUE);
+                                usedMoleculeTypes.push_back(whichmol);
                                 mi0->bProcessed = TRUE;
                             }
                             break;
@@ -860,6 +860,44 @@ static char** read_topol(const char*                           infile,
         }
     } while (!done);
 
+    /* Generate the exclusions of all molecule types in use. The molecule
+     * types are independent, so we can process them in parallel. With fewer
+     * molecule types than threads, e.g. for a single large polymer, we instead
+     * use the threads for the atoms within each molecule type.
+     */
+    const int  numThreads          = gmx_omp_get_max_threads();
+    const bool parallelOverTypes   = gmx::ssize(usedMoleculeTypes) >= numThreads;
+    const int  numThreadsOverTypes = parallelOverTypes ? numThreads : 1;
+    const int  numThreadsPerType   = parallelOverTypes ? 1 : numThreads;
+#pragma omp parallel for num_threads(numThreadsOverTypes) schedule(dynamic)
+    for (gmx::index i = 0; i < gmx::ssize(usedMoleculeTypes); i++)
+    {
+        try
+        {
+            const int            moleculeType = usedMoleculeTypes[i];
+            MoleculeInformation* mi           = &(*molinfo)[moleculeType];
+            generate_excl(mi->nrexcl, mi->atoms.nr, mi->interactions, &(mi->excls),
+                          numThreadsPerType);
+            gmx::mergeExclusions(&(mi->excls), exclusionBlocks[moleculeType]);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+    /* Constraint generation and decoupling can produce log output and
+     * warnings, so we do these in order.
+     */
+    for (int moleculeType : usedMoleculeTypes)
+    {
+        MoleculeInformation* mi = &(*molinfo)[moleculeType];
+        make_shake(mi->interactions, &mi->atoms, opts->nshake, logger);
+
+        if (isCoupledMoleculeType(*mi, opts))
+        {
+            convert_moltype_couple(mi, dcatt, *fudgeQQ, opts->couple_lam0, opts->couple_lam1,
+                                   opts->bCoupleIntra, nb_funct, &(interactions[nb_funct]), wi);
+        }
+        stupid_fill_block(&mi->mols, mi->atoms.nr, TRUE);
+    }
+
     // Check that all strings defined with -D were used when processing topology
     std::string unusedDefineWarning = checkAndWarnForUnusedDefines(*handle);
     if (!unusedDefineWarning.empty())
@@ -45,7 +45,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <array>
 #include <string>
+#include <vector>
 
 #include "gromacs/fileio/warninp.h"
 #include "gromacs/gmxpreprocess/gpp_atomtype.h"
@@ -79,7 +81,7 @@ void generate_nbparams(int                     comb,
     /* Lean mean shortcuts */
     nr   = atypes->size();
     nrfp = NRFP(ftype);
-    interactions->interactionTypes.clear();
+    interactions->clear();
 
     std::array<real, MAXFORCEPARAM> forceParam = { NOTSET };
     /* Fill the matrix with force parameters */
@@ -1484,37 +1486,50 @@ void push_molt(t_symtab* symtab, std::vector<MoleculeInformation>* mol, char* li
     mol->back().excl_set = false;
 }
 
-static bool findIfAllNBAtomsMatch(gmx::ArrayRef<const int> atomsFromParameterArray,
-                                  gmx::ArrayRef<const int> atomsFromCurrentParameter,
-                                  const t_atoms*           at,
-                                  bool                     bB)
+//! Returns the key for looking up interaction types with atom types \p types.
+static InteractionTypeKey interactionTypeKey(gmx::ArrayRef<const int> types)
 {
-    if (atomsFromParameterArray.size() != atomsFromCurrentParameter.size())
-    {
-        return false;
-    }
-    else if (bB)
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (at->atom[atomsFromCurrentParameter[i]].typeB != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-    else
+    GMX_ASSERT(types.ssize() <= MAXATOMLIST, "Can not have more atoms than MAXATOMLIST");
+    InteractionTypeKey key;
+    key.fill(NOTSET);
+    key[0] = types.ssize();
+    std::copy(types.begin(), types.end(), key.begin() + 1);
+    return key;
+}
+
+/*! \brief Returns the lookup index of \p bt by atom types.
+ *
+ * Adds the interaction types appended since the previous call to the
+ * index. Only the first entry with a given set of atom types is stored,
+ * so lookups return the same entry as a linear search would.
+ */
+static const InteractionTypeIndex& updateInteractionTypeIndex(InteractionsOfType* bt)
+{
+    GMX_ASSERT(bt->numIndexedInteractionTypes <= bt->size(),
+               "Interaction types can only be removed through clear() or when followed by "
+               "invalidateTypeIndices()");
+    for (size_t i = bt->numIndexedInteractionTypes; i < bt->size(); i++)
     {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (at->atom[atomsFromCurrentParameter[i]].type != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
+        bt->interactionTypeIndex.emplace(interactionTypeKey(bt->interactionTypes[i].atoms()),
+                                         static_cast<int>(i));
     }
+    bt->numIndexedInteractionTypes = bt->size();
+
+    return bt->interactionTypeIndex;
+}
+
+/*! \brief Returns the first interaction type in \p bt with atom types \p types.
+ *
+ * Returns bt->interactionTypes.end() when there is no such type.
+ */
+static std::vector<InteractionOfType>::iterator findInteractionTypeWithAtomTypes(InteractionsOfType* bt,
+                                                                                 gmx::ArrayRef<const int> types)
+{
+    const InteractionTypeIndex& index = updateInteractionTypeIndex(bt);
+    const auto                  entry = index.find(interactionTypeKey(types));
+
+    return (entry != index.end()) ? bt->interactionTypes.begin() + entry->second
+                                  : bt->interactionTypes.end();
 }
 
 static bool default_nb_params(int                               ftype,
@@ -1569,15 +1584,15 @@ static bool default_nb_params(int                               ftype,
         }
     }
 
-    gmx::ArrayRef<const int> paramAtoms = p->atoms();
     /* Search explicitly if we didnt find it */
     if (!bFound)
     {
-        auto foundParameter =
-                std::find_if(bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                             [&paramAtoms, &at, &bB](const auto& param) {
-                                 return findIfAllNBAtomsMatch(param.atoms(), paramAtoms, at, bB);
-                             });
+        std::vector<int> types;
+        for (int atom : p->atoms())
+        {
+            types.push_back(bB ? at->atom[atom].typeB : at->atom[atom].type);
+        }
+        auto foundParameter = findInteractionTypeWithAtomTypes(&bt[ftype], types);
         if (foundParameter != bt[ftype].interactionTypes.end())
         {
             bFound = true;
@@ -1633,28 +1648,34 @@ static bool default_cmap_params(gmx::ArrayRef<InteractionsOfType> bondtype,
     nparam_found = 0;
     ct           = 0;
 
+    /* Add the cmap types read since the last call to the lookup index */
+    InteractionsOfType* cmapTypes = &bondtype[F_CMAP];
+    GMX_ASSERT(cmapTypes->numIndexedCmapAtomTypes <= cmapTypes->cmapAtomTypes.size(),
+               "CMAP atom types can only be removed when followed by invalidateTypeIndices()");
+    for (int i = static_cast<int>(cmapTypes->numIndexedCmapAtomTypes); i + 6 <= cmapTypes->nct();
+         i += 6)
+    {
+        gmx::ArrayRef<const int> types =
+                gmx::constArrayRefFromArray(cmapTypes->cmapAtomTypes.data() + i, 5);
+        cmapTypes->cmapTypeIndex.emplace(interactionTypeKey(types), i);
+        cmapTypes->numIndexedCmapAtomTypes = i + 6;
+    }
+
     /* Match the current cmap angle against the list of cmap_types */
-    for (int i = 0; i < bondtype[F_CMAP].nct() && !bFound; i += 6)
+    if (!bB)
     {
-        if (bB) {}
-        else
+        std::vector<int> types;
+        for (int atom : p->atoms())
         {
-            if ((atypes->bondAtomTypeFromAtomType(at->atom[p->ai()].type)
-                 == bondtype[F_CMAP].cmapAtomTypes[i])
-                && (atypes->bondAtomTypeFromAtomType(at->atom[p->aj()].type)
-                    == bondtype[F_CMAP].cmapAtomTypes[i + 1])
-                && (atypes->bondAtomTypeFromAtomType(at->atom[p->ak()].type)
-                    == bondtype[F_CMAP].cmapAtomTypes[i + 2])
-                && (atypes->bondAtomTypeFromAtomType(at->atom[p->al()].type)
-                    == bondtype[F_CMAP].cmapAtomTypes[i + 3])
-                && (atypes->bondAtomTypeFromAtomType(at->atom[p->am()].type)
-                    == bondtype[F_CMAP].cmapAtomTypes[i + 4]))
-            {
-                /* Found cmap torsion */
-                bFound       = true;
-                ct           = bondtype[F_CMAP].cmapAtomTypes[i + 5];
-                nparam_found = 1;
-            }
+            types.push_back(atypes->bondAtomTypeFromAtomType(at->atom[atom].type));
+        }
+        const auto entry = cmapTypes->cmapTypeIndex.find(interactionTypeKey(types));
+        if (entry != cmapTypes->cmapTypeIndex.end())
+        {
+            /* Found cmap torsion */
+            bFound       = true;
+            ct           = cmapTypes->cmapAtomTypes[entry->second + 5];
+            nparam_found = 1;
         }
     }
 
@@ -1672,86 +1693,6 @@ static bool default_cmap_params(gmx::ArrayRef<InteractionsOfType> bondtype,
     return bFound;
 }
 
-/* Returns the number of exact atom type matches, i.e. non wild-card matches,
- * returns -1 when there are no matches at all.
- */
-static int natom_match(const InteractionOfType&      pi,
-                       int                           type_i,
-                       int                           type_j,
-                       int                           type_k,
-                       int                           type_l,
-                       const PreprocessingAtomTypes* atypes)
-{
-    if ((pi.ai() == -1 || atypes->bondAtomTypeFromAtomType(type_i) == pi.ai())
-        && (pi.aj() == -1 || atypes->bondAtomTypeFromAtomType(type_j) == pi.aj())
-        && (pi.ak() == -1 || atypes->bondAtomTypeFromAtomType(type_k) == pi.ak())
-        && (pi.al() == -1 || atypes->bondAtomTypeFromAtomType(type_l) == pi.al()))
-    {
-        return (pi.ai() == -1 ? 0 : 1) + (pi.aj() == -1 ? 0 : 1) + (pi.ak() == -1 ? 0 : 1)
-               + (pi.al() == -1 ? 0 : 1);
-    }
-    else
-    {
-        return -1;
-    }
-}
-
-static int findNumberOfDihedralAtomMatches(const InteractionOfType& currentParamFromParameterArray,
-                                           const InteractionOfType& parameterToAdd,
-                                           const t_atoms*           at,
-                                           const PreprocessingAtomTypes* atypes,
-                                           bool                          bB)
-{
-    if (bB)
-    {
-        return natom_match(currentParamFromParameterArray, at->atom[parameterToAdd.ai()].typeB,
-                           at->atom[parameterToAdd.aj()].typeB, at->atom[parameterToAdd.ak()].typeB,
-                           at->atom[parameterToAdd.al()].typeB, atypes);
-    }
-    else
-    {
-        return natom_match(currentParamFromParameterArray, at->atom[parameterToAdd.ai()].type,
-                           at->atom[parameterToAdd.aj()].type, at->atom[parameterToAdd.ak()].type,
-                           at->atom[parameterToAdd.al()].type, atypes);
-    }
-}
-
-static bool findIfAllParameterAtomsMatch(gmx::ArrayRef<const int>      atomsFromParameterArray,
-                                         gmx::ArrayRef<const int>      atomsFromCurrentParameter,
-                                         const t_atoms*                at,
-                                         const PreprocessingAtomTypes* atypes,
-                                         bool                          bB)
-{
-    if (atomsFromParameterArray.size() != atomsFromCurrentParameter.size())
-    {
-        return false;
-    }
-    else if (bB)
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (atypes->bondAtomTypeFromAtomType(at->atom[atomsFromCurrentParameter[i]].typeB)
-                != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-    else
-    {
-        for (gmx::index i = 0; i < atomsFromCurrentParameter.ssize(); i++)
-        {
-            if (atypes->bondAtomTypeFromAtomType(at->atom[atomsFromCurrentParameter[i]].type)
-                != atomsFromParameterArray[i])
-            {
-                return false;
-            }
-        }
-        return true;
-    }
-}
-
 static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ftype,
                                                                           gmx::ArrayRef<InteractionsOfType> bt,
                                                                           t_atoms* at,
@@ -1777,22 +1718,36 @@ static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ft
 
         /* For dihedrals we allow wildcards. We choose the first type
          * that has the most real matches, i.e. non-wildcard matches.
+         * Each type can only match one combination of our atom types
+         * and wildcards, so we look up all 16 combinations.
          */
-        auto prevPos = bt[ftype].interactionTypes.end();
-        auto pos     = bt[ftype].interactionTypes.begin();
-        while (pos != bt[ftype].interactionTypes.end() && nmatch_max < 4)
-        {
-            pos = std::find_if(bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                               [&p, &at, &atypes, &bB, &nmatch_max](const auto& param) {
-                                   return (findNumberOfDihedralAtomMatches(param, p, at, atypes, bB)
-                                           > nmatch_max);
-                               });
-            if (pos != bt[ftype].interactionTypes.end())
+        const InteractionTypeIndex& index = updateInteractionTypeIndex(&bt[ftype]);
+        std::array<int, 4>          types;
+        for (int j = 0; j < 4; j++)
+        {
+            const t_atom& atom = at->atom[p.atoms()[j]];
+            types[j]           = atypes->bondAtomTypeFromAtomType(bB ? atom.typeB : atom.type);
+        }
+        int bestIndex = -1;
+        for (int wildcards = 0; wildcards < 16; wildcards++)
+        {
+            std::array<int, 4> typesOrWildcards;
+            int                nmatch = 0;
+            for (int j = 0; j < 4; j++)
             {
-                prevPos    = pos;
-                nmatch_max = findNumberOfDihedralAtomMatches(*pos, p, at, atypes, bB);
+                typesOrWildcards[j] = ((wildcards >> j) & 1) ? -1 : types[j];
+                nmatch += (typesOrWildcards[j] == -1) ? 0 : 1;
+            }
+            const auto entry = index.find(interactionTypeKey(typesOrWildcards));
+            if (entry != index.end()
+                && (nmatch > nmatch_max || (nmatch == nmatch_max && entry->second < bestIndex)))
+            {
+                nmatch_max = nmatch;
+                bestIndex  = entry->second;
             }
         }
+        auto prevPos = (bestIndex >= 0) ? bt[ftype].interactionTypes.begin() + bestIndex
+                                        : bt[ftype].interactionTypes.end();
 
         if (prevPos != bt[ftype].interactionTypes.end())
         {
@@ -1828,12 +1783,13 @@ static std::vector<InteractionOfType>::iterator defaultInteractionsOfType(int ft
     }
     else /* Not a dihedral */
     {
-        gmx::ArrayRef<const int> atomParam = p.atoms();
-        auto                     found     = std::find_if(
-                bt[ftype].interactionTypes.begin(), bt[ftype].interactionTypes.end(),
-                [&atomParam, &at, &atypes, &bB](const auto& param) {
-                    return findIfAllParameterAtomsMatch(param.atoms(), atomParam, at, atypes, bB);
-                });
+        std::vector<int> types;
+        for (int atom : p.atoms())
+        {
+            types.push_back(atypes->bondAtomTypeFromAtomType(bB ? at->atom[atom].typeB
+                                                                : at->atom[atom].type));
+        }
+        auto found = findInteractionTypeWithAtomTypes(&bt[ftype], types);
         if (found != bt[ftype].interactionTypes.end())
         {
             nparam_found = 1;
@@ -2609,9 +2565,10 @@ static void convert_pairs_to_pairsQ(gmx::ArrayRef<InteractionsOfType> interactio
 
     /* now assign the new data to the F_LJC14_Q structure */
     interactions[F_LJC14_Q].interactionTypes = paramnew;
+    interactions[F_LJC14_Q].invalidateTypeIndices();
 
     /* Empty the LJ14 pairlist */
-    interactions[F_LJ14].interactionTypes.clear();
+    interactions[F_LJ14].clear();
 }
 
 static void generate_LJCpairsNB(MoleculeInformation* mol, int nb_funct, InteractionsOfType* nbp, warninp* wi)
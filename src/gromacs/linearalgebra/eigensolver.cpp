@@ -39,7 +39,12 @@
 
 #include "eigensolver.h"
 
+#include <algorithm>
+#include <vector>
+
 #include "gromacs/linearalgebra/sparsematrix.h"
+#include "gromacs/random/normaldistribution.h"
+#include "gromacs/random/threefry.h"
 #include "gromacs/utility/fatalerror.h"
 #include "gromacs/utility/real.h"
 #include "gromacs/utility/smalloc.h"
@@ -367,3 +372,123 @@ void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real
     sfree(workl);
     sfree(select);
 }
+
+
+/* Orthonormalize the l vectors of length n in q using a QR factorization */
+static void orthonormalize(real* q, int n, int l)
+{
+    std::vector<real> tau(l);
+    real              w0;
+    int               lwork = -1;
+    int               info;
+
+#if GMX_DOUBLE
+    F77_FUNC(dgeqrf, DGEQRF)(&n, &l, q, &n, tau.data(), &w0, &lwork, &info);
+#else
+    F77_FUNC(sgeqrf, SGEQRF)(&n, &l, q, &n, tau.data(), &w0, &lwork, &info);
+#endif
+    lwork = std::max(static_cast<int>(w0), l);
+    std::vector<real> work(lwork);
+#if GMX_DOUBLE
+    F77_FUNC(dgeqrf, DGEQRF)(&n, &l, q, &n, tau.data(), work.data(), &lwork, &info);
+#else
+    F77_FUNC(sgeqrf, SGEQRF)(&n, &l, q, &n, tau.data(), work.data(), &lwork, &info);
+#endif
+    if (info != 0)
+    {
+        gmx_fatal(FARGS, "Internal errror in LAPACK QR factorization.");
+    }
+#if GMX_DOUBLE
+    F77_FUNC(dorgqr, DORGQR)(&n, &l, &l, q, &n, tau.data(), work.data(), &lwork, &info);
+#else
+    F77_FUNC(sorgqr, SORGQR)(&n, &l, &l, q, &n, tau.data(), work.data(), &lwork, &info);
+#endif
+    if (info != 0)
+    {
+        gmx_fatal(FARGS, "Internal errror in LAPACK QR factorization.");
+    }
+}
+
+void randomized_eigensolver(int                        n,
+                            int                        neig,
+                            int                        noversample,
+                            int                        npower,
+                            int64_t                    seed,
+                            const MatrixApplyFunction& applyMatrix,
+                            real*                      eigenvalues,
+                            real*                      eigenvectors)
+{
+    const int l = std::min(n, neig + noversample);
+
+    if (neig > l)
+    {
+        gmx_fatal(FARGS, "Can not determine %d eigenvalues of a %dx%d matrix", neig, n, n);
+    }
+
+    std::vector<real> q(static_cast<size_t>(n) * l);
+    std::vector<real> y(static_cast<size_t>(n) * l);
+
+    /* Start from random vectors */
+    gmx::ThreeFry2x64<64>         rng(seed, gmx::RandomDomain::Other);
+    gmx::NormalDistribution<real> normalDist;
+    for (auto& value : q)
+    {
+        value = normalDist(rng);
+    }
+
+    /* Power iterations, with orthonormalization to avoid the basis
+     * collapsing onto the eigenvector with the largest eigenvalue.
+     */
+    for (int iter = 0; iter <= npower; iter++)
+    {
+        std::fill(y.begin(), y.end(), 0);
+        applyMatrix(q.data(), l, y.data());
+        orthonormalize(y.data(), n, l);
+        std::swap(q, y);
+    }
+
+    /* Project the matrix onto the basis q: b = q^T A q */
+    std::fill(y.begin(), y.end(), 0);
+    applyMatrix(q.data(), l, y.data());
+    std::vector<real> b(l * l);
+    for (int i = 0; i < l; i++)
+    {
+        for (int j = 0; j <= i; j++)
+        {
+            double sum = 0;
+            for (int m = 0; m < n; m++)
+            {
+                sum += q[static_cast<size_t>(i) * n + m] * y[static_cast<size_t>(j) * n + m];
+            }
+            /* Symmetrize to remove rounding errors */
+            b[i * l + j] = sum;
+            b[j * l + i] = sum;
+        }
+    }
+
+    /* Diagonalize the small matrix, giving all eigenvalues in ascending order */
+    std::vector<real> bvalues(l);
+    std::vector<real> bvectors(l * l);
+    eigensolver(b.data(), l, 0, l, bvalues.data(), bvectors.data());
+
+    /* Transform the eigenvectors back: v = q u, largest first */
+    for (int e = 0; e < neig; e++)
+    {
+        const real* u = bvectors.data() + (l - 1 - e) * l;
+        real*       v = eigenvectors + static_cast<size_t>(e) * n;
+
+        eigenvalues[e] = bvalues[l - 1 - e];
+        for (int m = 0; m < n; m++)
+        {
+            v[m] = 0;
+        }
+        for (int j = 0; j < l; j++)
+        {
+            const real* qj = q.data() + static_cast<size_t>(j) * n;
+            for (int m = 0; m < n; m++)
+            {
+                v[m] += u[j] * qj[m];
+            }
+        }
+    }
+}
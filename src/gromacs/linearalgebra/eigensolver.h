@@ -37,6 +37,10 @@
 #ifndef GMX_LINEARALGEBRA_EIGENSOLVER_H
 #define GMX_LINEARALGEBRA_EIGENSOLVER_H
 
+#include <cstdint>
+
+#include <functional>
+
 #include "gromacs/linearalgebra/sparsematrix.h"
 #include "gromacs/utility/real.h"
 
@@ -75,4 +79,40 @@ void eigensolver(real* a, int n, int index_lower, int index_upper, real* eigenva
  */
 void sparse_eigensolver(gmx_sparsematrix_t* A, int neig, real* eigenvalues, real* eigenvectors, int maxiter);
 
+/*! \brief Function that computes y = A q for a matrix A and l vectors q of length n
+ *
+ * The l vectors in q and y are stored consecutively.
+ */
+typedef std::function<void(const real* q, int l, real* y)> MatrixApplyFunction;
+
+/*! \brief Randomized eigensolver for the largest eigenvalues of a symmetric matrix.
+ *
+ *  This routine is intended for large positive semi-definite matrices, such
+ *  as covariance matrices, that are only available through their product
+ *  with a set of vectors, so the matrix itself never needs to be stored.
+ *  It determines an approximate basis for the range of the matrix by
+ *  applying it to neig+noversample random vectors, followed by npower
+ *  power iterations for increased accuracy, and diagonalizes the matrix
+ *  projected on that basis (Halko, Martinsson & Tropp, SIAM Rev. 53, 217 (2011)).
+ *  The matrix is applied npower+2 times, always to a block of vectors.
+ *
+ *  \param n             Side of the matrix.
+ *  \param neig          The number of largest eigenvalues to determine.
+ *  \param noversample   The number of extra basis vectors used, 10 is usually sufficient.
+ *  \param npower        The number of power iterations, 1 or 2 is usually sufficient.
+ *  \param seed          Seed for the random number generator.
+ *  \param applyMatrix   Function that computes y = A q, y is zero on input.
+ *  \param eigenvalues   Array of length neig for the eigenvalues in descending order.
+ *  \param eigenvectors  Array of length neig*n for the corresponding eigenvectors,
+ *                       eigenvector j starts at offset j*n.
+ */
+void randomized_eigensolver(int                        n,
+                            int                        neig,
+                            int                        noversample,
+                            int                        npower,
+                            int64_t                    seed,
+                            const MatrixApplyFunction& applyMatrix,
+                            real*                      eigenvalues,
+                            real*                      eigenvectors);
+
 #endif
@@ -43,9 +43,16 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/fatalerror.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/smalloc.h"
 
+#include "gmx_blas.h"
 #include "gmx_lapack.h"
 
 double** alloc_matrix(int n, int m)
@@ -247,3 +254,124 @@ double multi_regression(FILE* fp, int nrow, double* y, int ncol, double** xx, do
 
     return chi2;
 }
+
+/* Column-major matrix-matrix product c = alpha op(a) op(b) + beta c */
+static void gemm(const char* transa,
+                 const char* transb,
+                 int         m,
+                 int         n,
+                 int         k,
+                 real        alpha,
+                 const real* a,
+                 int         lda,
+                 const real* b,
+                 int         ldb,
+                 real        beta,
+                 real*       c,
+                 int         ldc)
+{
+#if GMX_DOUBLE
+    F77_FUNC(dgemm, DGEMM)
+    (transa, transb, &m, &n, &k, &alpha, const_cast<real*>(a), &lda, const_cast<real*>(b), &ldb,
+     &beta, c, &ldc);
+#else
+    F77_FUNC(sgemm, SGEMM)
+    (transa, transb, &m, &n, &k, &alpha, const_cast<real*>(a), &lda, const_cast<real*>(b), &ldb,
+     &beta, c, &ldc);
+#endif
+}
+
+void symmetric_rank_k_update(real* a, int n, const real* x, int k)
+{
+    /* The row blocks should not be too small for efficient BLAS calls */
+    const int c_minRowsPerBlock = 64;
+
+    if (n == 0 || k == 0)
+    {
+        return;
+    }
+
+    /* Use several blocks per thread for load balancing */
+    const int numBlocks = std::max(1, std::min(4 * gmx_omp_get_max_threads(), n / c_minRowsPerBlock));
+
+    /* Choose the row block boundaries such that each block covers
+     * an equal part of the upper triangle.
+     */
+    std::vector<int> rowStart(numBlocks + 1);
+    for (int b = 0; b <= numBlocks; b++)
+    {
+        rowStart[b] = static_cast<int>(n * (1 - std::sqrt(1 - b / static_cast<double>(numBlocks))));
+    }
+    rowStart[numBlocks] = n;
+
+    /* With column-major storage in BLAS, rows i0 to i1 of the upper
+     * triangle of a are columns i0 to i1 starting at row i0.
+     */
+#pragma omp parallel for num_threads(gmx_omp_get_max_threads()) schedule(dynamic)
+    for (int b = 0; b < numBlocks; b++)
+    {
+        try
+        {
+            const int i0 = rowStart[b];
+            const int i1 = rowStart[b + 1];
+            if (i1 > i0)
+            {
+                gemm("N", "T", n - i0, i1 - i0, k, 1, x + i0, n, x + i0, n, 1,
+                     a + static_cast<int64_t>(i0) * n + i0, n);
+            }
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
+
+void symmetric_rank_k_apply(int n, const real* x, int k, const real* q, int l, real* y)
+{
+    const int c_minRowsPerThread = 256;
+
+    if (n == 0 || k == 0 || l == 0)
+    {
+        return;
+    }
+
+    const int maxNumThreads =
+            std::max(1, std::min(gmx_omp_get_max_threads(), n / c_minRowsPerThread));
+
+    /* First z = x^T q, reduced over the thread contributions,
+     * then y += x z, where each thread handles a block of rows.
+     */
+    std::vector<real> zThread(maxNumThreads * k * l);
+    std::vector<real> z(k * l);
+
+#pragma omp parallel num_threads(maxNumThreads)
+    {
+        try
+        {
+            /* The runtime can give us fewer threads than requested,
+             * so we divide the rows over the actual number of threads.
+             */
+            const int numThreads = gmx_omp_get_num_threads();
+            const int thread     = gmx_omp_get_thread_num();
+            const int i0         = (thread * n) / numThreads;
+            const int i1         = ((thread + 1) * n) / numThreads;
+            real*     zt         = zThread.data() + thread * k * l;
+
+            gemm("T", "N", k, l, i1 - i0, 1, x + i0, n, q + i0, n, 0, zt, k);
+
+#pragma omp barrier
+#pragma omp for
+            for (int i = 0; i < k * l; i++)
+            {
+                real sum = 0;
+                for (int t = 0; t < numThreads; t++)
+                {
+                    sum += zThread[t * k * l + i];
+                }
+                z[i] = sum;
+            }
+            /* The implicit barrier of the omp for above makes z complete */
+
+            gemm("N", "N", i1 - i0, l, k, 1, x + i0, n, z.data(), k, 1, y + i0, n);
+        }
+        GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
+    }
+}
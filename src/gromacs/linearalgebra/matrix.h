@@ -39,6 +39,8 @@
 
 #include <stdio.h>
 
+#include "gromacs/utility/real.h"
+
 double** alloc_matrix(int n, int m);
 
 void free_matrix(double** a);
@@ -58,4 +60,25 @@ double multi_regression(FILE* fp, int ny, double* y, int nx, double** xx, double
  * If fp is not NULL debug information will be written to it.
  */
 
+/*! \brief Add the outer products of k vectors of length n to matrix a: a += x x^T
+ *
+ * The k vectors are stored consecutively in x. Of the n x n matrix a
+ * the upper triangle, i.e. a[i*n + j] with j >= i, plus some entries of
+ * the diagonal blocks used internally, is updated. Callers should only
+ * use the upper triangle and should not rely on the lower triangle
+ * being left untouched.
+ * This uses blocked BLAS matrix-matrix products distributed over
+ * OpenMP threads, which is much faster than k separate rank-1 updates.
+ */
+void symmetric_rank_k_update(real* a, int n, const real* x, int k);
+
+/*! \brief Add the product of x x^T with q to y: y += x (x^T q)
+ *
+ * x contains k vectors, q and y contain l vectors, all of length n
+ * and stored consecutively. The n x n matrix x x^T is never formed,
+ * which saves memory and time when k and l are much smaller than n.
+ * The work is distributed over OpenMP threads.
+ */
+void symmetric_rank_k_apply(int n, const real* x, int k, const real* q, int l, real* y);
+
 #endif
@@ -0,0 +1,224 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the multi-threaded symmetric rank-k routines and the
+ * randomized eigensolver.
+ *
+ * \ingroup module_linearalgebra
+ */
+#include "gmxpre.h"
+
+#include "gromacs/linearalgebra/matrix.h"
+
+#include <cmath>
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/linearalgebra/eigensolver.h"
+#include "gromacs/math/utilities.h"
+#include "gromacs/random/threefry.h"
+#include "gromacs/random/uniformrealdistribution.h"
+#include "gromacs/utility/gmxomp.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+//! Returns \p size uniform random numbers in [-1, 1)
+std::vector<real> randomVector(int size, uint64_t seed)
+{
+    ThreeFry2x64<64>              rng(seed, RandomDomain::Other);
+    UniformRealDistribution<real> dist(-1, 1);
+    std::vector<real>             v(size);
+    for (auto& value : v)
+    {
+        value = dist(rng);
+    }
+    return v;
+}
+
+//! Returns the dense n x n matrix x x^T for k vectors of length n in x
+std::vector<double> denseOuterProduct(int n, const std::vector<real>& x, int k)
+{
+    std::vector<double> a(n * n, 0.0);
+    for (int m = 0; m < k; m++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            for (int j = 0; j < n; j++)
+            {
+                a[i * n + j] += static_cast<double>(x[m * n + i]) * x[m * n + j];
+            }
+        }
+    }
+    return a;
+}
+
+/*! \brief Runs the tests with different numbers of OpenMP threads
+ *
+ * Restores the number of threads afterwards.
+ */
+class SymmetricRankKTest : public ::testing::TestWithParam<int>
+{
+public:
+    SymmetricRankKTest() : savedNumThreads_(gmx_omp_get_max_threads())
+    {
+        gmx_omp_set_num_threads(GetParam());
+    }
+    ~SymmetricRankKTest() override { gmx_omp_set_num_threads(savedNumThreads_); }
+
+private:
+    int savedNumThreads_;
+};
+
+TEST_P(SymmetricRankKTest, UpdateMatchesDenseReference)
+{
+    const int n = 301;
+    const int k = 37;
+
+    const std::vector<real> x = randomVector(n * k, 1234);
+    std::vector<real>       a = randomVector(n * n, 5678);
+    const std::vector<real> aStart(a);
+
+    symmetric_rank_k_update(a.data(), n, x.data(), k);
+
+    const std::vector<double> xxT = denseOuterProduct(n, x, k);
+    for (int i = 0; i < n; i++)
+    {
+        for (int j = i; j < n; j++)
+        {
+            EXPECT_NEAR(a[i * n + j], aStart[i * n + j] + xxT[i * n + j], 1e-4 * k)
+                    << "for element " << i << " " << j;
+        }
+    }
+}
+
+TEST_P(SymmetricRankKTest, ApplyMatchesDenseReference)
+{
+    // Large enough to give several threads a block of rows
+    const int n = 1100;
+    const int k = 20;
+    const int l = 7;
+
+    const std::vector<real> x = randomVector(n * k, 4321);
+    const std::vector<real> q = randomVector(n * l, 8765);
+    std::vector<real>       y = randomVector(n * l, 1111);
+    const std::vector<real> yStart(y);
+
+    symmetric_rank_k_apply(n, x.data(), k, q.data(), l, y.data());
+
+    const std::vector<double> xxT = denseOuterProduct(n, x, k);
+    for (int v = 0; v < l; v++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            double reference = yStart[v * n + i];
+            for (int j = 0; j < n; j++)
+            {
+                reference += xxT[i * n + j] * q[v * n + j];
+            }
+            EXPECT_NEAR(y[v * n + i], reference, 1e-5 * n * k)
+                    << "for vector " << v << " element " << i;
+        }
+    }
+}
+
+TEST_P(SymmetricRankKTest, RandomizedEigensolverMatchesDenseSolver)
+{
+    // The matrix has rank k, which is smaller than the basis size,
+    // so the randomized solver should find the exact eigenpairs.
+    const int n           = 600;
+    const int k           = 12;
+    const int neig        = 5;
+    const int noversample = 10;
+
+    // The bundled LAPACK eigensolver relies on IEEE arithmetic with infinities
+    gmx_fedisableexcept();
+
+    std::vector<real> x = randomVector(n * k, 2468);
+    // Give the vectors different weights for a clear spread of eigenvalues
+    for (int m = 0; m < k; m++)
+    {
+        for (int i = 0; i < n; i++)
+        {
+            x[m * n + i] *= (k - m);
+        }
+    }
+
+    std::vector<real> eigenvalues(neig);
+    std::vector<real> eigenvectors(neig * n);
+    randomized_eigensolver(n, neig, noversample, 1, 13579,
+                           [&](const real* q, int l, real* y) {
+                               symmetric_rank_k_apply(n, x.data(), k, q, l, y);
+                           },
+                           eigenvalues.data(), eigenvectors.data());
+
+    const std::vector<double> xxT = denseOuterProduct(n, x, k);
+    std::vector<real>         a(xxT.begin(), xxT.end());
+    std::vector<real>         referenceValues(n);
+    std::vector<real>         referenceVectors(n * n);
+    // The dense solver returns the eigenpairs in ascending order
+    eigensolver(a.data(), n, 0, n, referenceValues.data(), referenceVectors.data());
+
+    for (int e = 0; e < neig; e++)
+    {
+        const int  r              = n - 1 - e;
+        const real referenceValue = referenceValues[r];
+        EXPECT_NEAR(eigenvalues[e], referenceValue, 1e-4 * referenceValue)
+                << "for eigenvalue " << e;
+
+        double dotProduct = 0;
+        for (int i = 0; i < n; i++)
+        {
+            dotProduct += eigenvectors[e * n + i] * referenceVectors[r * n + i];
+        }
+        EXPECT_NEAR(std::abs(dotProduct), 1.0, 1e-3) << "for eigenvector " << e;
+    }
+
+    gmx_feenableexcept();
+}
+
+INSTANTIATE_TEST_CASE_P(WithDifferentThreadCounts, SymmetricRankKTest, ::testing::Values(1, 2, 4));
+
+} // namespace
+} // namespace test
+} // namespace gmx
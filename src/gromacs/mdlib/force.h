@@ -115,6 +115,10 @@ void do_force(FILE*                               log,
  *
  * xWholeMolecules only needs to contain whole molecules when orientation
  * restraints need to be computed and can be empty otherwise.
+ * The long-range Ewald and PME forces are added to forceWithVirialLongRange,
+ * which is the force with virial output of forceOutputs, except with multiple
+ * time stepping, where the slow forces are accumulated separately. They are
+ * only computed when stepWork.computeSlowForces is set.
  */
 void do_force_lowlevel(t_forcerec*                               fr,
                        const t_inputrec*                         ir,
@@ -127,6 +131,7 @@ void do_force_lowlevel(t_forcerec*                               fr,
                        gmx::ArrayRef<const gmx::RVec>            xWholeMolecules,
                        history_t*                                hist,
                        gmx::ForceOutputs*                        forceOutputs,
+                       gmx::ForceWithVirial*                     forceWithVirialLongRange,
                        gmx_enerdata_t*                           enerd,
                        const matrix                              box,
                        const real*                               lambda,
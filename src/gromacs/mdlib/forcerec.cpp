@@ -100,8 +100,9 @@
 #include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
 
-ForceHelperBuffers::ForceHelperBuffers(bool haveDirectVirialContributions) :
-    haveDirectVirialContributions_(haveDirectVirialContributions)
+ForceHelperBuffers::ForceHelperBuffers(bool haveDirectVirialContributions, bool useMts) :
+    haveDirectVirialContributions_(haveDirectVirialContributions),
+    useMts_(useMts)
 {
     shiftForces_.resize(SHIFTS);
 }
@@ -112,6 +113,10 @@ void ForceHelperBuffers::resize(int numAtoms)
     {
         forceBufferForDirectVirialContributions_.resize(numAtoms);
     }
+    if (useMts_)
+    {
+        forceMtsCombined_.resizeWithPadding(numAtoms);
+    }
 }
 
 static std::vector<real> mk_nbfp(const gmx_ffparams_t* idef, gmx_bool bBHAM)
@@ -1176,7 +1181,8 @@ void init_forcerec(FILE*                            fp,
             (EEL_FULL(ic->eeltype) || EVDW_PME(ic->vdwtype) || fr->forceProviders->hasForceProvider()
              || gmx_mtop_ftype_count(mtop, F_POSRES) > 0 || gmx_mtop_ftype_count(mtop, F_FBPOSRES) > 0
              || ir->nwall > 0 || ir->bPull || ir->bRot || ir->bIMD);
-    fr->forceHelperBuffers = std::make_unique<ForceHelperBuffers>(haveDirectVirialContributions);
+    fr->forceHelperBuffers =
+            std::make_unique<ForceHelperBuffers>(haveDirectVirialContributions, ir->useMts);
 
     if (fr->shift_vec == nullptr)
     {
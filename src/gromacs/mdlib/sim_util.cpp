@@ -44,6 +44,7 @@
 #include <cstring>
 
 #include <array>
+#include <optional>
 
 #include "gromacs/awh/awh.h"
 #include "gromacs/domdec/dlbtiming.h"
@@ -210,12 +211,13 @@ static void pme_receive_force_ener(t_forcerec*           fr,
                                    gmx_enerdata_t*       enerd,
                                    bool                  useGpuPmePpComms,
                                    bool                  receivePmeForceToGpu,
+                                   float                 cyclesPpDuringPmeBefore,
                                    gmx_wallcycle_t       wcycle)
 {
     real  e_q, e_lj, dvdl_q, dvdl_lj;
     float cycles_ppdpme, cycles_seppme;
 
-    cycles_ppdpme = wallcycle_stop(wcycle, ewcPPDURINGPME);
+    cycles_ppdpme = cyclesPpDuringPmeBefore + wallcycle_stop(wcycle, ewcPPDURINGPME);
     dd_cycles_add(cr->dd, cycles_ppdpme, ddCyclPPduringPME);
 
     /* In case of node-splitting, the PP nodes receive the long-range
@@ -381,6 +383,27 @@ static void postProcessForces(const t_commrec*          cr,
     }
 }
 
+/*! \brief Combines the fast and slow forces with multiple time stepping
+ *
+ * Adds the slow forces to \p forceFast, which then contains the total force,
+ * and stores the fast forces plus \p mtsFactor times the slow forces,
+ * the forces to integrate with, in \p forceSlow.
+ */
+static void combineMtsForces(const int      numAtoms,
+                             ArrayRef<RVec> forceFast,
+                             ArrayRef<RVec> forceSlow,
+                             const real     mtsFactor)
+{
+    const int gmx_unused numThreads = gmx_omp_nthreads_get(emntDefault);
+#pragma omp parallel for num_threads(numThreads) schedule(static)
+    for (int i = 0; i < numAtoms; i++)
+    {
+        const RVec forceFastI = forceFast[i];
+        forceFast[i] += forceSlow[i];
+        forceSlow[i] = forceFastI + mtsFactor * forceSlow[i];
+    }
+}
+
 static void do_nb_verlet(t_forcerec*                fr,
                          const interaction_const_t* ic,
                          gmx_enerdata_t*            enerd,
@@ -872,13 +895,17 @@ static DomainLifetimeWorkload setupDomainLifetimeWorkload(const t_inputrec&
  * \param[in]      isNonbondedOn        Global override, if false forces to turn off all nonbonded calculation.
  * \param[in]      simulationWork       Simulation workload description.
  * \param[in]      rankHasPmeDuty       If this rank computes PME.
+ * \param[in]      step                 The MD step number.
+ * \param[in]      mtsFactor            The multiple time stepping factor, 1 without MTS.
  *
  * \returns New Stepworkload description.
  */
 static StepWorkload setupStepWorkload(const int                 legacyFlags,
                                       const bool                isNonbondedOn,
                                       const SimulationWorkload& simulationWork,
-                                      const bool                rankHasPmeDuty)
+                                      const bool                rankHasPmeDuty,
+                                      const int64_t             step,
+                                      const int                 mtsFactor)
 {
     StepWorkload flags;
     flags.stateChanged           = ((legacyFlags & GMX_FORCE_STATECHANGED) != 0);
@@ -890,6 +917,11 @@ static StepWorkload setupStepWorkload(const int                 legacyFlags,
     flags.computeListedForces    = ((legacyFlags & GMX_FORCE_LISTED) != 0);
     flags.computeNonbondedForces = ((legacyFlags & GMX_FORCE_NONBONDED) != 0) && isNonbondedOn;
     flags.computeDhdl            = ((legacyFlags & GMX_FORCE_DHDL) != 0);
+    /* With multiple time stepping we also need the slow forces at energy
+     * and virial steps that are not a multiple of the MTS factor, so
+     * the energies and the virial include all contributions.
+     */
+    flags.computeSlowForces = (step % mtsFactor == 0 || flags.computeEnergy || flags.computeVirial);
 
     if (simulationWork.useGpuBufferOps)
     {
@@ -1040,8 +1072,10 @@ void do_force(FILE*                               fplog,
     const SimulationWorkload& simulationWork = runScheduleWork->simulationWork;
 
 
-    runScheduleWork->stepWork    = setupStepWorkload(legacyFlags, fr->bNonbonded, simulationWork,
-                                                  thisRankHasDuty(cr, DUTY_PME));
+    runScheduleWork->stepWork =
+            setupStepWorkload(legacyFlags, fr->bNonbonded, simulationWork,
+                              thisRankHasDuty(cr, DUTY_PME), step,
+                              inputrec->useMts ? inputrec->mtsFactor : 1);
     const StepWorkload& stepWork = runScheduleWork->stepWork;
 
 
@@ -1092,7 +1126,9 @@ void do_force(FILE*                               fplog,
 
     // If coordinates are to be sent to PME task from CPU memory, perform that send here.
     // Otherwise the send will occur after H2D coordinate transfer.
-    if (GMX_MPI && !thisRankHasDuty(cr, DUTY_PME) && !pmeSendCoordinatesFromGpu)
+    // With multiple time stepping PME is only computed at slow force steps.
+    if (GMX_MPI && !thisRankHasDuty(cr, DUTY_PME) && !pmeSendCoordinatesFromGpu
+        && stepWork.computeSlowForces)
     {
         /* Send particle coordinates to the pme nodes */
         if (!stepWork.doNeighborSearch && simulationWork.useGpuUpdate)
@@ -1146,6 +1182,15 @@ void do_force(FILE*                               fplog,
             ((cr->dd != nullptr) && (!cr->dd->gpuHaloExchange.empty()));
     GMX_ASSERT(!ddUsesGpuDirectCommunication || stepWork.useGpuXBufferOps,
                "Must use coordinate buffer ops with GPU halo exchange");
+
+    /* With CPU non-bonded and CPU halo exchange, we overlap the communication
+     * of the coordinates of the first halo pulse with the local non-bonded
+     * force computation.
+     */
+    const bool overlapCpuHaloExchange =
+            (havePPDomainDecomposition(cr) && !stepWork.doNeighborSearch
+             && !ddUsesGpuDirectCommunication && !simulationWork.useGpuNonbonded
+             && !fr->nbv->emulateGpu());
     const bool useGpuForcesHaloExchange = ddUsesGpuDirectCommunication && stepWork.useGpuFBufferOps;
 
     // Copy coordinate from the GPU if update is on the GPU and there
@@ -1170,7 +1215,7 @@ void do_force(FILE*                               fplog,
 
     // If coordinates are to be sent to PME task from GPU memory, perform that send here.
     // Otherwise the send will occur before the H2D coordinate transfer.
-    if (!thisRankHasDuty(cr, DUTY_PME) && pmeSendCoordinatesFromGpu)
+    if (!thisRankHasDuty(cr, DUTY_PME) && pmeSendCoordinatesFromGpu && stepWork.computeSlowForces)
     {
         /* Send particle coordinates to the pme nodes */
         gmx_pme_send_coordinates(fr, cr, box, as_rvec_array(x.unpaddedArrayRef().data()), lambda[efptCOUL],
@@ -1385,7 +1430,14 @@ void do_force(FILE*                               fplog,
                 // a waitCoordinatesReadyOnHost() should be issued if it will be.
                 GMX_ASSERT(!simulationWork.useGpuUpdate,
                            "GPU update is not supported with CPU halo exchange");
-                dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                if (overlapCpuHaloExchange)
+                {
+                    dd_move_x_start(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
+                else
+                {
+                    dd_move_x(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+                }
             }
 
             if (stepWork.useGpuXBufferOps)
@@ -1398,7 +1450,7 @@ void do_force(FILE*                               fplog,
                                            stateGpu->getCoordinatesReadyOnDeviceEvent(
                                                    AtomLocality::NonLocal, simulationWork, stepWork));
             }
-            else
+            else if (!overlapCpuHaloExchange)
             {
                 nbv->convertCoordinates(AtomLocality::NonLocal, false, x.unpaddedArrayRef());
             }
@@ -1478,9 +1530,19 @@ void do_force(FILE*                               fplog,
     /* Reset energies */
     reset_enerdata(enerd);
 
-    if (DOMAINDECOMP(cr) && !thisRankHasDuty(cr, DUTY_PME))
+    /* With separate PME ranks, we measure the PP work done while PME runs.
+     * Waiting for the halo coordinates is excluded from this measurement.
+     * With MTS, PME only runs at steps where we compute the slow forces.
+     */
+    const bool measurePpDuringPme =
+            (DOMAINDECOMP(cr) && !thisRankHasDuty(cr, DUTY_PME) && stepWork.computeSlowForces);
+    float      cyclesPpDuringPmeBefore = 0;
+    if (measurePpDuringPme)
     {
         wallcycle_start(wcycle, ewcPPDURINGPME);
+    }
+    if (DOMAINDECOMP(cr) && !thisRankHasDuty(cr, DUTY_PME))
+    {
         dd_force_flop_start(cr->dd, nrnb);
     }
 
@@ -1510,6 +1572,21 @@ void do_force(FILE*                               fplog,
     ForceOutputs forceOut = setupForceOutputs(fr->forceHelperBuffers.get(), pull_work, *inputrec,
                                               std::move(force), stepWork, wcycle);
 
+    /* With multiple time stepping, the slow forces are accumulated in
+     * a separate buffer, so they can be scaled for the integration.
+     */
+    const bool useMtsSlowForceBuffer =
+            (inputrec->useMts && stepWork.computeSlowForces && stepWork.computeForces);
+    std::optional<gmx::ForceWithVirial> forceWithVirialMtsSlow;
+    if (useMtsSlowForceBuffer)
+    {
+        ArrayRef<RVec> forceSlow = fr->forceHelperBuffers->forceMtsCombined().unpaddedArrayRef();
+        clearRVecs(forceSlow, true);
+        forceWithVirialMtsSlow.emplace(forceSlow, stepWork.computeVirial);
+    }
+    gmx::ForceWithVirial* forceWithVirialLongRange =
+            (useMtsSlowForceBuffer ? &forceWithVirialMtsSlow.value() : &forceOut.forceWithVirial());
+
     /* We calculate the non-bonded forces, when done on the CPU, here.
      * We do this before calling do_force_lowlevel, because in that
      * function, the listed forces are calculated before PME, which
@@ -1525,6 +1602,23 @@ void do_force(FILE*                               fplog,
         do_nb_verlet(fr, ic, enerd, stepWork, InteractionLocality::Local, enbvClearFYes, step, nrnb, wcycle);
     }
 
+    if (overlapCpuHaloExchange)
+    {
+        /* Complete the coordinate communication started before the local work */
+        wallcycle_stop(wcycle, ewcFORCE);
+        if (measurePpDuringPme)
+        {
+            cyclesPpDuringPmeBefore += wallcycle_stop(wcycle, ewcPPDURINGPME);
+        }
+        dd_move_x_finish(cr->dd, box, x.unpaddedArrayRef(), wcycle);
+        if (measurePpDuringPme)
+        {
+            wallcycle_start_nocount(wcycle, ewcPPDURINGPME);
+        }
+        nbv->convertCoordinates(AtomLocality::NonLocal, false, x.unpaddedArrayRef());
+        wallcycle_start_nocount(wcycle, ewcFORCE);
+    }
+
     if (fr->efep != efepNO)
     {
         /* Calculate the local and non-local free energy interactions here.
@@ -1581,8 +1675,8 @@ void do_force(FILE*                               fplog,
     }
     /* Compute the bonded and non-bonded energies and optionally forces */
     do_force_lowlevel(fr, inputrec, cr, ms, nrnb, wcycle, mdatoms, x, xWholeMolecules, hist,
-                      &forceOut, enerd, box, lambda.data(), as_rvec_array(dipoleData.muStateAB),
-                      stepWork, ddBalanceRegionHandler);
+                      &forceOut, forceWithVirialLongRange, enerd, box, lambda.data(),
+                      as_rvec_array(dipoleData.muStateAB), stepWork, ddBalanceRegionHandler);
 
     wallcycle_stop(wcycle, ewcFORCE);
 
@@ -1765,7 +1859,7 @@ void do_force(FILE*                               fplog,
 
     // If on GPU PME-PP comms or GPU update path, receive forces from PME before GPU buffer ops
     // TODO refactor this and unify with below default-path call to the same function
-    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME)
+    if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && stepWork.computeSlowForces
         && (simulationWork.useGpuPmePpCommunication || simulationWork.useGpuUpdate))
     {
         /* In case of node-splitting, the PP nodes receive the long-range
@@ -1773,7 +1867,7 @@ void do_force(FILE*                               fplog,
          */
         pme_receive_force_ener(fr, cr, &forceOut.forceWithVirial(), enerd,
                                simulationWork.useGpuPmePpCommunication,
-                               stepWork.useGpuPmeFReduction, wcycle);
+                               stepWork.useGpuPmeFReduction, cyclesPpDuringPmeBefore, wcycle);
     }
 
 
@@ -1876,13 +1970,14 @@ void do_force(FILE*                               fplog,
 
     // TODO refactor this and unify with above GPU PME-PP / GPU update path call to the same function
     if (PAR(cr) && !thisRankHasDuty(cr, DUTY_PME) && !simulationWork.useGpuPmePpCommunication
-        && !simulationWork.useGpuUpdate)
+        && !simulationWork.useGpuUpdate && stepWork.computeSlowForces)
     {
         /* In case of node-splitting, the PP nodes receive the long-range
          * forces, virial and energy from the PME nodes here.
          */
-        pme_receive_force_ener(fr, cr, &forceOut.forceWithVirial(), enerd,
-                               simulationWork.useGpuPmePpCommunication, false, wcycle);
+        pme_receive_force_ener(fr, cr, forceWithVirialLongRange, enerd,
+                               simulationWork.useGpuPmePpCommunication, false,
+                               cyclesPpDuringPmeBefore, wcycle);
     }
 
     if (stepWork.computeForces)
@@ -1891,6 +1986,33 @@ void do_force(FILE*                               fplog,
                           mdatoms, fr, vsite, stepWork);
     }
 
+    if (useMtsSlowForceBuffer)
+    {
+        gmx::ForceWithVirial& forceWithVirialSlow = *forceWithVirialLongRange;
+        if (vsite)
+        {
+            const gmx::VirtualSitesHandler::VirialHandling virialHandling =
+                    (stepWork.computeVirial ? gmx::VirtualSitesHandler::VirialHandling::NonLinear
+                                            : gmx::VirtualSitesHandler::VirialHandling::None);
+            matrix virial = { { 0 } };
+            vsite->spreadForces(x.unpaddedArrayRef(), forceWithVirialSlow.force_, virialHandling,
+                                {}, virial, nrnb, box, wcycle);
+            forceWithVirialSlow.addVirialContribution(virial);
+        }
+        if (stepWork.computeVirial)
+        {
+            m_add(vir_force, forceWithVirialSlow.getVirial(), vir_force);
+        }
+
+        /* The slow forces are integrated with an mtsFactor times larger time step
+         * at steps that are a multiple of mtsFactor and not at all at extra
+         * energy or virial steps.
+         */
+        const real mtsFactor = (step % inputrec->mtsFactor == 0 ? inputrec->mtsFactor : 0);
+        combineMtsForces(mdatoms->homenr, forceOut.forceWithShiftForces().force(),
+                         forceWithVirialSlow.force_, mtsFactor);
+    }
+
     if (stepWork.computeEnergy)
     {
         /* Compute the final potential energy terms */
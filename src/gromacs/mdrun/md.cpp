@@ -55,6 +55,7 @@
 #include "gromacs/awh/awh.h"
 #include "gromacs/commandline/filenm.h"
 #include "gromacs/domdec/collect.h"
+#include "gromacs/domdec/dlb.h"
 #include "gromacs/domdec/dlbtiming.h"
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/domdec/domdec_network.h"
@@ -182,6 +183,7 @@ void gmx::LegacySimulator::do_md()
     gmx_bool                    bTemp, bPres, bTrotter;
     real                        dvdl_constr;
     std::vector<RVec>           cbuf;
+    std::vector<RVec>           vMtsSaved;
     matrix                      lastbox;
     int                         lamnew = 0;
     /* for FEP */
@@ -304,6 +306,11 @@ void gmx::LegacySimulator::do_md()
     /* Check for polarizable models and flexible constraints */
     shellfc = init_shell_flexcon(fplog, top_global, constr ? constr->numFlexibleConstraints() : 0,
                                  ir->nstcalcenergy, DOMAINDECOMP(cr));
+    if (shellfc && ir->useMts)
+    {
+        gmx_fatal(FARGS,
+                  "Multiple time stepping is not supported with shells or flexible constraints");
+    }
 
     {
         double io = compute_io(ir, top_global->natoms, *groups, energyOutput.numEnergyTerms(), 1);
@@ -843,6 +850,18 @@ void gmx::LegacySimulator::do_md()
                 shouldCheckNumberOfBondedInteractions = true;
                 upd.setNumAtoms(state->natoms);
 
+                /* Tuning the pruning interval changes the cost per step,
+                 * which would bias the DLB decision based on these costs.
+                 */
+                if (dd_dlb_is_comparing_cycles(cr->dd))
+                {
+                    fr->nbv->lockDynamicPruningTuning();
+                }
+                else if (!(bPMETune && pme_loadbal_is_active(pme_loadbal)))
+                {
+                    fr->nbv->unlockDynamicPruningTuning();
+                }
+
                 // Allocate or re-size GPU halo exchange object, if necessary
                 if (havePPDomainDecomposition(cr) && simulationWork.useGpuHaloExchange
                     && useGpuForNonbonded && is1D(*cr->dd))
@@ -1299,13 +1318,39 @@ void gmx::LegacySimulator::do_md()
         }
         else
         {
-            upd.update_coords(*ir, step, mdatoms, state, f.arrayRefWithPadding(), fcdata, ekind, M,
-                              etrtPOSITION, cr, constr != nullptr);
+            /* With multiple time stepping we integrate with the combination
+             * of the fast and scaled slow forces. The constraint virial should
+             * be computed with the actual total forces, so at virial steps we
+             * do an extra update and constraining with those and restore
+             * the velocities afterwards.
+             */
+            const bool useMtsForces = (ir->useMts && runScheduleWork->stepWork.computeSlowForces);
+            const bool computeMtsConstraintVirial = (ir->useMts && bCalcVir && constr != nullptr);
+            if (computeMtsConstraintVirial)
+            {
+                vMtsSaved.assign(state->v.begin(), state->v.begin() + mdatoms->homenr);
+
+                upd.update_coords(*ir, step, mdatoms, state, f.arrayRefWithPadding(), fcdata, ekind,
+                                  M, etrtPOSITION, cr, true);
+
+                real dvdlMtsVirial = 0;
+                constrain_coordinates(constr, false, false, step, state,
+                                      upd.xp()->arrayRefWithPadding(), &dvdlMtsVirial, true,
+                                      shake_vir);
+
+                std::copy(vMtsSaved.begin(), vMtsSaved.end(), state->v.begin());
+            }
+
+            upd.update_coords(*ir, step, mdatoms, state,
+                              useMtsForces ? fr->forceHelperBuffers->forceMtsCombined()
+                                           : f.arrayRefWithPadding(),
+                              fcdata, ekind, M, etrtPOSITION, cr, constr != nullptr);
 
             wallcycle_stop(wcycle, ewcUPDATE);
 
             constrain_coordinates(constr, do_log, do_ene, step, state,
-                                  upd.xp()->arrayRefWithPadding(), &dvdl_constr, bCalcVir, shake_vir);
+                                  upd.xp()->arrayRefWithPadding(), &dvdl_constr,
+                                  bCalcVir && !computeMtsConstraintVirial, shake_vir);
 
             upd.update_sd_second_half(*ir, step, &dvdl_constr, mdatoms, state, cr, nrnb, wcycle,
                                       constr, do_log, do_ene);
@@ -1398,7 +1398,8 @@ int Mdrunner::mdrunner()
         }
 
         fr->nbv = Nbnxm::init_nb_verlet(mdlog, inputrec, fr, cr, *hwinfo, useGpuForNonbonded,
-                                        deviceStreamManager.get(), &mtop, box, wcycle);
+                                        deviceStreamManager.get(), &mtop, box, wcycle,
+                                        !mdrunOptions.reproducible);
         // TODO: Move the logic below to a GPU bonded builder
         if (useGpuForBonded)
         {
@@ -42,6 +42,7 @@
 #include <memory>
 #include <vector>
 
+#include "gromacs/math/paddedvector.h"
 #include "gromacs/math/vectypes.h"
 #include "gromacs/mdtypes/md_enums.h"
 #include "gromacs/pbcutil/pbc.h"
@@ -141,9 +142,10 @@ public:
      * When the forces that will be accumulated with help of these buffers
      * have direct virial contributions, set the parameter to true, so
      * an extra force buffer is available for these forces to enable
-     * correct virial computation.
+     * correct virial computation. With multiple time stepping, set
+     * \p useMts, so a buffer for the slow forces is available.
      */
-    ForceHelperBuffers(bool haveDirectVirialContributions);
+    ForceHelperBuffers(bool haveDirectVirialContributions, bool useMts);
 
     //! Returns whether we have a direct virial contribution force buffer
     bool haveDirectVirialContributions() const { return haveDirectVirialContributions_; }
@@ -155,10 +157,21 @@ public:
         return forceBufferForDirectVirialContributions_;
     }
 
+    /*! \brief Returns the multiple time stepping force buffer
+     *
+     * This buffer first receives the slow forces and then stores
+     * the combination of fast and scaled slow forces used for integration.
+     */
+    gmx::ArrayRefWithPadding<gmx::RVec> forceMtsCombined()
+    {
+        GMX_ASSERT(useMts_, "Buffer can only be requested with multiple time stepping");
+        return forceMtsCombined_.arrayRefWithPadding();
+    }
+
     //! Returns the buffer for shift forces, size SHIFTS
     gmx::ArrayRef<gmx::RVec> shiftForces() { return shiftForces_; }
 
-    //! Resizes the direct virial contribution buffer, when present
+    //! Resizes the direct virial contribution and MTS buffers, when present
     void resize(int numAtoms);
 
 private:
@@ -166,6 +179,10 @@ private:
     bool haveDirectVirialContributions_ = false;
     //! Force buffer for force computation with direct virial contributions
     std::vector<gmx::RVec> forceBufferForDirectVirialContributions_;
+    //! Whether we use multiple time stepping
+    bool useMts_ = false;
+    //! Force buffer for the slow and combined forces with multiple time stepping
+    gmx::PaddedVector<gmx::RVec> forceMtsCombined_;
     //! Shift force array for computing the virial, size SHIFTS
     std::vector<gmx::RVec> shiftForces_;
 };
@@ -81,6 +81,11 @@ public:
     bool computeListedForces = false;
     //! Whether this step DHDL needs to be computed
     bool computeDhdl = false;
+    /*! \brief Whether the slow, long-range nonbonded forces need to be computed this step
+     *
+     * Always set without multiple time stepping.
+     */
+    bool computeSlowForces = false;
     /*! \brief Whether coordinate buffer ops are done on the GPU this step
      * \note This technically belongs to DomainLifetimeWorkload but due
      * to needing the flag before DomainLifetimeWorkload is built we keep
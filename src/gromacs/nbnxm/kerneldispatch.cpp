@@ -55,6 +55,7 @@
 #include "gromacs/nbnxm/gpu_data_mgmt.h"
 #include "gromacs/nbnxm/nbnxm.h"
 #include "gromacs/simd/simd.h"
+#include "gromacs/timing/cyclecounter.h"
 #include "gromacs/timing/wallcycle.h"
 #include "gromacs/utility/gmxassert.h"
 #include "gromacs/utility/real.h"
@@ -431,11 +432,21 @@ void nonbonded_verlet_t::dispatchNonbondedKernel(gmx::InteractionLocality   iLoc
         case Nbnxm::KernelType::Cpu4x4_PlainC:
         case Nbnxm::KernelType::Cpu4xN_Simd_4xN:
         case Nbnxm::KernelType::Cpu4xN_Simd_2xNN:
+        {
+            const bool         countCycles = pairlistSets().isTuningDynamicPruning();
+            const gmx_cycles_t cyclesStart = (countCycles ? gmx_cycles_read() : 0);
+
             nbnxn_kernel_cpu(pairlistSet, kernelSetup(), nbat.get(), ic, fr.shift_vec, stepWork,
                              clearF, enerd->grpp.ener[egCOULSR].data(),
                              fr.bBHAM ? enerd->grpp.ener[egBHAMSR].data() : enerd->grpp.ener[egLJSR].data(),
                              wcycle_);
+
+            if (countCycles)
+            {
+                pairlistSets_->addDynamicPruningCycles(gmx_cycles_read() - cyclesStart);
+            }
             break;
+        }
 
         case Nbnxm::KernelType::Gpu8x8x8:
             Nbnxm::gpu_launch_kernel(gpu_nbv, stepWork, iLocality);
@@ -238,6 +238,16 @@ void nonbonded_verlet_t::changePairlistRadii(real rlistOuter, real rlistInner)
     pairlistSets_->changePairlistRadii(rlistOuter, rlistInner);
 }
 
+void nonbonded_verlet_t::lockDynamicPruningTuning()
+{
+    pairlistSets_->lockDynamicPruningTuning();
+}
+
+void nonbonded_verlet_t::unlockDynamicPruningTuning()
+{
+    pairlistSets_->unlockDynamicPruningTuning();
+}
+
 void nonbonded_verlet_t::setupGpuShortRangeWork(const gmx::GpuBonded*          gpuBonded,
                                                 const gmx::InteractionLocality iLocality)
 {
@@ -379,6 +379,16 @@ public:
     //! Changes the pair-list outer and inner radius
     void changePairlistRadii(real rlistOuter, real rlistInner);
 
+    /*! \brief Locks the tuning of the dynamic pruning interval to the initial setup
+     *
+     * This should be used while other tuning, such as PME load balancing,
+     * is measuring performance.
+     */
+    void lockDynamicPruningTuning();
+
+    //! Unlocks the tuning of the dynamic pruning interval, tuning restarts at the next search step
+    void unlockDynamicPruningTuning();
+
     //! Set up internal flags that indicate what type of short-range work there is.
     void setupGpuShortRangeWork(const gmx::GpuBonded* gpuBonded, gmx::InteractionLocality iLocality);
 
@@ -405,7 +415,11 @@ public:
 namespace Nbnxm
 {
 
-/*! \brief Creates an Nbnxm object */
+/*! \brief Creates an Nbnxm object
+ *
+ * When \p allowPruningTuning is true, the dynamic pruning interval of
+ * CPU pair lists can be tuned during the run.
+ */
 std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
                                                    const t_inputrec*    ir,
                                                    const t_forcerec*    fr,
@@ -415,7 +429,8 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
                                                    const gmx::DeviceStreamManager* deviceStreamManager,
                                                    const gmx_mtop_t*               mtop,
                                                    matrix                          box,
-                                                   gmx_wallcycle*                  wcycle);
+                                                   gmx_wallcycle*                  wcycle,
+                                                   bool                            allowPruningTuning);
 
 } // namespace Nbnxm
 
@@ -303,11 +303,13 @@ static KernelSetup pick_nbnxn_kernel(const gmx::MDLogger&     mdlog,
 
 } // namespace Nbnxm
 
-PairlistSets::PairlistSets(const PairlistParams& pairlistParams,
-                           const bool            haveMultipleDomains,
-                           const int             minimumIlistCountForGpuBalancing) :
+PairlistSets::PairlistSets(const PairlistParams&                pairlistParams,
+                           const bool                           haveMultipleDomains,
+                           const int                            minimumIlistCountForGpuBalancing,
+                           std::unique_ptr<DynamicPruningTuner> pruningTuner) :
     params_(pairlistParams),
-    minimumIlistCountForGpuBalancing_(minimumIlistCountForGpuBalancing)
+    minimumIlistCountForGpuBalancing_(minimumIlistCountForGpuBalancing),
+    pruningTuner_(std::move(pruningTuner))
 {
     localSet_ = std::make_unique<PairlistSet>(gmx::InteractionLocality::Local, params_);
 
@@ -366,7 +368,8 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
                                                    const gmx::DeviceStreamManager* deviceStreamManager,
                                                    const gmx_mtop_t*               mtop,
                                                    matrix                          box,
-                                                   gmx_wallcycle*                  wcycle)
+                                                   gmx_wallcycle*                  wcycle,
+                                                   const bool                      allowPruningTuning)
 {
     const bool emulateGpu = (getenv("GMX_EMULATE_GPU") != nullptr);
 
@@ -395,7 +398,8 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
     bool           bFEP_NonBonded = (fr->efep != efepNO) && haveFepPerturbedNBInteractions(*mtop);
     PairlistParams pairlistParams(kernelSetup.kernelType, bFEP_NonBonded, ir->rlist, haveMultipleDomains);
 
-    setupDynamicPairlistPruning(mdlog, ir, mtop, box, fr->ic, &pairlistParams);
+    std::unique_ptr<DynamicPruningTuner> pruningTuner = setupDynamicPairlistPruning(
+            mdlog, ir, mtop, box, fr->ic, allowPruningTuning, &pairlistParams);
 
     int enbnxninitcombrule;
     if (fr->ic->vdwtype == evdwCUT
@@ -455,8 +459,8 @@ std::unique_ptr<nonbonded_verlet_t> init_nb_verlet(const gmx::MDLogger& mdlog,
         minimumIlistCountForGpuBalancing = getMinimumIlistCountForGpuBalancing(gpu_nbv);
     }
 
-    auto pairlistSets = std::make_unique<PairlistSets>(pairlistParams, haveMultipleDomains,
-                                                       minimumIlistCountForGpuBalancing);
+    auto pairlistSets = std::make_unique<PairlistSets>(
+            pairlistParams, haveMultipleDomains, minimumIlistCountForGpuBalancing, std::move(pruningTuner));
 
     auto pairSearch = std::make_unique<PairSearch>(
             ir->pbcType, EI_TPI(ir->eI), DOMAINDECOMP(cr) ? &cr->dd->numCells : nullptr,
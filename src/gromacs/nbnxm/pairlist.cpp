@@ -4224,6 +4224,11 @@ void PairlistSets::construct(const InteractionLocality iLocality,
     if (iLocality == InteractionLocality::Local)
     {
         outerListCreationStep_ = step;
+
+        if (pruningTuner_)
+        {
+            pruningTuner_->startNewList(step, &params_);
+        }
     }
     else
     {
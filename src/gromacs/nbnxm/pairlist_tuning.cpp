@@ -50,7 +50,10 @@
 #include <cstdlib>
 
 #include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "gromacs/domdec/domdec.h"
 #include "gromacs/hardware/cpuinfo.h"
@@ -61,6 +64,7 @@
 #include "gromacs/mdtypes/interaction_const.h"
 #include "gromacs/mdtypes/state.h"
 #include "gromacs/pbcutil/pbc.h"
+#include "gromacs/timing/wallcycle.h"
 #include "gromacs/topology/topology.h"
 #include "gromacs/utility/cstringutil.h"
 #include "gromacs/utility/fatalerror.h"
@@ -483,13 +487,82 @@ static std::string formatListSetup(const std::string& listName,
     return listSetup;
 }
 
-void setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
-                                 const t_inputrec*          ir,
-                                 const gmx_mtop_t*          mtop,
-                                 matrix                     box,
-                                 const interaction_const_t* ic,
-                                 PairlistParams*            listParams)
+/*! \brief Returns a tuner for the dynamic pruning interval of CPU lists
+ *
+ * The candidates are a roughly geometric series of intervals, plus the
+ * interval chosen at setup, for which the inner list is still
+ * significantly smaller than the outer list.
+ *
+ * \param[in] mdlog       MD logger
+ * \param[in] ir          The input parameter record
+ * \param[in] mtop        The global topology
+ * \param[in] box         The unit cell
+ * \param[in] listSetup   The nbnxn pair list setup
+ * \param[in] listParams  The list setup parameters, with dynamic pruning enabled
+ */
+static std::unique_ptr<DynamicPruningTuner> makeDynamicPruningTuner(const gmx::MDLogger& mdlog,
+                                                                    const t_inputrec*    ir,
+                                                                    const gmx_mtop_t*    mtop,
+                                                                    const matrix         box,
+                                                                    const VerletbufListSetup& listSetup,
+                                                                    const PairlistParams& listParams)
 {
+    std::vector<int> candidates;
+    int              interval = 2;
+    while (interval < listParams.lifetime)
+    {
+        candidates.push_back(interval);
+        interval = std::max(interval + 1, (interval * 5) / 4);
+    }
+    candidates.push_back(listParams.nstlistPrune);
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    const real rlistInc =
+            nbnxn_get_rlist_effective_inc(listSetup.cluster_size_j, mtop->natoms / det(box));
+
+    std::vector<int>  nstlistPrune;
+    std::vector<real> rlistInner;
+    int               initialCandidate = -1;
+    for (int candidate : candidates)
+    {
+        /* With CPU lists we prune after updating, so the list lifetime
+         * is one step shorter than the pruning interval.
+         */
+        const real rlist =
+                calcVerletBufferSize(*mtop, det(box), *ir, candidate, candidate - 1, -1, listSetup);
+        /* Use the same criterion as for enabling dynamic pruning */
+        if (candidate == listParams.nstlistPrune
+            || rlist + rlistInc < 0.99 * (listParams.rlistOuter + rlistInc))
+        {
+            if (candidate == listParams.nstlistPrune)
+            {
+                initialCandidate = nstlistPrune.size();
+            }
+            nstlistPrune.push_back(candidate);
+            /* Ensure we do not deviate from the setup value due to rounding */
+            rlistInner.push_back(candidate == listParams.nstlistPrune ? listParams.rlistInner : rlist);
+        }
+    }
+
+    if (nstlistPrune.size() < 2)
+    {
+        return nullptr;
+    }
+
+    return std::make_unique<DynamicPruningTuner>(mdlog, nstlistPrune, rlistInner, initialCandidate);
+}
+
+std::unique_ptr<DynamicPruningTuner> setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
+                                                                 const t_inputrec*          ir,
+                                                                 const gmx_mtop_t*          mtop,
+                                                                 matrix                     box,
+                                                                 const interaction_const_t* ic,
+                                                                 const bool      allowOnlineTuning,
+                                                                 PairlistParams* listParams)
+{
+    std::unique_ptr<DynamicPruningTuner> pruningTuner;
+
     GMX_RELEASE_ASSERT(listParams->rlistOuter > 0, "With the nbnxn setup rlist should be > 0");
 
     /* Initialize the parameters to no dynamic list pruning */
@@ -537,6 +610,12 @@ void setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
         setDynamicPairlistPruningParameters(ir, mtop, box, useGpuList, ls, userSetNstlistPrune, ic,
                                             listParams);
 
+        if (listParams->useDynamicPruning && !useGpuList && !userSetNstlistPrune
+            && allowOnlineTuning && wallcycle_have_counter())
+        {
+            pruningTuner = makeDynamicPruningTuner(mdlog, ir, mtop, box, ls, *listParams);
+        }
+
         if (listParams->useDynamicPruning && useGpuList)
         {
             /* Note that we can round down here. This makes the effective
@@ -567,6 +646,10 @@ void setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
         mesg += formatListSetup("outer", ir->nstlist, ir->nstlist, listParams->rlistOuter, interactionCutoff);
         mesg += formatListSetup("inner", listParams->nstlistPrune, ir->nstlist,
                                 listParams->rlistInner, interactionCutoff);
+        if (pruningTuner)
+        {
+            mesg += "  the inner list update interval will be tuned during the run\n";
+        }
     }
     else
     {
@@ -602,4 +685,138 @@ void setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
     }
 
     GMX_LOG(mdlog.info).asParagraph().appendText(mesg);
+
+    return pruningTuner;
+}
+
+//! The number of pair list lifetimes to measure for each pruning interval
+static constexpr int c_numListsPerPruningCandidate = 3;
+
+DynamicPruningTuner::DynamicPruningTuner(const gmx::MDLogger& mdlog,
+                                         std::vector<int>     nstlistPrune,
+                                         std::vector<real>    rlistInner,
+                                         const int            initialCandidate) :
+    mdlog_(mdlog),
+    nstlistPrune_(std::move(nstlistPrune)),
+    rlistInner_(std::move(rlistInner)),
+    cyclesPerStep_(nstlistPrune_.size(), -1),
+    initialCandidate_(initialCandidate),
+    currentCandidate_(initialCandidate),
+    bestCandidate_(initialCandidate),
+    direction_(1),
+    numListsMeasured_(0),
+    numStepsMeasured_(0),
+    cyclesMeasured_(0),
+    cycles_(0),
+    listCreationStep_(-1),
+    isWarmupList_(true),
+    isLocked_(false),
+    isDone_(false)
+{
+    GMX_RELEASE_ASSERT(nstlistPrune_.size() == rlistInner_.size(),
+                       "We need an inner cut-off for each pruning interval");
+    GMX_RELEASE_ASSERT(initialCandidate_ >= 0 && initialCandidate_ < gmx::ssize(nstlistPrune_),
+                       "The initial candidate should be one of the candidates");
+}
+
+void DynamicPruningTuner::selectCandidate(const int candidate, PairlistParams* params)
+{
+    currentCandidate_    = candidate;
+    numListsMeasured_    = 0;
+    numStepsMeasured_    = 0;
+    cyclesMeasured_      = 0;
+    params->nstlistPrune = nstlistPrune_[candidate];
+    params->rlistInner   = rlistInner_[candidate];
+}
+
+void DynamicPruningTuner::startNewList(const int64_t step, PairlistParams* params)
+{
+    if (!isMeasuring())
+    {
+        return;
+    }
+
+    if (!isWarmupList_)
+    {
+        numListsMeasured_++;
+        numStepsMeasured_ += step - listCreationStep_;
+        cyclesMeasured_ += static_cast<double>(cycles_);
+    }
+    /* The first list, after the start or a restart, is used as warm-up */
+    isWarmupList_     = (listCreationStep_ < 0);
+    listCreationStep_ = step;
+    cycles_           = 0;
+
+    if (numListsMeasured_ < c_numListsPerPruningCandidate)
+    {
+        return;
+    }
+
+    cyclesPerStep_[currentCandidate_] = cyclesMeasured_ / numStepsMeasured_;
+
+    int nextCandidate = -1;
+    if (currentCandidate_ == initialCandidate_
+        || cyclesPerStep_[currentCandidate_] < cyclesPerStep_[bestCandidate_])
+    {
+        /* Continue in the same direction while we are getting faster */
+        bestCandidate_ = currentCandidate_;
+        nextCandidate  = currentCandidate_ + direction_;
+    }
+    if ((nextCandidate < 0 || nextCandidate >= gmx::ssize(nstlistPrune_)) && direction_ > 0
+        && bestCandidate_ == initialCandidate_)
+    {
+        /* Longer intervals are not faster, try shorter ones */
+        direction_    = -1;
+        nextCandidate = initialCandidate_ - 1;
+    }
+
+    if (nextCandidate >= 0 && nextCandidate < gmx::ssize(nstlistPrune_))
+    {
+        selectCandidate(nextCandidate, params);
+    }
+    else
+    {
+        selectCandidate(bestCandidate_, params);
+        isDone_ = true;
+
+        GMX_LOG(mdlog_.info)
+                .asParagraph()
+                .appendTextFormatted(
+                        "Tuned the dynamic pruning of the inner pair list to every %d steps, "
+                        "rlist %.3f nm",
+                        params->nstlistPrune, params->rlistInner);
+    }
+}
+
+void DynamicPruningTuner::lock(PairlistParams* params)
+{
+    if (!isLocked_)
+    {
+        selectCandidate(initialCandidate_, params);
+        isLocked_ = true;
+    }
+}
+
+void DynamicPruningTuner::unlock()
+{
+    if (isLocked_)
+    {
+        isLocked_         = false;
+        isDone_           = false;
+        bestCandidate_    = initialCandidate_;
+        direction_        = 1;
+        listCreationStep_ = -1;
+        isWarmupList_     = true;
+        std::fill(cyclesPerStep_.begin(), cyclesPerStep_.end(), -1);
+    }
+}
+
+void DynamicPruningTuner::changeInnerRadius(const real rlistInner, PairlistParams* params)
+{
+    const real shift = rlistInner - rlistInner_[initialCandidate_];
+    for (real& rlist : rlistInner_)
+    {
+        rlist += shift;
+    }
+    selectCandidate(initialCandidate_, params);
 }
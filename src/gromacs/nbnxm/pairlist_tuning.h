@@ -48,7 +48,13 @@
 
 #include <stdio.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 #include "gromacs/math/vectypes.h"
+#include "gromacs/timing/cyclecounter.h"
+#include "gromacs/utility/real.h"
 
 namespace gmx
 {
@@ -82,20 +88,118 @@ void increaseNstlist(FILE*               fplog,
                      bool                useOrEmulateGpuForNonbondeds,
                      const gmx::CpuInfo& cpuinfo);
 
+/*! \internal
+ * \brief Tunes the dynamic pruning interval of CPU pair lists during the run
+ *
+ * Each candidate pruning interval comes with an inner list cut-off
+ * that gives the same drift tolerance. The tuner measures the cycles
+ * spent in the pruning and non-bonded kernels over a few pair list
+ * lifetimes for a candidate, starting at the interval chosen at setup.
+ * It then moves to neighboring candidates as long as the cost per step
+ * decreases and finally locks in the fastest interval.
+ * All changes are applied at pair search steps.
+ * Ranks tune independently, since pruning only affects the local lists.
+ * As all ranks switch candidates at the same search steps, tuning causes
+ * little load imbalance between ranks. But it changes the cost per step,
+ * so mdrun locks the tuning during PME tuning and while DLB compares
+ * the cycles per step with and without DLB.
+ */
+class DynamicPruningTuner
+{
+public:
+    /*! \brief Constructor
+     *
+     * \param[in] mdlog             Logger for reporting the tuned interval
+     * \param[in] nstlistPrune      The candidate pruning intervals, sorted
+     * \param[in] rlistInner        The inner list cut-off for each candidate
+     * \param[in] initialCandidate  Index of the candidate chosen at setup
+     */
+    DynamicPruningTuner(const gmx::MDLogger& mdlog,
+                        std::vector<int>     nstlistPrune,
+                        std::vector<real>    rlistInner,
+                        int                  initialCandidate);
+
+    //! Returns whether kernel cycles are currently being measured
+    bool isMeasuring() const { return !isLocked_ && !isDone_; }
+
+    //! Adds the cycles spent in a call to the pruning or non-bonded kernel
+    void addCycles(gmx_cycles_t cycles) { cycles_ += cycles; }
+
+    /*! \brief Processes the measurement of the previous list and applies
+     * the candidate to use for the list created at \p step to \p params
+     */
+    void startNewList(int64_t step, PairlistParams* params);
+
+    //! Locks the pruning setup to the initial candidate, applied to \p params
+    void lock(PairlistParams* params);
+
+    //! Releases the lock and restarts tuning at the next search step
+    void unlock();
+
+    /*! \brief Shifts all inner cut-offs when the cut-off changes, restores the initial candidate
+     *
+     * \p rlistInner should be the inner cut-off for the initial candidate.
+     */
+    void changeInnerRadius(real rlistInner, PairlistParams* params);
+
+private:
+    //! Sets the parameters for \p candidate and resets the measurement
+    void selectCandidate(int candidate, PairlistParams* params);
+
+    //! Reference to the logger
+    const gmx::MDLogger& mdlog_;
+    //! The candidate pruning intervals
+    std::vector<int> nstlistPrune_;
+    //! The inner list cut-off for each candidate
+    std::vector<real> rlistInner_;
+    //! Average cycles per step for each candidate, -1 when not measured
+    std::vector<double> cyclesPerStep_;
+    //! The candidate chosen at setup
+    int initialCandidate_;
+    //! The candidate currently in use
+    int currentCandidate_;
+    //! The fastest candidate measured so far
+    int bestCandidate_;
+    //! The direction we move in through the candidates
+    int direction_;
+    //! The number of lists measured for the current candidate
+    int numListsMeasured_;
+    //! The number of steps measured for the current candidate
+    int64_t numStepsMeasured_;
+    //! The cycles measured for the current candidate
+    double cyclesMeasured_;
+    //! Cycles accumulated for the current list
+    gmx_cycles_t cycles_;
+    //! The creation step of the current list, -1 before the first list
+    int64_t listCreationStep_;
+    //! Whether the current list is a warm-up list that is not measured
+    bool isWarmupList_;
+    //! Whether tuning is locked to the initial candidate
+    bool isLocked_;
+    //! Whether we have finished tuning
+    bool isDone_;
+};
+
 /*! \brief Set up the dynamic pairlist pruning
  *
- * \param[in,out] mdlog            MD logger
- * \param[in]     ir               The input parameter record
- * \param[in]     mtop             The global topology
- * \param[in]     box              The unit cell
- * \param[in]     ic               The nonbonded interactions constants
- * \param[in,out] listParams       The list setup parameters
+ * With CPU pair lists, when the pruning interval has not been set by
+ * the user and \p allowOnlineTuning is true, returns a tuner for
+ * the pruning interval, otherwise returns nullptr.
+ *
+ * \param[in,out] mdlog             MD logger
+ * \param[in]     ir                The input parameter record
+ * \param[in]     mtop              The global topology
+ * \param[in]     box               The unit cell
+ * \param[in]     ic                The nonbonded interactions constants
+ * \param[in]     allowOnlineTuning Whether the pruning interval may be tuned during the run
+ * \param[in,out] listParams        The list setup parameters
  */
-void setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
-                                 const t_inputrec*          ir,
-                                 const gmx_mtop_t*          mtop,
-                                 matrix                     box,
-                                 const interaction_const_t* ic,
-                                 PairlistParams*            listParams);
+std::unique_ptr<DynamicPruningTuner> setupDynamicPairlistPruning(const gmx::MDLogger&       mdlog,
+                                                                 const t_inputrec*          ir,
+                                                                 const gmx_mtop_t*          mtop,
+                                                                 matrix                     box,
+                                                                 const interaction_const_t* ic,
+                                                                 bool            allowOnlineTuning,
+                                                                 PairlistParams* listParams);
 
 #endif /* NBNXM_PAIRLIST_TUNING_H */
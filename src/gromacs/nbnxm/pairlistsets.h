@@ -51,7 +51,9 @@
 #include <memory>
 
 #include "gromacs/mdtypes/locality.h"
+#include "gromacs/timing/cyclecounter.h"
 
+#include "pairlist_tuning.h"
 #include "pairlistparams.h"
 
 struct nbnxn_atomdata_t;
@@ -70,10 +72,11 @@ class ListOfLists;
 class PairlistSets
 {
 public:
-    //! Constructor
-    PairlistSets(const PairlistParams& pairlistParams,
-                 bool                  haveMultipleDomains,
-                 int                   minimumIlistCountForGpuBalancing);
+    //! Constructor, \p pruningTuner can be nullptr
+    PairlistSets(const PairlistParams&                pairlistParams,
+                 bool                                 haveMultipleDomains,
+                 int                                  minimumIlistCountForGpuBalancing,
+                 std::unique_ptr<DynamicPruningTuner> pruningTuner);
 
     //! Construct the pairlist set for the given locality
     void construct(gmx::InteractionLocality     iLocality,
@@ -117,6 +120,34 @@ public:
     {
         params_.rlistOuter = rlistOuter;
         params_.rlistInner = rlistInner;
+        if (pruningTuner_)
+        {
+            pruningTuner_->changeInnerRadius(rlistInner, &params_);
+        }
+    }
+
+    //! Returns whether the dynamic pruning interval is being tuned using kernel cycle counts
+    bool isTuningDynamicPruning() const { return pruningTuner_ && pruningTuner_->isMeasuring(); }
+
+    //! Adds cycles spent in the pruning or non-bonded kernel to the dynamic pruning tuning
+    void addDynamicPruningCycles(gmx_cycles_t cycles) { pruningTuner_->addCycles(cycles); }
+
+    //! Locks the dynamic pruning tuning to the initial setup, does nothing when not tuning
+    void lockDynamicPruningTuning()
+    {
+        if (pruningTuner_)
+        {
+            pruningTuner_->lock(&params_);
+        }
+    }
+
+    //! Unlocks the dynamic pruning tuning, does nothing when not tuning
+    void unlockDynamicPruningTuning()
+    {
+        if (pruningTuner_)
+        {
+            pruningTuner_->unlock();
+        }
     }
 
     //! Returns the pair-list set for the given locality
@@ -158,6 +189,8 @@ private:
     std::unique_ptr<PairlistSet> nonlocalSet_;
     //! MD step at with the outer lists in pairlistSets_ were created
     int64_t outerListCreationStep_;
+    //! Tuner for the dynamic pruning interval, nullptr when not tuning
+    std::unique_ptr<DynamicPruningTuner> pruningTuner_;
 };
 
 #endif
@@ -0,0 +1,298 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+/*! \internal \file
+ * \brief
+ * Tests for the online tuning of the dynamic pruning interval.
+ *
+ * The tuner is fed synthetic kernel cycle counts, so the tests
+ * check the search over the candidates independently of timings.
+ *
+ * \ingroup module_nbnxm
+ */
+#include "gmxpre.h"
+
+#include "gromacs/nbnxm/pairlist_tuning.h"
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/nbnxm/nbnxm.h"
+#include "gromacs/nbnxm/pairlistparams.h"
+#include "gromacs/utility/logger.h"
+
+#include "testutils/testasserts.h"
+
+namespace
+{
+
+//! The number of steps between pair searches
+constexpr int c_nstlist = 20;
+
+//! The candidate pruning intervals used in all tests
+const std::vector<int> c_nstlistPrune = { 2, 4, 6, 8, 10 };
+//! The inner list cut-off for each candidate
+const std::vector<real> c_rlistInner = { 0.90, 0.92, 0.94, 0.96, 0.98 };
+
+//! Kernel cycles per step for each pruning interval
+using CycleModel = std::map<int, gmx_cycles_t>;
+
+/*! \brief Test fixture for DynamicPruningTuner
+ *
+ * Mimics the pair search steps of a run. The kernel cycles of each
+ * list are given by a cycle model for the pruning interval in use.
+ */
+class DynamicPruningTunerTest : public ::testing::Test
+{
+public:
+    DynamicPruningTunerTest() :
+        params_(Nbnxm::KernelType::Cpu4x4_PlainC, false, 1.0, false),
+        step_(0)
+    {
+        params_.useDynamicPruning = true;
+    }
+
+    //! Creates the tuner, applies the initial candidate to the list parameters
+    void createTuner(int initialCandidate)
+    {
+        tuner_ = std::make_unique<DynamicPruningTuner>(logger_, c_nstlistPrune, c_rlistInner,
+                                                       initialCandidate);
+        params_.nstlistPrune = c_nstlistPrune[initialCandidate];
+        params_.rlistInner   = c_rlistInner[initialCandidate];
+    }
+
+    //! Creates \p numLists pair lists, adding the cycles given by \p cycleModel for each
+    void runLists(const CycleModel& cycleModel, int numLists)
+    {
+        for (int list = 0; list < numLists; list++)
+        {
+            tuner_->startNewList(step_, &params_);
+            if (tuner_->isMeasuring())
+            {
+                tuner_->addCycles(cycleModel.at(params_.nstlistPrune) * c_nstlist);
+            }
+            step_ += c_nstlist;
+        }
+    }
+
+    /*! \brief Runs lists until tuning has finished
+     *
+     * Returns the sequence of pruning intervals used in the measured lists.
+     */
+    std::vector<int> runUntilDone(const CycleModel& cycleModel)
+    {
+        /* A warm-up list plus three lists per candidate, with margin */
+        const int maxNumLists = 1 + 3 * (static_cast<int>(c_nstlistPrune.size()) + 1);
+
+        std::vector<int> intervals;
+        for (int list = 0; list < maxNumLists && tuner_->isMeasuring(); list++)
+        {
+            if (intervals.empty() || intervals.back() != params_.nstlistPrune)
+            {
+                intervals.push_back(params_.nstlistPrune);
+            }
+            runLists(cycleModel, 1);
+        }
+        EXPECT_FALSE(tuner_->isMeasuring()) << "Tuning should have finished";
+
+        return intervals;
+    }
+
+    //! Logger that does not write anything
+    gmx::MDLogger logger_;
+    //! The pair list parameters the tuner changes
+    PairlistParams params_;
+    //! The tuner
+    std::unique_ptr<DynamicPruningTuner> tuner_;
+    //! The current step
+    int64_t step_;
+};
+
+TEST_F(DynamicPruningTunerTest, MovesToLongerIntervalsWhileFaster)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 10 }));
+    EXPECT_EQ(params_.nstlistPrune, 8);
+    EXPECT_REAL_EQ(params_.rlistInner, c_rlistInner[3]);
+}
+
+TEST_F(DynamicPruningTunerTest, ReversesDirectionWhenLongerIsSlower)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 800 }, { 4, 700 }, { 6, 800 }, { 8, 900 }, { 10, 1000 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 4, 2 }));
+    EXPECT_EQ(params_.nstlistPrune, 4);
+    EXPECT_REAL_EQ(params_.rlistInner, c_rlistInner[1]);
+}
+
+TEST_F(DynamicPruningTunerTest, KeepsInitialWhenFastest)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 900 }, { 10, 1000 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 4 }));
+    EXPECT_EQ(params_.nstlistPrune, 6);
+    EXPECT_REAL_EQ(params_.rlistInner, c_rlistInner[2]);
+}
+
+TEST_F(DynamicPruningTunerTest, StopsAtLongestCandidate)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 600 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 10 }));
+    EXPECT_EQ(params_.nstlistPrune, 10);
+}
+
+TEST_F(DynamicPruningTunerTest, StopsAtShortestCandidate)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 600 }, { 4, 700 }, { 6, 800 }, { 8, 900 }, { 10, 1000 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 4, 2 }));
+    EXPECT_EQ(params_.nstlistPrune, 2);
+}
+
+TEST_F(DynamicPruningTunerTest, ReversesAtLongestInitialCandidate)
+{
+    createTuner(4);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 10, 8, 6 }));
+    EXPECT_EQ(params_.nstlistPrune, 8);
+}
+
+TEST_F(DynamicPruningTunerTest, FirstListIsNotMeasured)
+{
+    createTuner(2);
+    /* Counting these cycles of the warm-up list would make the initial candidate fastest */
+    runLists({ { 6, 1 } }, 1);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+
+    runUntilDone(cycleModel);
+
+    EXPECT_EQ(params_.nstlistPrune, 8);
+}
+
+TEST_F(DynamicPruningTunerTest, LockRestoresInitialAndUnlockRestarts)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+
+    /* Run until we moved on to the next candidate */
+    runLists(cycleModel, 5);
+    EXPECT_EQ(params_.nstlistPrune, 8);
+
+    tuner_->lock(&params_);
+    EXPECT_FALSE(tuner_->isMeasuring());
+    EXPECT_EQ(params_.nstlistPrune, 6);
+    EXPECT_REAL_EQ(params_.rlistInner, c_rlistInner[2]);
+
+    /* While locked the setup does not change, whatever the cycle counts */
+    for (int list = 0; list < 20; list++)
+    {
+        tuner_->startNewList(step_, &params_);
+        tuner_->addCycles(1);
+        step_ += c_nstlist;
+    }
+    EXPECT_EQ(params_.nstlistPrune, 6);
+
+    /* After unlocking, tuning starts over from the initial candidate */
+    tuner_->unlock();
+    EXPECT_TRUE(tuner_->isMeasuring());
+    const std::vector<int> intervals = runUntilDone(cycleModel);
+
+    EXPECT_EQ(intervals, std::vector<int>({ 6, 8, 10 }));
+    EXPECT_EQ(params_.nstlistPrune, 8);
+}
+
+TEST_F(DynamicPruningTunerTest, UnlockAfterTuningRetunes)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+    runUntilDone(cycleModel);
+
+    tuner_->lock(&params_);
+    EXPECT_EQ(params_.nstlistPrune, 6);
+
+    /* With reversed costs, the retuning should now pick a shorter interval */
+    tuner_->unlock();
+    const CycleModel reversedCycleModel = {
+        { 2, 800 }, { 4, 700 }, { 6, 800 }, { 8, 900 }, { 10, 1000 }
+    };
+    runUntilDone(reversedCycleModel);
+
+    EXPECT_EQ(params_.nstlistPrune, 4);
+}
+
+TEST_F(DynamicPruningTunerTest, ChangeInnerRadiusShiftsAllCandidates)
+{
+    createTuner(2);
+    const CycleModel cycleModel = { { 2, 1000 }, { 4, 900 }, { 6, 800 }, { 8, 700 }, { 10, 750 } };
+
+    /* Move on to the next candidate, then change the radius */
+    runLists(cycleModel, 5);
+    EXPECT_EQ(params_.nstlistPrune, 8);
+
+    const real shift = 0.1;
+    tuner_->changeInnerRadius(c_rlistInner[2] + shift, &params_);
+    EXPECT_EQ(params_.nstlistPrune, 6);
+    EXPECT_REAL_EQ(params_.rlistInner, c_rlistInner[2] + shift);
+
+    runUntilDone(cycleModel);
+
+    EXPECT_EQ(params_.nstlistPrune, 8);
+    EXPECT_REAL_EQ_TOL(params_.rlistInner, c_rlistInner[3] + shift,
+                       gmx::test::absoluteTolerance(1e-6));
+}
+
+} // namespace
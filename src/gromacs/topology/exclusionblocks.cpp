@@ -122,20 +122,8 @@ int countAndSortExclusions(gmx::ArrayRef<ExclusionBlock> b2)
         {
             /* remove double entries */
             std::sort(block.atomNumber.begin(), block.atomNumber.end());
-            for (auto atom = block.atomNumber.begin() + 1; atom != block.atomNumber.end();)
-            {
-                GMX_RELEASE_ASSERT(atom < block.atomNumber.end(),
-                                   "Need to stay in range of the size of the blocks");
-                auto prev = atom - 1;
-                if (*prev == *atom)
-                {
-                    atom = block.atomNumber.erase(atom);
-                }
-                else
-                {
-                    ++atom;
-                }
-            }
+            block.atomNumber.erase(std::unique(block.atomNumber.begin(), block.atomNumber.end()),
+                                   block.atomNumber.end());
             nra += block.nra();
         }
     }
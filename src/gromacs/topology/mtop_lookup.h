@@ -62,6 +62,11 @@ struct t_atom;
  * For subsequent calls to this function, e.g. in a loop, pass in the previously
  * returned value for best performance. Atoms in a group tend to be in the same
  * molecule(block), so this minimizes the search time.
+ * When the atom is not in the passed block, the lookup table of \p mtop
+ * restricts the search to the blocks that overlap with a small range
+ * of atoms around the atom. This is usually a single block, so random
+ * access to global atoms is also efficient. In the worst case the cost
+ * is logarithmic in the number of blocks.
  *
  * \param[in]     mtop                 The molecule topology
  * \param[in]     globalAtomIndex      The global atom index to look up
@@ -84,28 +89,45 @@ static inline void mtopGetMolblockIndex(const gmx_mtop_t* mtop,
     GMX_ASSERT(*moleculeBlock < gmx::ssize(mtop->moleculeBlockIndices),
                "The starting molecule block index for the search should be within range");
 
-    /* Search the molecule block index using bisection */
-    int molBlock0 = -1;
-    int molBlock1 = mtop->molblock.size();
-
-    int globalAtomStart;
-    while (TRUE)
+    if (globalAtomIndex < mtop->moleculeBlockIndices[*moleculeBlock].globalAtomStart
+        || globalAtomIndex >= mtop->moleculeBlockIndices[*moleculeBlock].globalAtomEnd)
     {
-        globalAtomStart = mtop->moleculeBlockIndices[*moleculeBlock].globalAtomStart;
-        if (globalAtomIndex < globalAtomStart)
-        {
-            molBlock1 = *moleculeBlock;
-        }
-        else if (globalAtomIndex >= mtop->moleculeBlockIndices[*moleculeBlock].globalAtomEnd)
+        /* The range of blocks that can contain our atom */
+        int molBlock0 = 0;
+        int molBlock1 = gmx::ssize(mtop->moleculeBlockIndices) - 1;
+        if (!mtop->moleculeBlockLookup.empty())
         {
-            molBlock0 = *moleculeBlock;
+            /* Only the blocks that overlap with the bucket of our atom
+             * can contain it, usually this is a single block.
+             */
+            const int bucket = globalAtomIndex >> mtop->moleculeBlockLookupShift;
+            GMX_ASSERT(bucket < gmx::ssize(mtop->moleculeBlockLookup),
+                       "The molblock lookup table should cover all atoms");
+            molBlock0 = mtop->moleculeBlockLookup[bucket];
+            if (bucket + 1 < gmx::ssize(mtop->moleculeBlockLookup))
+            {
+                molBlock1 = mtop->moleculeBlockLookup[bucket + 1];
+            }
         }
-        else
+        /* Search for the last block starting at or before our atom using
+         * bisection. Empty blocks start at the same atom as the next block,
+         * so they are never returned.
+         */
+        while (molBlock0 < molBlock1)
         {
-            break;
+            const int molBlockMiddle = (molBlock0 + molBlock1 + 1) >> 1;
+            if (mtop->moleculeBlockIndices[molBlockMiddle].globalAtomStart <= globalAtomIndex)
+            {
+                molBlock0 = molBlockMiddle;
+            }
+            else
+            {
+                molBlock1 = molBlockMiddle - 1;
+            }
         }
-        *moleculeBlock = ((molBlock0 + molBlock1 + 1) >> 1);
+        *moleculeBlock = molBlock0;
     }
+    const int globalAtomStart = mtop->moleculeBlockIndices[*moleculeBlock].globalAtomStart;
 
     int molIndex = (globalAtomIndex - globalAtomStart)
                    / mtop->moleculeBlockIndices[*moleculeBlock].numAtomsPerMolecule;
@@ -296,4 +318,74 @@ static inline const t_pdbinfo& mtopGetAtomPdbInfo(const gmx_mtop_t* mtop, int gl
     return moltype.atoms.pdbinfo[atomIndexInMolecule];
 }
 
+/*! \brief Random-access view of the atoms of a topology using global atom indices
+ *
+ * Provides the properties of any atom in the system without expanding
+ * the molblock-compressed topology into per-atom arrays, which uses
+ * a lot of memory for large systems. Each access looks up the molblock
+ * using the lookup table of the topology, see mtopGetMolblockIndex().
+ * The view only stores a reference to the topology, so it is cheap
+ * to construct and its methods are thread safe.
+ *
+ * For sequential access to all atoms, AtomRange in mtop_util.h is faster.
+ */
+class GlobalAtomView
+{
+public:
+    //! Constructs a view of the atoms in \p mtop, which should be finalized
+    explicit GlobalAtomView(const gmx_mtop_t& mtop) : mtop_(mtop) {}
+
+    //! Returns the number of atoms in the system
+    int size() const { return mtop_.natoms; }
+    //! Returns the parameters of atom \p globalAtomIndex
+    const t_atom& atom(int globalAtomIndex) const
+    {
+        int moleculeBlock = 0;
+        return mtopGetAtomParameters(&mtop_, globalAtomIndex, &moleculeBlock);
+    }
+    //! Returns the name of atom \p globalAtomIndex
+    const char* atomName(int globalAtomIndex) const
+    {
+        int         moleculeBlock = 0;
+        const char* atomName;
+        mtopGetAtomAndResidueName(mtop_, globalAtomIndex, &moleculeBlock, &atomName, nullptr,
+                                  nullptr, nullptr);
+        return atomName;
+    }
+    //! Returns the residue name of atom \p globalAtomIndex
+    const char* residueName(int globalAtomIndex) const
+    {
+        int moleculeBlock = 0;
+        return *mtopGetResidueInfo(&mtop_, globalAtomIndex, &moleculeBlock).name;
+    }
+    //! Returns the residue number of atom \p globalAtomIndex, renumbered as in the full topology
+    int residueNumber(int globalAtomIndex) const
+    {
+        int moleculeBlock = 0;
+        int residueNumber;
+        mtopGetAtomAndResidueName(mtop_, globalAtomIndex, &moleculeBlock, nullptr,
+                                  &residueNumber, nullptr, nullptr);
+        return residueNumber;
+    }
+    //! Returns the global residue index of atom \p globalAtomIndex
+    int globalResidueIndex(int globalAtomIndex) const
+    {
+        int moleculeBlock = 0;
+        int globalResidueIndex;
+        mtopGetAtomAndResidueName(mtop_, globalAtomIndex, &moleculeBlock, nullptr, nullptr,
+                                  nullptr, &globalResidueIndex);
+        return globalResidueIndex;
+    }
+    //! Returns the global molecule index of atom \p globalAtomIndex
+    int moleculeIndex(int globalAtomIndex) const
+    {
+        int moleculeBlock = 0;
+        return mtopGetMoleculeIndex(&mtop_, globalAtomIndex, &moleculeBlock);
+    }
+
+private:
+    //! The topology we provide a view of
+    const gmx_mtop_t& mtop_;
+};
+
 #endif
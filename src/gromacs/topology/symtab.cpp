@@ -51,6 +51,9 @@
 #include <cstring>
 
 #include <algorithm>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 #include "gromacs/utility/basedefinitions.h"
 #include "gromacs/utility/cstringutil.h"
@@ -63,10 +66,9 @@
 
 StringTableEntry StringTableBuilder::addString(const std::string& theString)
 {
-    int         size     = map_.size();
-    std::string stripped = gmx::stripString(theString);
+    int size = map_.size();
 
-    const auto foundEntry = map_.insert(StringTablePair(stripped, size));
+    const auto foundEntry = map_.try_emplace(gmx::stripString(theString), size);
     return StringTableEntry(foundEntry.first->first, foundEntry.first->second);
 }
 
@@ -174,8 +176,54 @@ void StringTable::copyToLegacySymtab(struct t_symtab* symtab) const
 // Old code for legacy data structure starts below.
 //! Maximum size of character string in table.
 constexpr int c_trimSize = 1024;
-//! Maximum number of entries in each element of the linked list.
-constexpr int c_maxBufSize = 5;
+//! Minimum number of entries in each element of the linked list.
+constexpr int c_minBufSize = 5;
+
+/*! \brief
+ * Hashed lookup of the strings in a legacy symbol table.
+ *
+ * Stored with the first element of the linked list, so that shallow copies
+ * of a t_symtab, which share the list, also share the lookup.
+ */
+struct t_symtab_lookup
+{
+    //! Handles to all strings in the table, in the order of their indices.
+    std::vector<char**> handles;
+    //! Index of each string in the table, the keys point to the stored strings.
+    std::unordered_map<std::string_view, int> indices;
+};
+
+/*! \brief
+ * Returns the lookup of \p symtab, (re)building it when it does not cover all entries.
+ *
+ * \param[inout] symtab Symbol table with at least one element in the linked list.
+ */
+static t_symtab_lookup* symtabLookup(t_symtab* symtab)
+{
+    GMX_ASSERT(symtab->symbuf != nullptr, "Need storage to look up entries in");
+
+    t_symtab_lookup*& lookup = symtab->symbuf->lookup;
+    if (lookup == nullptr)
+    {
+        lookup = new t_symtab_lookup;
+    }
+    if (gmx::ssize(lookup->handles) != symtab->nr)
+    {
+        lookup->handles.clear();
+        lookup->indices.clear();
+        int nr = symtab->nr;
+        for (t_symbuf* symbuf = symtab->symbuf; symbuf != nullptr && nr > 0; symbuf = symbuf->next)
+        {
+            for (int i = 0; i < symbuf->bufsize && nr > 0; i++, nr--)
+            {
+                lookup->indices.emplace(symbuf->buf[i], lookup->handles.size());
+                lookup->handles.push_back(&symbuf->buf[i]);
+            }
+        }
+    }
+
+    return lookup;
+}
 
 /*! \brief
  * Remove leading and trailing whitespace from string and enforce maximum length.
@@ -219,6 +267,17 @@ int lookup_symtab(t_symtab* symtab, char** name)
     int       base;
     t_symbuf* symbuf;
 
+    if (symtab->symbuf != nullptr)
+    {
+        const t_symtab_lookup* lookup = symtabLookup(symtab);
+        const auto             found  = lookup->indices.find(*name);
+        if (found != lookup->indices.end() && lookup->handles[found->second] == name)
+        {
+            return found->second;
+        }
+    }
+
+    /* Fall back to searching the storage, needed when the table has duplicate strings */
     base   = 0;
     symbuf = symtab->symbuf;
     while (symbuf != nullptr)
@@ -241,6 +300,11 @@ char** get_symtab_handle(t_symtab* symtab, int name)
 {
     t_symbuf* symbuf;
 
+    if (symtab->symbuf != nullptr && name >= 0 && name < symtab->nr)
+    {
+        return symtabLookup(symtab)->handles[name];
+    }
+
     symbuf = symtab->symbuf;
     while (symbuf != nullptr)
     {
@@ -257,15 +321,16 @@ char** get_symtab_handle(t_symtab* symtab, int name)
     gmx_fatal(FARGS, "symtab get_symtab_handle %d not found", name);
 }
 
-//! Returns a new initialized entry into the symtab linked list.
-static t_symbuf* new_symbuf()
+//! Returns a new initialized entry with room for \p bufsize strings for the symtab linked list.
+static t_symbuf* new_symbuf(int bufsize)
 {
     t_symbuf* symbuf;
 
     snew(symbuf, 1);
-    symbuf->bufsize = c_maxBufSize;
+    symbuf->bufsize = bufsize;
     snew(symbuf->buf, symbuf->bufsize);
-    symbuf->next = nullptr;
+    symbuf->next   = nullptr;
+    symbuf->lookup = nullptr;
 
     return symbuf;
 }
@@ -273,54 +338,48 @@ static t_symbuf* new_symbuf()
 /*! \brief
  * Low level function to enter new string into legacy symtab.
  *
+ * Existing strings are found through the hashed lookup. New strings are
+ * stored after the last entry. Each new element of the linked list is as
+ * large as the whole table so far, so the list stays short.
+ *
  * \param[inout] symtab Symbol table to add entry to.
  * \param[in]    name   New string to add to symtab.
  * \returns Pointer to new entry in the legacy symbol table, or to existing entry if it already existed.
  */
 static char** enter_buf(t_symtab* symtab, char* name)
 {
-    int       i;
-    t_symbuf* symbuf;
-    gmx_bool  bCont;
-
     if (symtab->symbuf == nullptr)
     {
-        symtab->symbuf = new_symbuf();
+        symtab->symbuf = new_symbuf(c_minBufSize);
     }
 
-    symbuf = symtab->symbuf;
-    do
+    t_symtab_lookup* lookup = symtabLookup(symtab);
+    const auto       found  = lookup->indices.find(name);
+    if (found != lookup->indices.end())
     {
-        for (i = 0; (i < symbuf->bufsize); i++)
-        {
-            if (symbuf->buf[i] == nullptr)
-            {
-                symtab->nr++;
-                symbuf->buf[i] = gmx_strdup(name);
-                return &(symbuf->buf[i]);
-            }
-            else if (strcmp(symbuf->buf[i], name) == 0)
-            {
-                return &(symbuf->buf[i]);
-            }
-        }
-        if (symbuf->next != nullptr)
-        {
-            symbuf = symbuf->next;
-            bCont  = TRUE;
-        }
-        else
+        return lookup->handles[found->second];
+    }
+
+    /* Find the element of the linked list that holds the first free position */
+    t_symbuf* symbuf = symtab->symbuf;
+    int       base   = 0;
+    while (symtab->nr - base >= symbuf->bufsize)
+    {
+        if (symbuf->next == nullptr)
         {
-            bCont = FALSE;
+            symbuf->next = new_symbuf(std::max(c_minBufSize, symtab->nr));
         }
-    } while (bCont);
-
-    symbuf->next = new_symbuf();
-    symbuf       = symbuf->next;
+        base += symbuf->bufsize;
+        symbuf = symbuf->next;
+    }
 
+    char** handle = &(symbuf->buf[symtab->nr - base]);
+    *handle       = gmx_strdup(name);
+    lookup->indices.emplace(*handle, symtab->nr);
+    lookup->handles.push_back(handle);
     symtab->nr++;
-    symbuf->buf[0] = gmx_strdup(name);
-    return &(symbuf->buf[0]);
+
+    return handle;
 }
 
 char** put_symtab(t_symtab* symtab, const char* name)
@@ -388,6 +447,7 @@ void done_symtab(t_symtab* symtab)
         }
         symtab->nr -= i;
         sfree(symbuf->buf);
+        delete symbuf->lookup;
         freeptr = symbuf;
         symbuf  = symbuf->next;
         sfree(freeptr);
@@ -408,6 +468,7 @@ void free_symtab(t_symtab* symtab)
     while (symbuf != nullptr)
     {
         symtab->nr -= std::min(symbuf->bufsize, symtab->nr);
+        delete symbuf->lookup;
         freeptr = symbuf;
         symbuf  = symbuf->next;
         sfree(freeptr);
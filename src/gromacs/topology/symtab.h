@@ -243,6 +243,8 @@ struct t_symbuf
     char** buf;
     //! Next item in linked list.
     struct t_symbuf* next;
+    //! Hashed lookup of the strings in the whole table, only set in the first item.
+    struct t_symtab_lookup* lookup;
 };
 
 /* \libinternal \brief
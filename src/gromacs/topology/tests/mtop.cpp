@@ -43,8 +43,11 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/topology/mtop_lookup.h"
 #include "gromacs/topology/mtop_util.h"
+#include "gromacs/topology/symtab.h"
 #include "gromacs/utility/basedefinitions.h"
+#include "gromacs/utility/stringutil.h"
 
 namespace gmx
 {
@@ -137,6 +140,127 @@ TEST(MtopTest, Operators)
     EXPECT_FALSE(it == otherIt);
 }
 
+/*! \brief
+ * Creates a topology with molecule blocks of the given types and sizes.
+ *
+ * There are three molecule types with 1, 3 and 7 atoms.
+ * Blocks without molecules are allowed, but note that AtomIterator
+ * does not support those.
+ */
+void createManyBlockTopology(gmx_mtop_t*             mtop,
+                             const std::vector<int>& molblockTypes,
+                             const std::vector<int>& molblockNmol)
+{
+    const std::vector<int> numAtomsPerMoltype    = { 1, 3, 7 };
+    const std::vector<int> numResiduesPerMoltype = { 1, 2, 3 };
+    mtop->moltype.reserve(numAtomsPerMoltype.size());
+    for (size_t mt = 0; mt < numAtomsPerMoltype.size(); mt++)
+    {
+        gmx_moltype_t& moltype = mtop->moltype.emplace_back();
+        init_t_atoms(&moltype.atoms, numAtomsPerMoltype[mt], FALSE);
+        for (int a = 0; a < numAtomsPerMoltype[mt]; a++)
+        {
+            const std::string atomName = formatString("A%d", a);
+            moltype.atoms.atomname[a]  = put_symtab(&mtop->symtab, atomName.c_str());
+            moltype.atoms.atom[a].m    = 1 + a + 10 * mt;
+            const int residue = (a * numResiduesPerMoltype[mt]) / numAtomsPerMoltype[mt];
+            const std::string resName = formatString("R%zu", mt);
+            t_atoms_set_resinfo(&moltype.atoms, a, &mtop->symtab, resName.c_str(), residue + 1,
+                                ' ', 0, ' ');
+        }
+        moltype.atoms.nres = numResiduesPerMoltype[mt];
+    }
+
+    mtop->natoms = 0;
+    for (size_t mb = 0; mb < molblockTypes.size(); mb++)
+    {
+        gmx_molblock_t& molblock = mtop->molblock.emplace_back();
+        molblock.type            = molblockTypes[mb];
+        molblock.nmol            = molblockNmol[mb];
+        mtop->natoms += molblock.nmol * numAtomsPerMoltype[molblock.type];
+    }
+    mtop->finalize();
+}
+
+TEST(MtopTest, GlobalAtomViewMatchesAtomRange)
+{
+    gmx_mtop_t mtop;
+    createManyBlockTopology(&mtop, { 2, 0, 1, 2, 0, 2, 1, 0, 2 },
+                            { 1, 50, 3, 2, 1, 17, 1, 200, 4 });
+    GlobalAtomView atoms(mtop);
+    ASSERT_EQ(atoms.size(), mtop.natoms);
+
+    int count = 0;
+    for (const AtomProxy atomP : AtomRange(mtop))
+    {
+        const int i = atomP.globalAtomNumber();
+        SCOPED_TRACE(formatString("Checking atom %d", i));
+        EXPECT_EQ(atoms.atom(i).m, atomP.atom().m);
+        EXPECT_STREQ(atoms.atomName(i), atomP.atomName());
+        EXPECT_STREQ(atoms.residueName(i), atomP.residueName());
+        EXPECT_EQ(atoms.residueNumber(i), atomP.residueNumber());
+        count++;
+    }
+    EXPECT_EQ(count, mtop.natoms);
+}
+
+//! Checks that the molblock of every atom is found for any starting block
+void checkMolblockLookup(const gmx_mtop_t& mtop)
+{
+    const int numBlocks = gmx::ssize(mtop.molblock);
+
+    for (int mb = 0; mb < numBlocks; mb++)
+    {
+        const MoleculeBlockIndices& indices = mtop.moleculeBlockIndices[mb];
+        for (int i = indices.globalAtomStart; i < indices.globalAtomEnd; i++)
+        {
+            SCOPED_TRACE(formatString("Checking atom %d", i));
+            const int moleculeIndex = (i - indices.globalAtomStart) / indices.numAtomsPerMolecule;
+            const int atomIndex =
+                    i - indices.globalAtomStart - moleculeIndex * indices.numAtomsPerMolecule;
+            for (int startBlock = 0; startBlock < numBlocks; startBlock++)
+            {
+                int moleculeBlock = startBlock;
+                int foundMoleculeIndex;
+                int atomIndexInMolecule;
+                mtopGetMolblockIndex(&mtop, i, &moleculeBlock, &foundMoleculeIndex,
+                                     &atomIndexInMolecule);
+                EXPECT_EQ(moleculeBlock, mb);
+                EXPECT_EQ(foundMoleculeIndex, moleculeIndex);
+                EXPECT_EQ(atomIndexInMolecule, atomIndex);
+            }
+            EXPECT_EQ(GlobalAtomView(mtop).moleculeIndex(i),
+                      indices.moleculeIndexStart + moleculeIndex);
+        }
+    }
+}
+
+TEST(MtopTest, MolblockLookupWorksWithAnyStartingBlock)
+{
+    gmx_mtop_t mtop;
+    createManyBlockTopology(&mtop, { 2, 0, 1, 1, 2, 0, 2, 1, 0, 2 },
+                            { 1, 50, 3, 0, 2, 1, 17, 1, 200, 4 });
+    checkMolblockLookup(mtop);
+}
+
+TEST(MtopTest, MolblockLookupWorksWithManySmallBlocksInOneBucket)
+{
+    // One large block followed by many small and empty blocks,
+    // which end up in the same bucket of the lookup table
+    std::vector<int> molblockTypes = { 2 };
+    std::vector<int> molblockNmol  = { 300 };
+    for (int mb = 0; mb < 60; mb++)
+    {
+        molblockTypes.push_back(mb % 2);
+        molblockNmol.push_back(mb % 3 == 2 ? 0 : 1);
+    }
+    molblockTypes.push_back(1);
+    molblockNmol.push_back(5);
+    gmx_mtop_t mtop;
+    createManyBlockTopology(&mtop, molblockTypes, molblockNmol);
+    checkMolblockLookup(mtop);
+}
+
 TEST(MtopTest, CanFindResidueStartAndEndAtoms)
 {
     gmx_mtop_t mtop;
@@ -49,6 +49,7 @@
 #include "gromacs/utility/arrayref.h"
 #include "gromacs/utility/exceptions.h"
 #include "gromacs/utility/inmemoryserializer.h"
+#include "gromacs/utility/smalloc.h"
 #include "gromacs/utility/strconvert.h"
 #include "gromacs/utility/stringutil.h"
 #include "gromacs/utility/textreader.h"
@@ -568,7 +569,7 @@ TEST_F(LegacySymtabTest, TryToAddDuplicates)
 
 TEST_F(LegacySymtabTest, AddLargeNumberOfEntries)
 {
-    int                 numStringsToAdd = 7; // Larger than c_maxBufSize limit for size of symbuf.
+    int                 numStringsToAdd = 7; // More than fit in the first symbuf.
     std::vector<char**> symbolsAdded;
     symbolsAdded.reserve(numStringsToAdd);
     for (int i = 0; i < numStringsToAdd; ++i)
@@ -597,7 +598,7 @@ TEST_F(LegacySymtabTest, AddLargeNumberOfEntries)
 
 TEST_F(LegacySymtabTest, NoDuplicatesInLargeTable)
 {
-    int halfOfStringsToAdd   = 7; // Larger than c_maxBufSize limit for size of symbuf.
+    int halfOfStringsToAdd   = 7; // More than fit in the first symbuf.
     int totalNumStringsToAdd = 2 * halfOfStringsToAdd;
     std::vector<char**> symbolsAdded;
     symbolsAdded.reserve(halfOfStringsToAdd);
@@ -631,6 +632,47 @@ TEST_F(LegacySymtabTest, NoDuplicatesInLargeTable)
     dumpSymtab();
 }
 
+TEST_F(LegacySymtabTest, HandlesAndIndicesStayValidForManyEntries)
+{
+    int                 numStringsToAdd = 1000;
+    std::vector<char**> symbolsAdded;
+    symbolsAdded.reserve(numStringsToAdd);
+    for (int i = 0; i < numStringsToAdd; ++i)
+    {
+        symbolsAdded.push_back(put_symtab(symtab(), formatString("name%d", i).c_str()));
+    }
+    ASSERT_EQ(numStringsToAdd, symtab()->nr);
+
+    for (int i = numStringsToAdd - 1; i >= 0; --i)
+    {
+        EXPECT_EQ(symbolsAdded[i], put_symtab(symtab(), formatString(" name%d ", i).c_str()));
+        EXPECT_EQ(i, lookup_symtab(symtab(), symbolsAdded[i]));
+        EXPECT_EQ(symbolsAdded[i], get_symtab_handle(symtab(), i));
+        EXPECT_STREQ(formatString("name%d", i).c_str(), *symbolsAdded[i]);
+    }
+    ASSERT_EQ(numStringsToAdd, symtab()->nr);
+}
+
+TEST_F(LegacySymtabTest, DuplicatedTableFindsExistingEntries)
+{
+    auto fooSymbol = put_symtab(symtab(), "Foo");
+    put_symtab(symtab(), "Bar");
+
+    t_symtab* copy = duplicateSymtab(symtab());
+    ASSERT_EQ(2, copy->nr);
+    auto copiedFooSymbol = put_symtab(copy, "Foo");
+    EXPECT_NE(fooSymbol, copiedFooSymbol);
+    EXPECT_EQ(copiedFooSymbol, get_symtab_handle(copy, 0));
+    EXPECT_EQ(2, copy->nr);
+    auto bazSymbol = put_symtab(copy, "Baz");
+    EXPECT_EQ(3, copy->nr);
+    EXPECT_EQ(2, lookup_symtab(copy, bazSymbol));
+    EXPECT_EQ(2, symtab()->nr);
+
+    done_symtab(copy);
+    sfree(copy);
+}
+
 } // namespace
 
 } // namespace test
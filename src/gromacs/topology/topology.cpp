@@ -185,6 +185,34 @@ void gmx_mtop_t::buildMolblockIndices()
         indices.moleculeIndexStart = moleculeIndexStart;
         moleculeIndexStart += molb.nmol;
     }
+
+    /* Set up the lookup table with a few buckets per molblock, so looking up
+     * the molblock of an atom usually only needs to check one molblock.
+     */
+    constexpr int c_numBucketsPerBlock = 8;
+    const int     numAtoms             = atomIndex;
+    const int     maxNumBuckets        = c_numBucketsPerBlock * gmx::ssize(molblock);
+    moleculeBlockLookupShift           = 0;
+    while ((numAtoms >> moleculeBlockLookupShift) >= maxNumBuckets && maxNumBuckets > 0)
+    {
+        moleculeBlockLookupShift++;
+    }
+    moleculeBlockLookup.clear();
+    if (!molblock.empty())
+    {
+        moleculeBlockLookup.resize((numAtoms >> moleculeBlockLookupShift) + 1);
+        int mb = 0;
+        for (size_t bucket = 0; bucket < moleculeBlockLookup.size(); bucket++)
+        {
+            const int firstAtomInBucket = bucket << moleculeBlockLookupShift;
+            while (mb + 1 < gmx::ssize(molblock)
+                   && firstAtomInBucket >= moleculeBlockIndices[mb].globalAtomEnd)
+            {
+                mb++;
+            }
+            moleculeBlockLookup[bucket] = mb;
+        }
+    }
 }
 
 void done_top(t_topology* top)
@@ -209,6 +209,16 @@ struct gmx_mtop_t //NOLINT(clang-analyzer-optin.performance.Padding)
     /* Derived data below */
     //! Indices for each molblock entry for fast lookup of atom properties
     std::vector<MoleculeBlockIndices> moleculeBlockIndices;
+    /*! \brief The molblock index of the first atom of each bucket of global atoms
+     *
+     * Bucket b contains the global atoms with index >> moleculeBlockLookupShift
+     * equal to b. The molblock of an atom is one of the molblocks from the entry
+     * of its bucket up to the entry of the next bucket. There are a few buckets
+     * per molblock, so this range usually contains a single molblock.
+     */
+    std::vector<int> moleculeBlockLookup;
+    //! The log2 of the number of atoms per bucket in moleculeBlockLookup
+    int moleculeBlockLookupShift = 0;
 
 private:
     //! Build the molblock indices
@@ -73,6 +73,7 @@
 #include "gromacs/trajectoryanalysis/analysissettings.h"
 #include "gromacs/trajectoryanalysis/topologyinformation.h"
 #include "gromacs/utility/exceptions.h"
+#include "gromacs/utility/gmxomp.h"
 #include "gromacs/utility/stringutil.h"
 
 namespace gmx
@@ -91,6 +92,11 @@ namespace
  * Actual analysis module
  */
 
+//! Number of pair distances that are collected before binning them together.
+const int c_pairBatchSize = 256;
+//! Number of selection positions searched together by a thread.
+const int c_positionBlockSize = 64;
+
 //! Normalization for the computed distribution.
 enum class Normalization : int
 {
@@ -155,11 +161,12 @@ private:
     SelectionList sel_;
 
     /*! \brief
-     * Raw pairwise distance data from which the RDF is computed.
+     * Binned pairwise distance data from which the RDF is computed.
      *
-     * There is a data set for each selection in `sel_`, with a single
-     * column.  Each point set will contain a single pairwise distance
-     * that contributes to the RDF.
+     * There is a data set for each selection in `sel_`, with two columns.
+     * Each point set contains the center of a histogram bin and the
+     * number of pairwise distances in that bin in the first and second
+     * column, respectively.
      */
     AnalysisData pairDist_;
     /*! \brief
@@ -172,13 +179,13 @@ private:
      */
     AnalysisData normFactors_;
     /*! \brief
-     * Histogram module that computes the actual RDF from `pairDist_`.
+     * Weighted histogram module that computes the actual RDF from `pairDist_`.
      *
      * The per-frame histograms are raw pair counts in each bin;
      * the averager is normalized by the average number of reference
      * positions (average of the first column of `normFactors_`).
      */
-    AnalysisDataSimpleHistogramModulePointer pairCounts_;
+    AnalysisDataWeightedHistogramModulePointer pairCounts_;
     /*! \brief
      * Average normalization factors.
      */
@@ -207,7 +214,7 @@ private:
 
 Rdf::Rdf() :
     surface_(SurfaceType::None),
-    pairCounts_(new AnalysisDataSimpleHistogramModule()),
+    pairCounts_(new AnalysisDataWeightedHistogramModule()),
     normAve_(new AnalysisDataAverageModule()),
     localTop_(nullptr),
     binwidth_(0.002),
@@ -356,7 +363,7 @@ void Rdf::initAnalysis(const TrajectoryAnalysisSettings& settings, const Topolog
     pairDist_.setDataSetCount(sel_.size());
     for (size_t i = 0; i < sel_.size(); ++i)
     {
-        pairDist_.setColumnCount(i, 1);
+        pairDist_.setColumnCount(i, 2);
     }
     plotSettings_ = settings.plotSettings();
     nb_.setXYMode(bXY_);
@@ -432,6 +439,55 @@ void Rdf::initAfterFirstFrame(const TrajectoryAnalysisSettings& settings, const
     pairCounts_->init(histogramFromRange(0.0, rmax_).binWidth(binwidth_ / 2.0));
 }
 
+/*! \brief
+ * Thread-local memory for use within a single-frame calculation.
+ */
+struct RdfThreadData
+{
+    /*! \brief
+     * Minimum distance to each surface group.
+     *
+     * One entry for each group (residue/molecule, per -surf) in the
+     * reference selection.
+     * This is needed to support neighborhood searching, which may not
+     * return the reference positions in order: for each position, we need
+     * to search through all the reference positions and update this array
+     * to find the minimum distance to each surface group, and then compute
+     * the RDF from these numbers.
+     */
+    std::vector<real> surfaceDist2;
+    //! Squared pair distances that have not yet been binned.
+    std::vector<real> pairDist2;
+    //! Pair counts in each histogram bin.
+    std::vector<int64_t> pairCounts;
+
+    /*! \brief
+     * Bins the distances in `pairDist2` into `pairCounts`.
+     *
+     * The binning matches AnalysisHistogramSettings::findBin(), distances
+     * that fall outside the histogram are ignored.
+     */
+    void binPairDistances(const AnalysisHistogramSettings& settings)
+    {
+        const real firstEdge       = settings.firstEdge();
+        const real inverseBinWidth = 1.0 / settings.binWidth();
+        const int  binCount        = settings.binCount();
+        for (const real r2 : pairDist2)
+        {
+            const real r = std::sqrt(r2);
+            if (r >= firstEdge)
+            {
+                const int bin = static_cast<int>((r - firstEdge) * inverseBinWidth);
+                if (bin < binCount)
+                {
+                    pairCounts[bin]++;
+                }
+            }
+        }
+        pairDist2.clear();
+    }
+};
+
 /*! \brief
  * Temporary memory for use within a single-frame calculation.
  */
@@ -446,42 +502,42 @@ public:
     RdfModuleData(TrajectoryAnalysisModule*          module,
                   const AnalysisDataParallelOptions& opt,
                   const SelectionCollection&         selections,
-                  int                                surfaceGroupCount) :
+                  int                                surfaceGroupCount,
+                  int                                binCount) :
         TrajectoryAnalysisModuleData(module, opt, selections)
     {
-        surfaceDist2_.resize(surfaceGroupCount);
+        threadData_.resize(gmx_omp_get_max_threads());
+        for (RdfThreadData& threadData : threadData_)
+        {
+            threadData.surfaceDist2.resize(surfaceGroupCount);
+            threadData.pairDist2.reserve(c_pairBatchSize);
+            threadData.pairCounts.resize(binCount);
+        }
     }
 
     void finish() override { finishDataHandles(); }
 
-    /*! \brief
-     * Minimum distance to each surface group.
-     *
-     * One entry for each group (residue/molecule, per -surf) in the
-     * reference selection.
-     * This is needed to support neighborhood searching, which may not
-     * return the reference positions in order: for each position, we need
-     * to search through all the reference positions and update this array
-     * to find the minimum distance to each surface group, and then compute
-     * the RDF from these numbers.
-     */
-    std::vector<real> surfaceDist2_;
+    //! Thread-local data, one entry for each OpenMP thread.
+    std::vector<RdfThreadData> threadData_;
 };
 
 TrajectoryAnalysisModuleDataPointer Rdf::startFrames(const AnalysisDataParallelOptions& opt,
                                                      const SelectionCollection&         selections)
 {
-    return TrajectoryAnalysisModuleDataPointer(new RdfModuleData(this, opt, selections, surfaceGroupCount_));
+    return TrajectoryAnalysisModuleDataPointer(new RdfModuleData(
+            this, opt, selections, surfaceGroupCount_, pairCounts_->settings().binCount()));
 }
 
 void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAnalysisModuleData* pdata)
 {
-    AnalysisDataHandle   dh        = pdata->dataHandle(pairDist_);
-    AnalysisDataHandle   nh        = pdata->dataHandle(normFactors_);
-    const Selection&     refSel    = TrajectoryAnalysisModuleData::parallelSelection(refSel_);
-    const SelectionList& sel       = TrajectoryAnalysisModuleData::parallelSelections(sel_);
-    RdfModuleData&       frameData = *static_cast<RdfModuleData*>(pdata);
-    const bool           bSurface  = !frameData.surfaceDist2_.empty();
+    AnalysisDataHandle   dh         = pdata->dataHandle(pairDist_);
+    AnalysisDataHandle   nh         = pdata->dataHandle(normFactors_);
+    const Selection&     refSel     = TrajectoryAnalysisModuleData::parallelSelection(refSel_);
+    const SelectionList& sel        = TrajectoryAnalysisModuleData::parallelSelections(sel_);
+    RdfModuleData&       frameData  = *static_cast<RdfModuleData*>(pdata);
+    const bool           bSurface   = (surface_ != SurfaceType::None);
+    const int            numThreads = ssize(frameData.threadData_);
+    const AnalysisHistogramSettings& histogramSettings = pairCounts_->settings();
 
     matrix boxForVolume;
     copy_mat(fr.box, boxForVolume);
@@ -531,62 +587,106 @@ void Rdf::analyzeFrame(int frnr, const t_trxframe& fr, t_pbc* pbc, TrajectoryAna
     {
         dh.selectDataSet(g);
 
-        if (bSurface)
+        // The positions of the selection are distributed over the threads
+        // in blocks, and each thread accumulates its own histogram.
+        const Selection& selection  = sel[g];
+        const int        posCount   = selection.posCount();
+        const int        blockCount = (posCount + c_positionBlockSize - 1) / c_positionBlockSize;
+#pragma omp parallel for num_threads(numThreads) schedule(dynamic)
+        for (int block = 0; block < blockCount; ++block)
         {
-            // Special loop for surface calculation, where a separate neighbor
-            // search is done for each position in the selection, and the
-            // nearest position from each surface group is tracked.
-            std::vector<real>& surfaceDist2 = frameData.surfaceDist2_;
-            for (int i = 0; i < sel[g].posCount(); ++i)
+            try
             {
-                std::fill(surfaceDist2.begin(), surfaceDist2.end(), std::numeric_limits<real>::max());
-                AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(sel[g].position(i));
-                AnalysisNeighborhoodPair       pair;
-                while (pairSearch.findNextPair(&pair))
+                RdfThreadData& threadData = frameData.threadData_[gmx_omp_get_thread_num()];
+                const int      begin      = block * c_positionBlockSize;
+                const int      end        = std::min(begin + c_positionBlockSize, posCount);
+
+                if (bSurface)
                 {
-                    const real r2    = pair.distance2();
-                    const int  refId = refSel.position(pair.refIndex()).mappedId();
-                    if (r2 < surfaceDist2[refId])
+                    // Special loop for surface calculation, where a separate neighbor
+                    // search is done for each position in the selection, and the
+                    // nearest position from each surface group is tracked.
+                    std::vector<real>& surfaceDist2 = threadData.surfaceDist2;
+                    for (int i = begin; i < end; ++i)
                     {
-                        surfaceDist2[refId] = r2;
+                        std::fill(surfaceDist2.begin(), surfaceDist2.end(),
+                                  std::numeric_limits<real>::max());
+                        AnalysisNeighborhoodPairSearch pairSearch =
+                                nbsearch.startPairSearch(selection.position(i));
+                        AnalysisNeighborhoodPair pair;
+                        while (pairSearch.findNextPair(&pair))
+                        {
+                            const real r2    = pair.distance2();
+                            const int  refId = refSel.position(pair.refIndex()).mappedId();
+                            if (r2 < surfaceDist2[refId])
+                            {
+                                surfaceDist2[refId] = r2;
+                            }
+                        }
+                        // Accumulate the RDF from the distances to the surface.
+                        for (const real r2 : surfaceDist2)
+                        {
+                            // Here, we need to check for rmax, since the value might
+                            // be above the cutoff if no points were close to some
+                            // surface positions.
+                            if (r2 > cut2_ && r2 <= rmax2_)
+                            {
+                                threadData.pairDist2.push_back(r2);
+                            }
+                        }
+                        threadData.binPairDistances(histogramSettings);
                     }
                 }
-                // Accumulate the RDF from the distances to the surface.
-                for (size_t i = 0; i < surfaceDist2.size(); ++i)
+                else
                 {
-                    const real r2 = surfaceDist2[i];
-                    // Here, we need to check for rmax, since the value might
-                    // be above the cutoff if no points were close to some
-                    // surface positions.
-                    if (r2 > cut2_ && r2 <= rmax2_)
+                    // Standard neighborhood search over all pairs within the cutoff
+                    // for the -surf no case.
+                    const int                     count = end - begin;
+                    AnalysisNeighborhoodPositions positions(selection.coordinates().data() + begin, count);
+                    if (selection.hasOnlyAtoms())
+                    {
+                        positions.exclusionIds(selection.atomIndices().subArray(begin, count));
+                    }
+                    AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(positions);
+                    AnalysisNeighborhoodPair       pair;
+                    while (pairSearch.findNextPair(&pair))
                     {
-                        dh.setPoint(0, std::sqrt(r2));
-                        dh.finishPointSet();
+                        const real r2 = pair.distance2();
+                        if (r2 > cut2_)
+                        {
+                            threadData.pairDist2.push_back(r2);
+                            if (ssize(threadData.pairDist2) == c_pairBatchSize)
+                            {
+                                threadData.binPairDistances(histogramSettings);
+                            }
+                        }
                     }
+                    threadData.binPairDistances(histogramSettings);
                 }
             }
+            GMX_CATCH_ALL_AND_EXIT_WITH_FATAL_ERROR
         }
-        else
+
+        // Reduce the thread-local histograms and pass the non-empty bins on.
+        for (int bin = 0; bin < histogramSettings.binCount(); ++bin)
         {
-            // Standard neighborhood search over all pairs within the cutoff
-            // for the -surf no case.
-            AnalysisNeighborhoodPairSearch pairSearch = nbsearch.startPairSearch(sel[g]);
-            AnalysisNeighborhoodPair       pair;
-            while (pairSearch.findNextPair(&pair))
+            int64_t count = 0;
+            for (RdfThreadData& threadData : frameData.threadData_)
             {
-                const real r2 = pair.distance2();
-                if (r2 > cut2_)
-                {
-                    // TODO: Consider whether the histogramming could be done with
-                    // less overhead (after first measuring the overhead).
-                    dh.setPoint(0, std::sqrt(r2));
-                    dh.finishPointSet();
-                }
+                count += threadData.pairCounts[bin];
+                threadData.pairCounts[bin] = 0;
+            }
+            if (count > 0)
+            {
+                dh.setPoint(0, histogramSettings.firstEdge()
+                                       + (bin + 0.5) * histogramSettings.binWidth());
+                dh.setPoint(1, count);
+                dh.finishPointSet();
             }
         }
         // Normalization factor for the number density (only used without
         // -surf, but does not hurt to populate otherwise).
-        nh.setPoint(g + 1, sel[g].posCount() * inverseVolume);
+        nh.setPoint(g + 1, posCount * inverseVolume);
     }
     dh.finishFrame();
     nh.finishFrame();
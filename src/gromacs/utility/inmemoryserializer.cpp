@@ -170,6 +170,11 @@ std::vector<char> InMemorySerializer::finishAndGetBuffer()
     return std::move(impl_->buffer_);
 }
 
+EndianSwapBehavior InMemorySerializer::endianSwapBehavior() const
+{
+    return impl_->endianSwapBehavior_;
+}
+
 void InMemorySerializer::doBool(bool* value)
 {
     impl_->doValue(*value);
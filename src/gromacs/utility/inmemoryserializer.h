@@ -76,6 +76,9 @@ public:
 
     std::vector<char> finishAndGetBuffer();
 
+    //! Returns the endian swap behavior resolved for this host, either Swap or DoNotSwap
+    EndianSwapBehavior endianSwapBehavior() const;
+
     // From ISerializer
     bool reading() const override { return false; }
     void doBool(bool* value) override;
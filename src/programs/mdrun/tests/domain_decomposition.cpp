@@ -46,9 +46,15 @@
 
 #include <gtest/gtest.h>
 
+#include "gromacs/topology/ifunc.h"
+
 #include "testutils/cmdlinetest.h"
+#include "testutils/mpitest.h"
+#include "testutils/setenv.h"
+#include "testutils/simulationdatabase.h"
 
 #include "moduletest.h"
+#include "simulatorcomparison.h"
 
 namespace
 {
@@ -74,4 +80,82 @@ TEST_F(DomainDecompositionSpecialCasesTest, AnEmptyDomainWorks)
     ASSERT_EQ(0, runner_.callMdrun());
 }
 
+/*! \brief Checks that overlapping the coordinate halo communication with
+ * the local non-bonded work gives the same results as the blocking
+ * communication selected by GMX_DD_NO_X_OVERLAP
+ */
+TEST_F(DomainDecompositionSpecialCasesTest, CoordinateHaloOverlapMatchesBlockingCommunication)
+{
+    using namespace gmx::test;
+
+    const std::string simulationName    = "tip3p5";
+    const int         numRanksAvailable = getNumberOfTestMpiRanks();
+    if (numRanksAvailable < 2 || !isNumberOfPpRanksSupported(simulationName, numRanksAvailable))
+    {
+        fprintf(stdout, "Test system '%s' needs domain decomposition, cannot run with %d ranks.\n",
+                simulationName.c_str(), numRanksAvailable);
+        return;
+    }
+
+    // The overlap is used at the steps without neighbor search
+    const auto mdpFieldValues = prepareMdpFieldValues(simulationName.c_str(), "md", "no", "no");
+
+    const auto overlapTrajectoryFileName  = fileManager_.getTemporaryFilePath("overlap.trr");
+    const auto overlapEdrFileName         = fileManager_.getTemporaryFilePath("overlap.edr");
+    const auto blockingTrajectoryFileName = fileManager_.getTemporaryFilePath("blocking.trr");
+    const auto blockingEdrFileName        = fileManager_.getTemporaryFilePath("blocking.edr");
+
+    runner_.tprFileName_ = fileManager_.getTemporaryFilePath("sim.tpr");
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    runGrompp(&runner_);
+
+    const char* environmentVariable       = "GMX_DD_NO_X_OVERLAP";
+    const char* environmentVariableBackup = getenv(environmentVariable);
+    gmxUnsetenv(environmentVariable);
+
+    runner_.fullPrecisionTrajectoryFileName_ = overlapTrajectoryFileName;
+    runner_.edrFileName_                     = overlapEdrFileName;
+    runMdrun(&runner_);
+
+    const int overWriteEnvironmentVariable = 1;
+    gmxSetenv(environmentVariable, "1", overWriteEnvironmentVariable);
+    runner_.fullPrecisionTrajectoryFileName_ = blockingTrajectoryFileName;
+    runner_.edrFileName_                     = blockingEdrFileName;
+    runMdrun(&runner_);
+
+    // Reset or unset the environment variable to leave further tests undisturbed
+    if (environmentVariableBackup != nullptr)
+    {
+        gmxSetenv(environmentVariable, environmentVariableBackup, overWriteEnvironmentVariable);
+    }
+    else
+    {
+        gmxUnsetenv(environmentVariable);
+    }
+
+    // Only the order of the communication differs, so the results should match closely
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_EPOT].longname,
+              relativeToleranceAsPrecisionDependentUlp(10.0, 100, 80) },
+            { interaction_function[F_EKIN].longname,
+              relativeToleranceAsPrecisionDependentUlp(10.0, 100, 80) },
+    } };
+    compareEnergies(overlapEdrFileName, blockingEdrFileName, energyTermsToCompare);
+
+    const TrajectoryFrameMatchSettings trajectoryMatchSettings = {
+        true,
+        true,
+        true,
+        ComparisonConditions::MustCompare,
+        ComparisonConditions::MustCompare,
+        ComparisonConditions::MustCompare
+    };
+    const TrajectoryTolerances trajectoryTolerances =
+            TrajectoryComparison::s_defaultTrajectoryTolerances;
+    TrajectoryComparison trajectoryComparison{ trajectoryMatchSettings, trajectoryTolerances };
+    compareTrajectories(overlapTrajectoryFileName, blockingTrajectoryFileName,
+                        trajectoryComparison);
+}
+
 } // namespace
@@ -0,0 +1,220 @@
+/*
+ * This file is part of the GROMACS molecular simulation package.
+ *
+ * Copyright (c) 2020, by the GROMACS development team, led by
+ * Mark Abraham, David van der Spoel, Berk Hess, and Erik Lindahl,
+ * and including many others, as listed in the AUTHORS file in the
+ * top-level source directory and at http://www.gromacs.org.
+ *
+ * GROMACS is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * as published by the Free Software Foundation; either version 2.1
+ * of the License, or (at your option) any later version.
+ *
+ * GROMACS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GROMACS; if not, see
+ * http://www.gnu.org/licenses, or write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA.
+ *
+ * If you want to redistribute modifications to GROMACS, please
+ * consider that scientific software is very special. Version
+ * control is crucial - bugs must be traceable. We will be happy to
+ * consider code for inclusion in the official distribution, but
+ * derived work must not be called official GROMACS. Details are found
+ * in the README & COPYING files - if they are missing, get the
+ * official version at http://www.gromacs.org.
+ *
+ * To help us fund GROMACS development, we humbly ask that you cite
+ * the research papers on the package. Check out http://www.gromacs.org.
+ */
+
+/*! \internal \file
+ * \brief
+ * Tests that multiple time stepping produces the same energies and
+ * forces at output steps as a normal force evaluation, and that the
+ * dynamics stays close to that without multiple time stepping.
+ *
+ * A simulation with multiple time stepping is rerun without it.
+ * At the energy and force output steps all forces, including the slow
+ * ones, should be computed, so both runs should agree.
+ *
+ * \ingroup module_mdrun_integration_tests
+ */
+#include "gmxpre.h"
+
+#include <string>
+#include <tuple>
+
+#include <gtest/gtest.h>
+
+#include "gromacs/topology/ifunc.h"
+#include "gromacs/utility/stringutil.h"
+
+#include "testutils/mpitest.h"
+#include "testutils/simulationdatabase.h"
+
+#include "moduletest.h"
+#include "simulatorcomparison.h"
+
+namespace gmx
+{
+namespace test
+{
+namespace
+{
+
+/*! \brief Test fixture for multiple time stepping
+ *
+ * The parameters are the simulation name and the MTS factor.
+ */
+class MultipleTimeSteppingTest :
+    public MdrunTestFixture,
+    public ::testing::WithParamInterface<std::tuple<std::string, int>>
+{
+};
+
+TEST_P(MultipleTimeSteppingTest, EnergiesAndForcesMatchRerun)
+{
+    const auto& params         = GetParam();
+    const auto& simulationName = std::get<0>(params);
+    const int   mtsFactor      = std::get<1>(params);
+
+    SCOPED_TRACE(formatString("Comparing simulation '%s' with MTS factor %d to a rerun without MTS",
+                              simulationName.c_str(), mtsFactor));
+
+    const int numRanksAvailable = getNumberOfTestMpiRanks();
+    if (!isNumberOfPpRanksSupported(simulationName, numRanksAvailable))
+    {
+        fprintf(stdout,
+                "Test system '%s' cannot run with %d ranks.\n"
+                "The supported numbers are: %s\n",
+                simulationName.c_str(), numRanksAvailable,
+                reportNumbersOfPpRanksSupported(simulationName).c_str());
+        return;
+    }
+
+    auto mdpFieldValues = prepareMdpFieldValues(simulationName.c_str(), "md", "no", "no");
+    mdpFieldValues["coulombtype"]   = "PME";
+    mdpFieldValues["nstcalcenergy"] = "4";
+
+    const auto mtsTprFileName          = fileManager_.getTemporaryFilePath("mts.tpr");
+    const auto mtsTrajectoryFileName   = fileManager_.getTemporaryFilePath("mts.trr");
+    const auto mtsEdrFileName          = fileManager_.getTemporaryFilePath("mts.edr");
+    const auto normalTprFileName       = fileManager_.getTemporaryFilePath("normal.tpr");
+    const auto rerunTrajectoryFileName = fileManager_.getTemporaryFilePath("rerun.trr");
+    const auto rerunEdrFileName        = fileManager_.getTemporaryFilePath("rerun.edr");
+
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+
+    // Run grompp for the normal setup, used for the rerun
+    runner_.tprFileName_ = normalTprFileName;
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    runGrompp(&runner_);
+
+    // Run grompp with multiple time stepping
+    mdpFieldValues["other"] += formatString("\nmts = yes\nmts-factor = %d", mtsFactor);
+    runner_.tprFileName_ = mtsTprFileName;
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    runGrompp(&runner_);
+
+    // Do the MTS simulation
+    runner_.fullPrecisionTrajectoryFileName_ = mtsTrajectoryFileName;
+    runner_.edrFileName_                     = mtsEdrFileName;
+    runMdrun(&runner_);
+
+    // Rerun the MTS trajectory without MTS
+    runner_.tprFileName_                     = normalTprFileName;
+    runner_.fullPrecisionTrajectoryFileName_ = rerunTrajectoryFileName;
+    runner_.edrFileName_                     = rerunEdrFileName;
+    runMdrun(&runner_, { SimulationOptionTuple("-rerun", mtsTrajectoryFileName) });
+
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_EPOT].longname,
+              relativeToleranceAsPrecisionDependentUlp(10.0, 24, 40) },
+            { interaction_function[F_COUL_RECIP].longname,
+              relativeToleranceAsPrecisionDependentUlp(10.0, 24, 40) },
+    } };
+    compareEnergies(mtsEdrFileName, rerunEdrFileName, energyTermsToCompare);
+
+    // Compare box, positions and forces, velocities are not written in reruns
+    const TrajectoryFrameMatchSettings trajectoryMatchSettings = {
+        true,
+        true,
+        true,
+        ComparisonConditions::MustCompare,
+        ComparisonConditions::NoComparison,
+        ComparisonConditions::MustCompare
+    };
+    const TrajectoryTolerances trajectoryTolerances =
+            TrajectoryComparison::s_defaultTrajectoryTolerances;
+    TrajectoryComparison trajectoryComparison{ trajectoryMatchSettings, trajectoryTolerances };
+    compareTrajectories(mtsTrajectoryFileName, rerunTrajectoryFileName, trajectoryComparison);
+}
+
+TEST_P(MultipleTimeSteppingTest, DynamicsIsCloseToNormalRun)
+{
+    const auto& params         = GetParam();
+    const auto& simulationName = std::get<0>(params);
+    const int   mtsFactor      = std::get<1>(params);
+
+    SCOPED_TRACE(formatString("Comparing simulation '%s' with MTS factor %d to a normal run",
+                              simulationName.c_str(), mtsFactor));
+
+    const int numRanksAvailable = getNumberOfTestMpiRanks();
+    if (!isNumberOfPpRanksSupported(simulationName, numRanksAvailable))
+    {
+        fprintf(stdout,
+                "Test system '%s' cannot run with %d ranks.\n"
+                "The supported numbers are: %s\n",
+                simulationName.c_str(), numRanksAvailable,
+                reportNumbersOfPpRanksSupported(simulationName).c_str());
+        return;
+    }
+
+    auto mdpFieldValues = prepareMdpFieldValues(simulationName.c_str(), "md", "no", "no");
+    mdpFieldValues["coulombtype"]   = "PME";
+    mdpFieldValues["nstcalcenergy"] = "4";
+
+    const auto normalEdrFileName = fileManager_.getTemporaryFilePath("normal.edr");
+    const auto mtsEdrFileName    = fileManager_.getTemporaryFilePath("mts.edr");
+
+    runner_.useTopGroAndNdxFromDatabase(simulationName);
+
+    // Do the normal simulation
+    runner_.tprFileName_ = fileManager_.getTemporaryFilePath("normal.tpr");
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    runGrompp(&runner_);
+    runner_.edrFileName_ = normalEdrFileName;
+    runMdrun(&runner_);
+
+    // Do the simulation with multiple time stepping
+    mdpFieldValues["other"] += formatString("\nmts = yes\nmts-factor = %d", mtsFactor);
+    runner_.tprFileName_ = fileManager_.getTemporaryFilePath("mts.tpr");
+    runner_.useStringAsMdpFile(prepareMdpFileContents(mdpFieldValues));
+    runGrompp(&runner_);
+    runner_.edrFileName_ = mtsEdrFileName;
+    runMdrun(&runner_);
+
+    /* Over a few steps MTS only causes small deviations in the total energy,
+     * up to 2.5% for these systems. Applying the slow forces without the MTS
+     * factor as weight causes deviations of 7% or more.
+     */
+    EnergyTermsToCompare energyTermsToCompare{ {
+            { interaction_function[F_ETOT].longname, relativeToleranceAsFloatingPoint(1.0, 0.04) },
+    } };
+    compareEnergies(normalEdrFileName, mtsEdrFileName, energyTermsToCompare);
+}
+
+INSTANTIATE_TEST_CASE_P(MtsWithPme,
+                        MultipleTimeSteppingTest,
+                        ::testing::Combine(::testing::Values("tip3p5", "alanine_vsite_vacuo"),
+                                           ::testing::Values(2, 4)));
+
+} // namespace
+} // namespace test
+} // namespace gmx